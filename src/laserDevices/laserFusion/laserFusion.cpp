@@ -0,0 +1,405 @@
+/*
+ * Copyright (C)2017  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include <yarp/os/Time.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Network.h>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+#include "laserFusion.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RAD2DEG 180/M_PI
+#define DEG2RAD M_PI/180
+
+YARP_LOG_COMPONENT(LASER_FUSION, "navigation.devices.laserFusion")
+#define DISPLAY_PERIOD 10.0
+
+void odometry_input::onRead(yarp::dev::OdometryData& odom)
+{
+    yarp::os::Stamp stamp;
+    double time = (getEnvelope(stamp) && stamp.isValid()) ? stamp.getTime() : yarp::os::Time::now();
+    m_history->push(time, odom.odom_x, odom.odom_y, odom.odom_theta);
+}
+
+laserFusion::laserFusion()
+{
+}
+
+laserFusion::~laserFusion()
+{
+    close();
+}
+
+bool laserFusion::open(yarp::os::Searchable& config)
+{
+    string cfg_temp = config.toString();
+    Property p; p.fromString(cfg_temp);
+
+    yCDebug(LASER_FUSION) << "laserFusion configuration: \n" << p.toString().c_str();
+
+    Bottle general_group = p.findGroup("LASERFUSION_GENERAL");
+    if (general_group.isNull())
+    {
+        yCError(LASER_FUSION) << "Missing LASERFUSION_GENERAL group!";
+        return false;
+    }
+    if (general_group.check("name")) { m_name = general_group.find("name").asString(); }
+    if (general_group.check("max_time_skew")) { m_max_time_skew = general_group.find("max_time_skew").asDouble(); }
+    double min_angle = general_group.check("min_angle", Value(-180.0)).asDouble();
+    double max_angle = general_group.check("max_angle", Value(180.0)).asDouble();
+    double resolution = general_group.check("resolution", Value(0.5)).asDouble();
+    double min_distance = general_group.check("min_distance", Value(0.0)).asDouble();
+    double max_distance = general_group.check("max_distance", Value(30.0)).asDouble();
+
+    Bottle* sources = general_group.find("sources").asList();
+    if (sources == nullptr || sources->size() == 0)
+    {
+        yCError(LASER_FUSION) << "Missing `sources` list in [LASERFUSION_GENERAL] group";
+        return false;
+    }
+
+    if (m_fusion.configure(min_angle, max_angle, resolution, min_distance, max_distance, sources->size()) == false)
+    {
+        yCError(LASER_FUSION) << "Invalid parameters of the fused scan";
+        return false;
+    }
+
+    Bottle motion_group = p.findGroup("MOTION_COMPENSATION");
+    if (motion_group.isNull() == false)
+    {
+        m_motion_compensation = motion_group.check("enable", Value(false)).asBool();
+        m_knots = motion_group.check("knots", Value(9)).asInt();
+        if (m_knots < 2) m_knots = 2;
+    }
+
+    for (size_t i = 0; i < sources->size(); i++)
+    {
+        std::unique_ptr<source_type> src(new source_type);
+        src->name = sources->get(i).asString();
+        Bottle source_group = p.findGroup(src->name);
+        if (source_group.isNull())
+        {
+            yCError(LASER_FUSION) << "Missing" << src->name << "group!";
+            return false;
+        }
+        if (source_group.check("laser_port") == false)
+        {
+            yCError(LASER_FUSION) << "Missing `laser_port` in [" << src->name << "] group";
+            return false;
+        }
+
+        Property options;
+        options.put("device", "Rangefinder2DClient");
+        options.put("local", m_name + "/" + src->name + ":i");
+        options.put("remote", source_group.find("laser_port").asString());
+        if (src->driver.open(options) == false)
+        {
+            yCError(LASER_FUSION) << "Unable to open the laser driver of" << src->name;
+            return false;
+        }
+        src->driver.view(src->iLaser);
+        if (src->iLaser == nullptr)
+        {
+            yCError(LASER_FUSION) << "Unable to open the laser interface of" << src->name;
+            return false;
+        }
+        //without timestamps the scans are always considered new and aligned
+        src->driver.view(src->iTimed);
+        if (src->iTimed == nullptr)
+        {
+            yCWarning(LASER_FUSION) << "The source" << src->name << "does not provide timestamps, it will be never excluded from the fusion";
+        }
+
+        double pose_x = source_group.check("pose_x", Value(0.0)).asDouble();
+        double pose_y = source_group.check("pose_y", Value(0.0)).asDouble();
+        double pose_theta = source_group.check("pose_theta", Value(0.0)).asDouble();
+        m_fusion.set_pose(i, pose_x, pose_y, pose_theta);
+        yCInfo(LASER_FUSION) << "Source" << src->name << "pose:" << pose_x << pose_y << pose_theta;
+
+        if (m_motion_compensation)
+        {
+            double scan_rate = 0;
+            if (source_group.check("sweep_time")) { src->sweep_time = source_group.find("sweep_time").asDouble(); }
+            else if (src->iLaser->getScanRate(scan_rate) && scan_rate > 0) { src->sweep_time = 1.0 / scan_rate; }
+            else
+            {
+                yCError(LASER_FUSION) << "Unable to obtain the scan rate of" << src->name << ", please set the `sweep_time` parameter";
+                return false;
+            }
+            src->reverse_sweep = source_group.check("reverse_sweep", Value(false)).asBool();
+            src->stamp_at_scan_start = source_group.check("stamp_at_scan_start", Value(false)).asBool();
+            if (src->iTimed == nullptr)
+            {
+                yCError(LASER_FUSION) << "The motion compensation requires the timestamps of the scans, which are not provided by" << src->name;
+                return false;
+            }
+            yCInfo(LASER_FUSION) << "Source" << src->name << "sweep time:" << src->sweep_time << "s";
+        }
+        m_sources.push_back(std::move(src));
+    }
+
+    if (m_motion_compensation)
+    {
+        if (motion_group.check("odometry_port") == false)
+        {
+            yCError(LASER_FUSION) << "Missing `odometry_port` in [MOTION_COMPENSATION] group";
+            return false;
+        }
+        m_odometry.configure(motion_group.check("history_size", Value(200)).asInt(), motion_group.check("max_extrapolation", Value(0.05)).asDouble());
+
+        string odom_portname = m_name + "/odometry:i";
+        m_port_odometry_input = new odometry_input(&m_odometry);
+        m_port_odometry_input->useCallback();
+        if (m_port_odometry_input->open(odom_portname) == false)
+        {
+            yCError(LASER_FUSION) << "Unable to open port" << odom_portname;
+            return false;
+        }
+        if (yarp::os::Network::connect(motion_group.find("odometry_port").asString(), odom_portname) == false)
+        {
+            yCError(LASER_FUSION) << "Unable to connect to" << motion_group.find("odometry_port").asString();
+            return false;
+        }
+        yCInfo(LASER_FUSION) << "Motion compensation enabled";
+    }
+
+    yCInfo(LASER_FUSION) << "Fused scan:" << m_fusion.bins() << "bins, resolution:" << m_fusion.resolution() * RAD2DEG << "deg";
+    return true;
+}
+
+bool laserFusion::close()
+{
+    for (size_t i = 0; i < m_sources.size(); i++)
+    {
+        m_sources[i]->driver.close();
+    }
+    m_sources.clear();
+    if (m_port_odometry_input)
+    {
+        m_port_odometry_input->interrupt();
+        m_port_odometry_input->close();
+        delete m_port_odometry_input;
+        m_port_odometry_input = nullptr;
+    }
+    return true;
+}
+
+bool laserFusion::update()
+{
+    double now = yarp::os::Time::now();
+    double newest = -std::numeric_limits<double>::infinity();
+    bool new_data = false;
+    bool data_ok = false;
+    for (size_t i = 0; i < m_sources.size(); i++)
+    {
+        source_type* src = m_sources[i].get();
+        src->data_ok = src->iLaser->getLaserMeasurement(src->data) && src->data.empty() == false;
+        if (src->data_ok == false) continue;
+        data_ok = true;
+        src->stamp = (src->iTimed) ? src->iTimed->getLastInputStamp().getTime() : now;
+        if (src->stamp != src->fused_stamp) new_data = true;
+        if (src->iTimed) newest = std::max(newest, src->stamp);
+    }
+
+    if (data_ok == false)
+    {
+        m_fused_ok = false;
+        return false;
+    }
+    if (newest == -std::numeric_limits<double>::infinity()) newest = now;
+
+    //the fused scan is recomputed only if a source published a new scan
+    if (new_data == false && m_fused_ok) return true;
+
+    m_fusion.clear();
+    double oldest = newest;
+    bool all_corrected = m_motion_compensation;
+    for (size_t i = 0; i < m_sources.size(); i++)
+    {
+        source_type* src = m_sources[i].get();
+        if (src->data_ok == false) continue;
+        if (src->iTimed && newest - src->stamp > m_max_time_skew)
+        {
+            //a stale scan would place the obstacles where they were, not where they are.
+            //The scan is marked as processed, so that it does not trigger a new fusion until the source publishes a new one
+            src->skipped_scans++;
+            src->fused_stamp = src->stamp;
+            continue;
+        }
+        const scan_motion* motion = nullptr;
+        if (m_motion_compensation)
+        {
+            //all the beams are moved to the pose of the robot at the time of the newest scan
+            double first_beam_time = src->stamp_at_scan_start ? src->stamp : src->stamp - src->sweep_time;
+            double last_beam_time = first_beam_time + src->sweep_time;
+            if (src->reverse_sweep) std::swap(first_beam_time, last_beam_time);
+            if (m_odometry.get_scan_motion(first_beam_time, last_beam_time, newest, m_knots, src->motion)) { motion = &src->motion; }
+            else { src->uncorrected_scans++; all_corrected = false; }
+        }
+        m_fusion.add(i, src->data, motion);
+        src->fused_stamp = src->stamp;
+        if (src->iTimed) oldest = std::min(oldest, src->stamp);
+    }
+    //the fused scan is as old as its oldest component, unless all the components have been moved to the time of the newest one
+    m_stamp.update(all_corrected ? newest : oldest);
+    m_fused_ok = true;
+
+    if (now - m_last_statistics_printed > DISPLAY_PERIOD)
+    {
+        for (size_t i = 0; i < m_sources.size(); i++)
+        {
+            if (m_sources[i]->skipped_scans > 0)
+            {
+                yCWarning(LASER_FUSION) << "Source" << m_sources[i]->name << "excluded" << m_sources[i]->skipped_scans << "times because of time skew";
+                m_sources[i]->skipped_scans = 0;
+            }
+            if (m_sources[i]->uncorrected_scans > 0)
+            {
+                yCWarning(LASER_FUSION) << "Source" << m_sources[i]->name << ":" << m_sources[i]->uncorrected_scans << "scans not corrected, odometry not available";
+                m_sources[i]->uncorrected_scans = 0;
+            }
+        }
+        m_last_statistics_printed = now;
+    }
+    return true;
+}
+
+bool laserFusion::getRawData(yarp::sig::Vector& data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (update() == false) return false;
+    const std::vector<double>& ranges = m_fusion.ranges();
+    data.resize(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        data[i] = ranges[i];
+    }
+    return true;
+}
+
+bool laserFusion::getLaserMeasurement(std::vector<LaserMeasurementData>& data)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (update() == false) return false;
+    const std::vector<double>& ranges = m_fusion.ranges();
+    data.resize(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        data[i].set_polar(ranges[i], m_fusion.bin_angle(i));
+    }
+    return true;
+}
+
+bool laserFusion::getDeviceStatus(Device_status& status)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    status = DEVICE_GENERAL_ERROR;
+    for (size_t i = 0; i < m_sources.size(); i++)
+    {
+        Device_status source_status;
+        if (m_sources[i]->iLaser->getDeviceStatus(source_status) && source_status == DEVICE_OK_IN_USE)
+        {
+            status = DEVICE_OK_IN_USE;
+        }
+    }
+    return true;
+}
+
+bool laserFusion::getDistanceRange(double& min, double& max)
+{
+    min = m_fusion.min_distance();
+    max = m_fusion.max_distance();
+    return true;
+}
+
+bool laserFusion::setDistanceRange(double min, double max)
+{
+    yCError(LASER_FUSION) << "setDistanceRange() not supported, the range is set in the configuration file";
+    return false;
+}
+
+bool laserFusion::getScanLimits(double& min, double& max)
+{
+    min = m_fusion.min_angle() * RAD2DEG;
+    max = m_fusion.max_angle() * RAD2DEG;
+    return true;
+}
+
+bool laserFusion::setScanLimits(double min, double max)
+{
+    yCError(LASER_FUSION) << "setScanLimits() not supported, the limits are set in the configuration file";
+    return false;
+}
+
+bool laserFusion::getHorizontalResolution(double& step)
+{
+    step = m_fusion.resolution() * RAD2DEG;
+    return true;
+}
+
+bool laserFusion::setHorizontalResolution(double step)
+{
+    yCError(LASER_FUSION) << "setHorizontalResolution() not supported, the resolution is set in the configuration file";
+    return false;
+}
+
+bool laserFusion::getScanRate(double& rate)
+{
+    //the fused scan changes every time a source publishes a new scan
+    std::lock_guard<std::mutex> lock(m_mutex);
+    rate = 0;
+    for (size_t i = 0; i < m_sources.size(); i++)
+    {
+        double source_rate = 0;
+        if (m_sources[i]->iLaser->getScanRate(source_rate)) { rate = std::max(rate, source_rate); }
+    }
+    return true;
+}
+
+bool laserFusion::setScanRate(double rate)
+{
+    yCError(LASER_FUSION) << "setScanRate() not supported";
+    return false;
+}
+
+bool laserFusion::getDeviceInfo(std::string& device_info)
+{
+    device_info = "laserFusion, sources:";
+    for (size_t i = 0; i < m_sources.size(); i++)
+    {
+        device_info += " " + m_sources[i]->name;
+    }
+    return true;
+}
+
+yarp::os::Stamp laserFusion::getLastInputStamp()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stamp;
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C)2017  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef LASER_FUSION_H
+#define LASER_FUSION_H
+
+#include <yarp/os/Searchable.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/dev/DeviceDriver.h>
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/dev/IRangefinder2D.h>
+#include <yarp/dev/IPreciselyTimed.h>
+#include <yarp/dev/OdometryData.h>
+#include <yarp/sig/Vector.h>
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include "scanFusion.h"
+#include "scanDeskew.h"
+
+/**
+ * \section laserFusion
+ * A virtual rangefinder which merges the scans of several rangefinders into a single polar scan, centered in the origin of the
+ * robot reference frame. It can be wrapped by a Rangefinder2DWrapper, so that all the consumers (localization, navigation, obstacle
+ * detection) process one deduplicated scan instead of transforming and merging the individual scans by themselves.
+ * The scans are merged with a precomputed bin map (see scan_fusion) when a consumer requests the data and at least one source published
+ * a new scan; the sources whose last scan is older than max_time_skew with respect to the newest one are excluded from the fusion.
+ * Each source is read through a Rangefinder2DClient.
+ * If MOTION_COMPENSATION is enabled, each beam is corrected for the motion of the robot between the instant of its measurement and the
+ * timestamp of the newest scan, using the poses received from the odometry port. A scan is assumed to be timestamped at the end of its sweep,
+ * with the beams measured in order of increasing angle, unless differently specified by the stamp_at_scan_start and reverse_sweep parameters.
+ * The timestamps of the scans and of the odometry must refer to the same clock.
+ *
+ *  Parameters required by this device are:
+ * | Parameter name        | SubParameter   | Type    | Units          | Default Value      | Required     | Description                                                       | Notes |
+ * |:---------------------:|:--------------:|:-------:|:--------------:|:------------------:|:-----------: |:-----------------------------------------------------------------:|:-----:|
+ * | LASERFUSION_GENERAL   |  name          | string  | -              | /laserFusion       | No           | The prefix of the ports opened by the device                      |       |
+ * | LASERFUSION_GENERAL   |  sources       | list    | -              | -                  | Yes          | The names of the groups which describe the rangefinders           | e.g. (front_laser rear_laser) |
+ * | LASERFUSION_GENERAL   |  min_angle     | double  | deg            | -180.0             | No           | The angle of the first bin of the fused scan                      |       |
+ * | LASERFUSION_GENERAL   |  max_angle     | double  | deg            | 180.0              | No           | The angle of the end of the last bin of the fused scan            |       |
+ * | LASERFUSION_GENERAL   |  resolution    | double  | deg            | 0.5                | No           | The angular width of a bin of the fused scan                      | adjusted to divide 360 degrees exactly |
+ * | LASERFUSION_GENERAL   |  min_distance  | double  | m              | 0.0                | No           | The points closer to the center of the robot are discarded        | useful to remove the points which hit the robot |
+ * | LASERFUSION_GENERAL   |  max_distance  | double  | m              | 30.0               | No           | The points farther from the center of the robot are discarded     |       |
+ * | LASERFUSION_GENERAL   |  max_time_skew | double  | s              | 0.1                | No           | The maximum age of a scan with respect to the newest one          |       |
+ * | MOTION_COMPENSATION   |  enable        | bool    | -              | false              | No           | Corrects the scans for the motion of the robot                    |       |
+ * | MOTION_COMPENSATION   |  odometry_port | string  | -              | -                  | If enabled   | The port which broadcasts the odometry data                       |       |
+ * | MOTION_COMPENSATION   |  history_size  | int     | -              | 200                | No           | The number of odometry samples stored                             | must cover the sweep time plus max_time_skew |
+ * | MOTION_COMPENSATION   |  max_extrapolation | double | s           | 0.05               | No           | The maximum extrapolation of the odometry after its last sample  |       |
+ * | MOTION_COMPENSATION   |  knots         | int     | -              | 9                  | No           | The number of poses computed along each sweep, the others are interpolated |  |
+ * | <source>              |  laser_port    | string  | -              | -                  | Yes          | The name of the port of the Rangefinder2DWrapper of the source    |       |
+ * | <source>              |  pose_x        | double  | m              | 0.0                | No           | The position of the sensor in the robot reference frame           |       |
+ * | <source>              |  pose_y        | double  | m              | 0.0                | No           | The position of the sensor in the robot reference frame           |       |
+ * | <source>              |  pose_theta    | double  | deg            | 0.0                | No           | The orientation of the sensor in the robot reference frame        |       |
+ * | <source>              |  sweep_time    | double  | s              | 1/scan rate        | No           | The time between the first and the last beam of a scan            | used by MOTION_COMPENSATION |
+ * | <source>              |  reverse_sweep | bool    | -              | false              | No           | The beams are measured in order of decreasing angle               | used by MOTION_COMPENSATION |
+ * | <source>              |  stamp_at_scan_start | bool | -          | false              | No           | The timestamp of a scan refers to its first beam                  | used by MOTION_COMPENSATION |
+ */
+
+/**
+* Receives the odometry data and stores them in an odometry_history.
+*/
+class odometry_input : public yarp::os::BufferedPort<yarp::dev::OdometryData>
+{
+    odometry_history* m_history;
+public:
+    odometry_input(odometry_history* history) : m_history(history) {}
+    using yarp::os::BufferedPort<yarp::dev::OdometryData>::onRead;
+    virtual void onRead(yarp::dev::OdometryData& odom) override;
+};
+
+class laserFusion : public yarp::dev::DeviceDriver,
+                    public yarp::dev::IRangefinder2D,
+                    public yarp::dev::IPreciselyTimed
+{
+    struct source_type
+    {
+        std::string                        name;
+        yarp::dev::PolyDriver              driver;
+        yarp::dev::IRangefinder2D*         iLaser = nullptr;
+        yarp::dev::IPreciselyTimed*        iTimed = nullptr;
+        std::vector<yarp::dev::LaserMeasurementData> data;
+        double                             stamp = 0;       //the timestamp of the last scan read from the source
+        double                             fused_stamp = -1; //the timestamp of the last scan merged into the fused scan
+        bool                               data_ok = false;
+        size_t                             skipped_scans = 0;
+        double                             sweep_time = 0;   //s
+        bool                               reverse_sweep = false;
+        bool                               stamp_at_scan_start = false;
+        scan_motion                        motion;
+        size_t                             uncorrected_scans = 0;
+    };
+
+    std::string                                m_name = "/laserFusion";
+    std::vector<std::unique_ptr<source_type> > m_sources;
+    scan_fusion                                m_fusion;
+    std::mutex                                 m_mutex;
+    double                                     m_max_time_skew = 0.1;
+    yarp::os::Stamp                            m_stamp;
+    bool                                       m_fused_ok = false;
+    double                                     m_last_statistics_printed = 0;
+
+    //motion compensation
+    bool                                       m_motion_compensation = false;
+    size_t                                     m_knots = 9;
+    odometry_history                           m_odometry;
+    odometry_input*                            m_port_odometry_input = nullptr;
+
+public:
+    laserFusion();
+    virtual ~laserFusion();
+
+    virtual bool open(yarp::os::Searchable& config) override;
+    virtual bool close() override;
+
+public:
+    //IRangefinder2D
+    bool getRawData(yarp::sig::Vector& data) override;
+    bool getLaserMeasurement(std::vector<yarp::dev::LaserMeasurementData>& data) override;
+    bool getDeviceStatus(Device_status& status) override;
+    bool getDistanceRange(double& min, double& max) override;
+    bool setDistanceRange(double min, double max) override;
+    bool getScanLimits(double& min, double& max) override;
+    bool setScanLimits(double min, double max) override;
+    bool getHorizontalResolution(double& step) override;
+    bool setHorizontalResolution(double step) override;
+    bool getScanRate(double& rate) override;
+    bool setScanRate(double rate) override;
+    bool getDeviceInfo(std::string& device_info) override;
+
+    //IPreciselyTimed
+    yarp::os::Stamp getLastInputStamp() override;
+
+private:
+    /**
+    * Reads the sources and, if at least one of them published a new scan, recomputes the fused scan. Must be called with m_mutex locked.
+    * @return false if no source provided valid data
+    */
+    bool update();
+};
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C)2017  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include <cmath>
+
+#include "scanDeskew.h"
+
+using namespace std;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define DEG2RAD M_PI/180
+
+static double normalize_angle(double a)
+{
+    a = fmod(a + M_PI, 2 * M_PI);
+    if (a < 0) a += 2 * M_PI;
+    return a - M_PI;
+}
+
+/////////// scan_motion
+void scan_motion::set_knot(size_t knots, size_t k, double x, double y, double theta)
+{
+    if (m_knots.size() != knots) m_knots.resize(knots);
+    m_knots[k].x = x;
+    m_knots[k].y = y;
+    m_knots[k].c = cos(theta);
+    m_knots[k].s = sin(theta);
+}
+
+/////////// odometry_history
+odometry_history::odometry_history(size_t capacity, double max_extrapolation)
+{
+    configure(capacity, max_extrapolation);
+}
+
+void odometry_history::configure(size_t capacity, double max_extrapolation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_samples.resize(capacity < 2 ? 2 : capacity);
+    m_head = 0;
+    m_count = 0;
+    m_max_extrapolation = max_extrapolation;
+}
+
+void odometry_history::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_head = 0;
+    m_count = 0;
+}
+
+size_t odometry_history::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_count;
+}
+
+void odometry_history::push(double time, double x, double y, double theta)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    //the samples must be sorted by time, for the binary search
+    if (m_count > 0 && time <= sample(m_count - 1).time) return;
+    sample_type& s = m_samples[m_head];
+    s.time = time;
+    s.x = x;
+    s.y = y;
+    s.theta = theta * DEG2RAD;
+    m_head = (m_head + 1) % m_samples.size();
+    if (m_count < m_samples.size()) m_count++;
+}
+
+bool odometry_history::get_pose(double time, double& x, double& y, double& theta) const
+{
+    if (m_count < 2) return false;
+    if (time < sample(0).time) return false;
+    if (time > sample(m_count - 1).time + m_max_extrapolation) return false;
+
+    //the first sample newer than time. If time is newer than the last sample, the last velocity is extrapolated.
+    size_t lo = 1;
+    size_t hi = m_count - 1;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (sample(mid).time < time) lo = mid + 1;
+        else                         hi = mid;
+    }
+    const sample_type& a = sample(lo - 1);
+    const sample_type& b = sample(lo);
+    double f = (time - a.time) / (b.time - a.time);
+    x = a.x + (b.x - a.x) * f;
+    y = a.y + (b.y - a.y) * f;
+    theta = a.theta + normalize_angle(b.theta - a.theta) * f;
+    return true;
+}
+
+bool odometry_history::get_scan_motion(double first_beam_time, double last_beam_time, double reference_time, size_t knots, scan_motion& motion) const
+{
+    if (knots < 2) knots = 2;
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    double ref_x = 0;
+    double ref_y = 0;
+    double ref_theta = 0;
+    if (get_pose(reference_time, ref_x, ref_y, ref_theta) == false) return false;
+    double c = cos(ref_theta);
+    double s = sin(ref_theta);
+
+    for (size_t k = 0; k < knots; k++)
+    {
+        double t = first_beam_time + (last_beam_time - first_beam_time) * k / (knots - 1);
+        double x = 0;
+        double y = 0;
+        double theta = 0;
+        if (get_pose(t, x, y, theta) == false) return false;
+        //the pose at time t, expressed in the robot reference frame at the reference time
+        double dx = x - ref_x;
+        double dy = y - ref_y;
+        motion.set_knot(knots, k, c * dx + s * dy, -s * dx + c * dy, normalize_angle(theta - ref_theta));
+    }
+    return true;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C)2017  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef SCAN_DESKEW_H
+#define SCAN_DESKEW_H
+
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+/**
+* The motion of the robot during a scan. For a set of instants evenly spaced along the sweep (the knots), it stores the
+* rigid transformation which maps a point measured at that instant into the robot reference frame at the reference time.
+* The transformation of each beam is linearly interpolated between the two closest knots.
+*/
+class scan_motion
+{
+    struct knot_type
+    {
+        double x;   //m
+        double y;   //m
+        double c;   //cos(theta)
+        double s;   //sin(theta)
+    };
+
+    std::vector<knot_type> m_knots;
+
+public:
+    /**
+    * Sets the transformation of a knot.
+    * @param knots the number of knots
+    * @param k the index of the knot
+    * @param x the translation (m)
+    * @param y the translation (m)
+    * @param theta the rotation (rad)
+    */
+    void set_knot(size_t knots, size_t k, double x, double y, double theta);
+
+    /**
+    * Moves the point (px,py), expressed in the robot reference frame at the instant of its measurement, to the robot reference frame at the reference time.
+    * @param position the position of the beam along the sweep: 0 is the first beam, 1 the last one
+    */
+    void apply(double position, double& px, double& py) const
+    {
+        double f = position * (m_knots.size() - 1);
+        size_t k = (size_t)f;
+        if (k >= m_knots.size() - 1) k = m_knots.size() - 2;
+        f -= k;
+        const knot_type& a = m_knots[k];
+        const knot_type& b = m_knots[k + 1];
+        double c = a.c + (b.c - a.c) * f;
+        double s = a.s + (b.s - a.s) * f;
+        double x = px;
+        px = c * x - s * py + a.x + (b.x - a.x) * f;
+        py = s * x + c * py + a.y + (b.y - a.y) * f;
+    }
+};
+
+/**
+* A ring buffer which stores the last poses of the robot in the odometry reference frame, together with their timestamps.
+* It is written by the thread which receives the odometry and read by the thread which corrects the scans.
+*/
+class odometry_history
+{
+    struct sample_type
+    {
+        double time;  //s
+        double x;     //m
+        double y;     //m
+        double theta; //rad
+    };
+
+    std::vector<sample_type> m_samples;
+    size_t                   m_head;            //the index of the next sample to be written
+    size_t                   m_count;
+    double                   m_max_extrapolation; //s
+    mutable std::mutex       m_mutex;
+
+public:
+    /**
+    * @param capacity the number of stored samples. It must cover at least the sweep time of the slowest rangefinder plus the maximum time skew.
+    * @param max_extrapolation the maximum time (s) after the last sample for which the pose is extrapolated with the last velocity
+    */
+    odometry_history(size_t capacity = 200, double max_extrapolation = 0.05);
+
+    void   configure(size_t capacity, double max_extrapolation);
+
+    /**
+    * Adds a sample. The samples older than the last one are discarded.
+    * @param theta the orientation of the robot (deg)
+    */
+    void   push(double time, double x, double y, double theta);
+    void   clear();
+    size_t size() const;
+
+    /**
+    * Computes the motion of the robot during a scan.
+    * @param first_beam_time the instant at which the first beam of the scan was measured (s)
+    * @param last_beam_time the instant at which the last beam of the scan was measured (s)
+    * @param reference_time the instant to which all the beams are moved (s)
+    * @param knots the number of knots of the output (at least 2)
+    * @param motion the output
+    * @return false if the history does not cover the requested interval
+    */
+    bool   get_scan_motion(double first_beam_time, double last_beam_time, double reference_time, size_t knots, scan_motion& motion) const;
+
+private:
+    //must be called with m_mutex locked
+    bool   get_pose(double time, double& x, double& y, double& theta) const;
+    const sample_type& sample(size_t i) const { return m_samples[(m_head + m_samples.size() - m_count + i) % m_samples.size()]; }
+};
+
+#endif
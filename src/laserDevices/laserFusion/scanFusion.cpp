@@ -0,0 +1,256 @@
+/*
+ * Copyright (C)2017  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include "scanFusion.h"
+#include "scanDeskew.h"
+
+using namespace std;
+using namespace yarp::dev;
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RAD2DEG 180/M_PI
+#define DEG2RAD M_PI/180
+
+//two beams angles are considered the same if they differ less than this value (rad)
+#define BEAM_ANGLE_TOLERANCE 1e-6
+
+scan_fusion::scan_fusion()
+{
+    m_min_angle = -M_PI;
+    m_max_angle = M_PI;
+    m_resolution = 0.5 * DEG2RAD;
+    m_circle_bins = 720;
+    m_bins = 720;
+    m_min_distance = 0;
+    m_max_distance = std::numeric_limits<double>::infinity();
+}
+
+bool scan_fusion::configure(double min_angle, double max_angle, double resolution, double min_distance, double max_distance, size_t sources)
+{
+    if (resolution <= 0 || max_angle <= min_angle || max_angle - min_angle > 360 || min_distance < 0 || max_distance <= min_distance)
+    {
+        return false;
+    }
+
+    //the bins are the same at every turn, so that the boundaries crossed by a beam can be computed modulo 360 degrees
+    m_circle_bins = (size_t)round(360.0 / resolution);
+    if (m_circle_bins < 4) return false;
+    m_resolution = 2 * M_PI / m_circle_bins;
+    m_min_angle = min_angle * DEG2RAD;
+    m_bins = (size_t)round((max_angle - min_angle) * DEG2RAD / m_resolution);
+    if (m_bins == 0) m_bins = 1;
+    if (m_bins > m_circle_bins) m_bins = m_circle_bins;
+    m_max_angle = m_min_angle + m_bins * m_resolution;
+    m_min_distance = min_distance;
+    m_max_distance = max_distance;
+
+    m_boundary_x.resize(m_circle_bins);
+    m_boundary_y.resize(m_circle_bins);
+    for (size_t i = 0; i < m_circle_bins; i++)
+    {
+        m_boundary_x[i] = cos(m_min_angle + i * m_resolution);
+        m_boundary_y[i] = sin(m_min_angle + i * m_resolution);
+    }
+
+    source_map empty_source;
+    empty_source.x = 0;
+    empty_source.y = 0;
+    empty_source.theta = 0;
+    empty_source.valid = false;
+    m_sources.assign(sources, empty_source);
+    clear();
+    return true;
+}
+
+void scan_fusion::set_pose(size_t source, double x, double y, double theta)
+{
+    if (source >= m_sources.size()) return;
+    source_map& src = m_sources[source];
+    src.x = x;
+    src.y = y;
+    src.theta = theta;
+    src.valid = false;
+}
+
+void scan_fusion::clear()
+{
+    m_ranges.assign(m_bins, std::numeric_limits<double>::infinity());
+}
+
+uint32_t scan_fusion::bin_of_angle(double angle) const
+{
+    double a = fmod(angle - m_min_angle, 2 * M_PI);
+    if (a < 0) a += 2 * M_PI;
+    size_t bin = (size_t)(a / m_resolution);
+    if (bin >= m_circle_bins) bin = m_circle_bins - 1;
+    return (uint32_t)bin;
+}
+
+void scan_fusion::build_map(source_map& src)
+{
+    src.beams.resize(src.beam_angles.size());
+    src.breaks.clear();
+    src.bins.clear();
+
+    double ox = src.x;
+    double oy = src.y;
+    double origin_distance = sqrt(ox * ox + oy * oy);
+    for (size_t i = 0; i < src.beam_angles.size(); i++)
+    {
+        beam_map& beam = src.beams[i];
+        double beam_angle = src.beam_angles[i] + src.theta * DEG2RAD;
+        double dx = cos(beam_angle);
+        double dy = sin(beam_angle);
+        beam.dir_x = (float)dx;
+        beam.dir_y = (float)dy;
+        beam.first_break = (uint32_t)src.breaks.size();
+        beam.first_bin = (uint32_t)src.bins.size();
+
+        //a point at range r is O+r*d: its direction, seen from the center of the robot, moves monotonically from the
+        //direction of O (r=0) to the direction of the beam (r=inf), turning in the direction of the sign of O x d.
+        double cross = ox * dy - oy * dx;
+        if (origin_distance < 1e-6)
+        {
+            src.bins.push_back(bin_of_angle(beam_angle));
+        }
+        else if (fabs(cross) < 1e-9 * origin_distance)
+        {
+            //the beam is aligned with the center of the robot
+            if (ox * dx + oy * dy > 0)
+            {
+                src.bins.push_back(bin_of_angle(beam_angle));
+            }
+            else
+            {
+                //the beam passes through the center of the robot, where its direction flips
+                src.bins.push_back(bin_of_angle(atan2(oy, ox)));
+                src.breaks.push_back((float)origin_distance);
+                src.bins.push_back(bin_of_angle(beam_angle));
+            }
+        }
+        else
+        {
+            double sweep_dir = (cross > 0) ? 1 : -1;
+            double start = atan2(oy, ox);
+            double sweep = sweep_dir * (beam_angle - start);
+            sweep = fmod(sweep, 2 * M_PI);
+            if (sweep < 0) sweep += 2 * M_PI;
+            //the bin just after the origin, along the sweep direction
+            src.bins.push_back(bin_of_angle(start + sweep_dir * 1e-9));
+
+            //the boundaries of the bins crossed by the sweep, in the order in which they are crossed
+            double k0 = (start - m_min_angle) / m_resolution;
+            double k = (sweep_dir > 0) ? floor(k0) + 1 : ceil(k0) - 1;
+            while (true)
+            {
+                double boundary = m_min_angle + k * m_resolution;
+                if (sweep_dir * (boundary - start) >= sweep) break;
+                double ux = cos(boundary);
+                double uy = sin(boundary);
+                //O+r*d crosses the line of direction u when (O+r*d) x u = 0
+                double r = -(ox * uy - oy * ux) / (dx * uy - dy * ux);
+                if (r > 0)
+                {
+                    src.breaks.push_back((float)r);
+                    src.bins.push_back(bin_of_angle(boundary + sweep_dir * m_resolution / 2));
+                }
+                k += sweep_dir;
+            }
+        }
+        beam.break_count = (uint32_t)(src.breaks.size() - beam.first_break);
+    }
+    src.valid = true;
+}
+
+size_t scan_fusion::add(size_t source, const std::vector<LaserMeasurementData>& data, const scan_motion* motion)
+{
+    if (source >= m_sources.size()) return 0;
+    source_map& src = m_sources[source];
+
+    //the bin map depends only on the angles of the beams, which usually never change
+    bool changed = (src.valid == false || src.beam_angles.size() != data.size());
+    if (changed) src.beam_angles.resize(data.size());
+    double range = 0;
+    double angle = 0;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i].get_polar(range, angle);
+        if (changed || fabs(src.beam_angles[i] - angle) > BEAM_ANGLE_TOLERANCE)
+        {
+            src.beam_angles[i] = angle;
+            changed = true;
+        }
+    }
+    if (changed) build_map(src);
+
+    size_t added = 0;
+    double min_distance2 = m_min_distance * m_min_distance;
+    double max_distance2 = m_max_distance * m_max_distance;
+    const float* breaks = src.breaks.data();
+    double last_beam = (data.size() > 1) ? (double)(data.size() - 1) : 1.0;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i].get_polar(range, angle);
+        if (std::isnan(range) || std::isinf(range) || range <= 0) continue;
+
+        const beam_map& beam = src.beams[i];
+        double px = src.x + range * beam.dir_x;
+        double py = src.y + range * beam.dir_y;
+
+        size_t segment = 0;
+        if (beam.break_count > 0)
+        {
+            const float* first = breaks + beam.first_break;
+            segment = std::upper_bound(first, first + beam.break_count, (float)range) - first;
+        }
+        uint32_t bin = src.bins[beam.first_bin + segment];
+
+        if (motion)
+        {
+            //the correction is small, so the corrected point usually stays in the same bin or moves to a neighbouring one
+            motion->apply(i / last_beam, px, py);
+            uint32_t c = (uint32_t)m_circle_bins;
+            for (size_t n = 0; n < m_circle_bins && m_boundary_x[bin] * py - m_boundary_y[bin] * px < 0; n++)
+            {
+                bin = (bin + c - 1) % c;
+            }
+            for (size_t n = 0; n < m_circle_bins; n++)
+            {
+                uint32_t next = (bin + 1) % c;
+                if (m_boundary_x[next] * py - m_boundary_y[next] * px < 0) break;
+                bin = next;
+            }
+        }
+        if (bin >= m_bins) continue;
+
+        double d2 = px * px + py * py;
+        if (d2 < min_distance2 || d2 > max_distance2) continue;
+
+        double d = sqrt(d2);
+        if (d < m_ranges[bin]) m_ranges[bin] = d;
+        added++;
+    }
+    return added;
+}
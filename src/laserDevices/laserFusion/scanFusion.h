@@ -0,0 +1,133 @@
+/*
+ * Copyright (C)2017  ICub Facility - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+ */
+
+#ifndef SCAN_FUSION_H
+#define SCAN_FUSION_H
+
+#include <yarp/dev/IRangefinder2D.h>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class scan_motion;
+
+/**
+* Merges the scans of several rangefinders into a single polar scan, centered in the origin of the robot reference frame.
+* The output scan is a set of angular bins; each bin stores the closest point which falls inside it, so that the points
+* seen by more than one sensor are reported only once.
+* Since the sensors are not placed in the origin of the robot, the bin of a point depends both on the beam and on the
+* measured range. For each beam of each sensor a bin map is precomputed: the ranges at which the beam crosses the boundaries
+* of the bins and the bin of each segment. At runtime a point is assigned to its bin with a binary search on a few
+* breakpoints (usually zero or one), without any trigonometric function.
+* When the scan is corrected for the motion of the robot (see scan_motion), the bin map provides the bin of the uncorrected point,
+* which is then moved to the neighbouring bins by comparing the corrected point with the boundaries of the bins.
+*/
+class scan_fusion
+{
+    //the bin map of a single beam
+    struct beam_map
+    {
+        float    dir_x;       //the direction of the beam, in the robot reference frame
+        float    dir_y;
+        uint32_t first_break; //index of the first breakpoint in m_breaks
+        uint32_t break_count;
+        uint32_t first_bin;   //index of the first bin in m_bins, which stores break_count+1 items
+    };
+
+    struct source_map
+    {
+        double                x;          //m, the position of the sensor in the robot reference frame
+        double                y;          //m
+        double                theta;      //deg
+        std::vector<double>   beam_angles; //rad, the angles of the beams in the sensor reference frame
+        std::vector<beam_map> beams;
+        std::vector<float>    breaks;     //m, ranges at which the beams cross the boundaries of the bins
+        std::vector<uint32_t> bins;       //bins of the complete circle, the ones >= m_bins are outside the output scan
+        bool                  valid;
+    };
+
+    std::vector<source_map> m_sources;
+    std::vector<double>     m_ranges;        //m, the fused scan
+    std::vector<double>     m_boundary_x;    //the direction of the first boundary of each bin of the complete circle
+    std::vector<double>     m_boundary_y;
+    double                  m_min_angle;     //rad
+    double                  m_max_angle;     //rad
+    double                  m_resolution;    //rad
+    size_t                  m_bins;          //the number of bins of the output scan
+    size_t                  m_circle_bins;   //the number of bins of a complete circle
+    double                  m_min_distance;  //m
+    double                  m_max_distance;  //m
+
+public:
+    scan_fusion();
+
+    /**
+    * Defines the output scan.
+    * @param min_angle the angle of the first bin (deg)
+    * @param max_angle the angle of the end of the last bin (deg)
+    * @param resolution the width of a bin (deg), at most 90 degrees. It is adjusted in order to divide exactly 360 degrees.
+    * @param min_distance the points closer than this value to the center of the robot are discarded (m)
+    * @param max_distance the points farther than this value from the center of the robot are discarded (m)
+    * @param sources the number of rangefinders
+    * @return false if the parameters are not valid
+    */
+    bool   configure(double min_angle, double max_angle, double resolution, double min_distance, double max_distance, size_t sources);
+
+    /**
+    * Sets the pose of a rangefinder in the robot reference frame. The bin map is rebuilt at the next call to add().
+    */
+    void   set_pose(size_t source, double x, double y, double theta);
+
+    /**
+    * Empties all the bins of the output scan.
+    */
+    void   clear();
+
+    /**
+    * Adds the points measured by a rangefinder to the output scan. The bin map of the source is rebuilt only if the
+    * angles of its beams changed since the previous call.
+    * @param source the index of the rangefinder
+    * @param data the scan, expressed in the sensor reference frame
+    * @param motion if not null, the motion of the robot during the scan, used to correct each beam
+    * @return the number of points which have been added
+    */
+    size_t add(size_t source, const std::vector<yarp::dev::LaserMeasurementData>& data, const scan_motion* motion = nullptr);
+
+    /**
+    * The fused scan: the range (m) of each bin, measured from the center of the robot. The empty bins are set to infinity.
+    */
+    const std::vector<double>& ranges() const { return m_ranges; }
+
+    size_t bins() const { return m_bins; }
+    double resolution() const { return m_resolution; }
+    double min_angle() const { return m_min_angle; }
+    double max_angle() const { return m_max_angle; }
+    double min_distance() const { return m_min_distance; }
+    double max_distance() const { return m_max_distance; }
+
+    /**
+    * Returns the angle (rad) of the center of a bin of the output scan.
+    */
+    double bin_angle(size_t bin) const { return m_min_angle + (bin + 0.5) * m_resolution; }
+
+private:
+    uint32_t bin_of_angle(double angle) const;
+    void     build_map(source_map& src);
+};
+
+#endif
@@ -0,0 +1,465 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Value.h>
+#include <yarp/os/Time.h>
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <algorithm>
+#include <cmath>
+
+#include "localPlanner.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+
+YARP_LOG_COMPONENT(GOTO_LOCAL_PLANNER, "navigation.devices.robotGoto.localPlanner")
+
+#ifndef M_PI
+#define M_PI 3.14159265
+#endif
+
+/////////// local_distance_grid
+local_distance_grid::local_distance_grid()
+{
+    m_size = 0;
+    m_resolution = 0.05;
+    m_max_distance = 1.0;
+}
+
+void local_distance_grid::configure(double half_size, double resolution, double max_distance)
+{
+    m_resolution = resolution;
+    m_max_distance = max_distance;
+    m_size = 2 * (size_t)ceil(half_size / resolution);
+    //the grid has a border of one cell, which is never written, so that the distance transform does not need bound checks
+    m_distance.assign((m_size + 2) * (m_size + 2), (float)m_max_distance);
+}
+
+void local_distance_grid::build(std::vector<LaserMeasurementData>& laser_data)
+{
+    float max_distance = (float)m_max_distance;
+    std::fill(m_distance.begin(), m_distance.end(), max_distance);
+    if (m_size == 0) return;
+
+    size_t stride = m_size + 2;
+    double half_size = m_size * m_resolution / 2;
+    for (size_t i = 0; i < laser_data.size(); i++)
+    {
+        double x = 0;
+        double y = 0;
+        laser_data[i].get_cartesian(x, y);
+        if (std::isnan(x) || std::isnan(y)) continue;
+        double cx = floor((x + half_size) / m_resolution);
+        double cy = floor((y + half_size) / m_resolution);
+        if (cx < 0 || cy < 0 || cx >= m_size || cy >= m_size) continue;
+        m_distance[((size_t)cy + 1) * stride + (size_t)cx + 1] = 0;
+    }
+
+    //two-pass chamfer distance transform (3x3 mask)
+    float d1 = (float)m_resolution;
+    float d2 = (float)(m_resolution * sqrt(2.0));
+    for (size_t y = 1; y <= m_size; y++)
+    {
+        float* row = &m_distance[y * stride];
+        const float* prev = row - stride;
+        for (size_t x = 1; x <= m_size; x++)
+        {
+            float d = row[x];
+            d = std::min(d, row[x - 1] + d1);
+            d = std::min(d, prev[x] + d1);
+            d = std::min(d, prev[x - 1] + d2);
+            d = std::min(d, prev[x + 1] + d2);
+            row[x] = d;
+        }
+    }
+    for (size_t y = m_size; y >= 1; y--)
+    {
+        float* row = &m_distance[y * stride];
+        const float* next = row + stride;
+        for (size_t x = m_size; x >= 1; x--)
+        {
+            float d = row[x];
+            d = std::min(d, row[x + 1] + d1);
+            d = std::min(d, next[x] + d1);
+            d = std::min(d, next[x - 1] + d2);
+            d = std::min(d, next[x + 1] + d2);
+            row[x] = std::min(d, max_distance);
+        }
+    }
+}
+
+double local_distance_grid::clearance(double x, double y) const
+{
+    double half_size = m_size * m_resolution / 2;
+    double cx = floor((x + half_size) / m_resolution);
+    double cy = floor((y + half_size) / m_resolution);
+    if (cx < 0 || cy < 0 || cx >= m_size || cy >= m_size) return m_max_distance;
+    return m_distance[((size_t)cy + 1) * (m_size + 2) + (size_t)cx + 1];
+}
+
+/////////// rollout_pool
+rollout_pool::rollout_pool()
+{
+    m_task = nullptr;
+    m_task_count = 0;
+    m_next_index = 0;
+    m_generation = 0;
+    m_active_workers = 0;
+    m_stopping = false;
+}
+
+rollout_pool::~rollout_pool()
+{
+    stop();
+}
+
+bool rollout_pool::start(size_t threads)
+{
+    m_stopping = false;
+    for (size_t i = 0; i < threads; i++)
+    {
+        m_workers.push_back(std::unique_ptr<worker>(new worker(this)));
+        if (m_workers.back()->start() == false)
+        {
+            m_workers.pop_back();
+            stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+void rollout_pool::stop()
+{
+    for (auto it = m_workers.begin(); it != m_workers.end(); it++)
+    {
+        (*it)->stop();
+    }
+    m_workers.clear();
+}
+
+void rollout_pool::wake_workers()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+    m_work_cond.notify_all();
+}
+
+void rollout_pool::process(const std::function<void(size_t)>& task, size_t count)
+{
+    for (size_t i = m_next_index++; i < count; i = m_next_index++)
+    {
+        task(i);
+    }
+}
+
+void rollout_pool::worker_loop()
+{
+    size_t seen_generation;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        seen_generation = m_generation;
+    }
+
+    while (true)
+    {
+        const std::function<void(size_t)>* task;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_work_cond.wait(lock, [&] { return m_stopping || m_generation != seen_generation; });
+            if (m_stopping) return;
+            seen_generation = m_generation;
+            //the calling thread may have already completed the execution
+            if (m_task == nullptr) continue;
+            task = m_task;
+            count = m_task_count;
+            m_active_workers++;
+        }
+
+        process(*task, count);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_active_workers--;
+        if (m_active_workers == 0) m_done_cond.notify_all();
+    }
+}
+
+void rollout_pool::execute(size_t count, const std::function<void(size_t)>& task)
+{
+    if (count == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_task_count = count;
+        m_next_index = 0;
+        m_generation++;
+    }
+    if (!m_workers.empty()) m_work_cond.notify_all();
+
+    process(task, count);
+
+    //all the indices have been assigned: wait for the workers which are still processing theirs.
+    //The task is removed inside the same critical section, so a worker which wakes up later does not use it.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done_cond.wait(lock, [this] { return m_active_workers == 0; });
+    m_task = nullptr;
+    m_task_count = 0;
+}
+
+/////////// dwa_local_planner
+//the point reached after a path of length s along a circular arc which starts from the origin, tangent to the x axis
+static inline void arc_point(double curvature, double s, double& x, double& y)
+{
+    if (fabs(curvature) < 1e-6)
+    {
+        x = s;
+        y = 0;
+    }
+    else
+    {
+        x = sin(curvature * s) / curvature;
+        y = (1 - cos(curvature * s)) / curvature;
+    }
+}
+
+dwa_local_planner::dwa_local_planner(Searchable& cfg, double period)
+{
+    m_robot_radius = 0;
+    m_collision_distance = 0;
+    m_max_lin_acc = 0.5;
+    m_max_ang_acc = 60.0;
+    m_lin_samples = 7;
+    m_ang_samples = 15;
+    m_sim_time = 1.5;
+    m_window_time = 0.1;
+    m_time_budget = 0.5 * period;
+    m_max_free_distance = 2.0;
+    m_goal_weight = 1.0;
+    m_heading_weight = 0.5;
+    m_clearance_weight = 0.3;
+    m_speed_weight = 0.3;
+    m_threads = 2;
+    m_goal_x = 0;
+    m_goal_y = 0;
+    m_goal_distance = 0;
+    m_max_lin_speed = 0;
+    m_deadline = 0;
+    m_skipped_rollouts = 0;
+    m_last_print_time = yarp::os::Time::now();
+    double grid_size = 2.0;
+    double grid_resolution = 0.05;
+
+    Bottle geometry_group = cfg.findGroup("ROBOT_GEOMETRY");
+    if (geometry_group.check("robot_radius"))
+    {
+        m_robot_radius = geometry_group.find("robot_radius").asDouble();
+    }
+    else
+    {
+        yCError(GOTO_LOCAL_PLANNER) << "Invalid/missing parameter in ROBOT_GEOMETRY group";
+    }
+
+    Bottle dwa_group = cfg.findGroup("DWA_LOCAL_PLANNER");
+    m_max_lin_acc = dwa_group.check("max_lin_acc", Value(0.5)).asDouble();
+    m_max_ang_acc = dwa_group.check("max_ang_acc", Value(60.0)).asDouble();
+    m_lin_samples = (size_t)std::max(1, dwa_group.check("lin_samples", Value(7)).asInt());
+    m_ang_samples = (size_t)std::max(1, dwa_group.check("ang_samples", Value(15)).asInt());
+    m_sim_time = dwa_group.check("sim_time", Value(1.5)).asDouble();
+    m_window_time = dwa_group.check("window_time", Value(0.1)).asDouble();
+    m_time_budget = dwa_group.check("time_budget", Value(0.5)).asDouble() * period;
+    m_max_free_distance = dwa_group.check("max_free_distance", Value(2.0)).asDouble();
+    m_goal_weight = dwa_group.check("goal_weight", Value(1.0)).asDouble();
+    m_heading_weight = dwa_group.check("heading_weight", Value(0.5)).asDouble();
+    m_clearance_weight = dwa_group.check("clearance_weight", Value(0.3)).asDouble();
+    m_speed_weight = dwa_group.check("speed_weight", Value(0.3)).asDouble();
+    m_threads = (size_t)std::max(0, dwa_group.check("threads", Value(2)).asInt());
+    grid_size = dwa_group.check("grid_size", Value(2.0)).asDouble();
+    grid_resolution = dwa_group.check("grid_resolution", Value(0.05)).asDouble();
+
+    if (m_sim_time <= 0 || m_max_free_distance <= 0 || m_max_lin_acc <= 0)
+    {
+        yCError(GOTO_LOCAL_PLANNER) << "Invalid sim_time/max_free_distance/max_lin_acc parameters, using default values";
+        m_sim_time = 1.5;
+        m_max_free_distance = 2.0;
+        m_max_lin_acc = 0.5;
+    }
+    if (grid_resolution <= 0 || grid_size < grid_resolution)
+    {
+        yCError(GOTO_LOCAL_PLANNER) << "Invalid grid_size/grid_resolution parameters, using default values";
+        grid_size = 2.0;
+        grid_resolution = 0.05;
+    }
+    //the robot radius is enlarged by one cell, to compensate the discretization of the laser points and of the rollouts.
+    //The rollouts only compare the clearance with this distance, so larger values are not needed.
+    m_collision_distance = m_robot_radius + grid_resolution;
+    m_grid.configure(grid_size, grid_resolution, 2 * m_collision_distance);
+    m_rollouts.resize(m_lin_samples * m_ang_samples);
+}
+
+bool dwa_local_planner::start()
+{
+    if (m_pool.start(m_threads) == false)
+    {
+        yCError(GOTO_LOCAL_PLANNER) << "Unable to start the rollout threads";
+        return false;
+    }
+    return true;
+}
+
+void dwa_local_planner::stop()
+{
+    m_pool.stop();
+}
+
+void dwa_local_planner::evaluate(size_t i)
+{
+    rollout_type& r = m_rollouts[i];
+    r.admissible = false;
+    r.evaluated = false;
+    if (yarp::os::Time::now() > m_deadline) return;
+    r.evaluated = true;
+
+    //the free distance is measured along the whole arc with the curvature of the sample (not only along the
+    //part covered in sim_time), so that the rollouts which head towards an obstacle are penalized early.
+    //The rotations in place are evaluated along the current heading.
+    double free_distance = m_max_free_distance;
+    double curvature = (r.linear_vel > 0) ? r.angular_vel / r.linear_vel : 0;
+    double ds = m_grid.resolution();
+    for (double s = ds; s <= m_max_free_distance; s += ds)
+    {
+        double x = 0;
+        double y = 0;
+        arc_point(curvature, s, x, y);
+        if (m_grid.clearance(x, y) < m_collision_distance)
+        {
+            free_distance = s - ds;
+            break;
+        }
+    }
+
+    //the velocity is admissible only if the robot can stop before the collision
+    if (r.linear_vel * r.linear_vel / (2 * m_max_lin_acc) > free_distance) return;
+
+    //the pose reached after sim_time
+    double x = 0;
+    double y = 0;
+    double theta = r.angular_vel * m_sim_time;
+    if (r.linear_vel > 0)
+    {
+        double s = std::min(r.linear_vel * m_sim_time, free_distance);
+        arc_point(curvature, s, x, y);
+        theta = curvature * s;
+    }
+
+    double goal_distance = sqrt((m_goal_x - x) * (m_goal_x - x) + (m_goal_y - y) * (m_goal_y - y));
+    double heading_error = atan2(m_goal_y - y, m_goal_x - x) - theta;
+    heading_error = fabs(atan2(sin(heading_error), cos(heading_error)));
+
+    r.cost  = m_goal_weight * goal_distance / std::max(m_goal_distance, 1e-3);
+    r.cost += m_heading_weight * heading_error / M_PI;
+    r.cost += m_clearance_weight * (1.0 - free_distance / m_max_free_distance);
+    r.cost += m_speed_weight * ((m_max_lin_speed > 0) ? (1.0 - r.linear_vel / m_max_lin_speed) : 0.0);
+    r.admissible = true;
+}
+
+bool dwa_local_planner::compute(std::vector<LaserMeasurementData>& laser_data, double goal_distance, double goal_direction,
+                                const command_type& current, double max_lin_speed, double max_ang_speed, double dt, command_type& out)
+{
+    out.linear_vel = 0;
+    out.angular_vel = 0;
+    m_deadline = yarp::os::Time::now() + m_time_budget;
+
+    m_grid.build(laser_data);
+    m_goal_distance = goal_distance;
+    m_goal_x = goal_distance * cos(goal_direction * M_PI / 180.0);
+    m_goal_y = goal_distance * sin(goal_direction * M_PI / 180.0);
+    m_max_lin_speed = max_lin_speed;
+
+    //the dynamic window: the velocities reachable within window_time, limited by the maximum speeds.
+    //The window is usually wider than the control period, the command is then limited by the accelerations (see below)
+    double window = std::max(dt, m_window_time);
+    double v_max = std::min(max_lin_speed, current.linear_vel + m_max_lin_acc * window);
+    double v_min = std::min(v_max, std::max(0.0, current.linear_vel - m_max_lin_acc * window));
+    double w_max = std::min(max_ang_speed, current.angular_vel + m_max_ang_acc * window);
+    double w_min = std::min(w_max, std::max(-max_ang_speed, current.angular_vel - m_max_ang_acc * window));
+    if (v_max < 0) v_max = v_min = 0;
+
+    for (size_t i = 0; i < m_lin_samples; i++)
+    {
+        double v = (m_lin_samples > 1) ? v_min + (v_max - v_min) * i / (m_lin_samples - 1) : (v_min + v_max) / 2;
+        for (size_t j = 0; j < m_ang_samples; j++)
+        {
+            double w = (m_ang_samples > 1) ? w_min + (w_max - w_min) * j / (m_ang_samples - 1) : (w_min + w_max) / 2;
+            rollout_type& r = m_rollouts[i * m_ang_samples + j];
+            r.linear_vel = v;
+            r.angular_vel = w * M_PI / 180.0;
+            r.cost = 0;
+        }
+    }
+
+    std::function<void(size_t)> task = [this](size_t i) { evaluate(i); };
+    m_pool.execute(m_rollouts.size(), task);
+
+    const rollout_type* best = nullptr;
+    bool can_move_forward = false;
+    size_t skipped_rollouts = 0;
+    for (auto it = m_rollouts.begin(); it != m_rollouts.end(); it++)
+    {
+        if (it->evaluated == false) skipped_rollouts++;
+        if (it->admissible == false) continue;
+        if (it->linear_vel > 1e-3) can_move_forward = true;
+        if (best == nullptr || it->cost < best->cost) best = &(*it);
+    }
+    m_skipped_rollouts += skipped_rollouts;
+
+    double current_time = yarp::os::Time::now();
+    if (m_skipped_rollouts > 0 && current_time - m_last_print_time > 5.0)
+    {
+        yCWarning(GOTO_LOCAL_PLANNER) << m_skipped_rollouts << "rollouts skipped in the last" << current_time - m_last_print_time << "s because the time budget expired";
+        m_skipped_rollouts = 0;
+        m_last_print_time = current_time;
+    }
+
+    double lin_step = m_max_lin_acc * dt;
+    double ang_step = m_max_ang_acc * dt;
+
+    //the time budget expired before an admissible velocity was found: the result is inconclusive, so the path is not reported
+    //as blocked. The robot brakes along the arc of the previous command, which was admissible, thus it can stop before the collision.
+    if (best == nullptr && skipped_rollouts > 0)
+    {
+        out.linear_vel = std::max(0.0, current.linear_vel - lin_step);
+        if (current.linear_vel > 0)
+            out.angular_vel = current.angular_vel * out.linear_vel / current.linear_vel;
+        else if (current.angular_vel > 0)
+            out.angular_vel = std::max(0.0, current.angular_vel - ang_step);
+        else
+            out.angular_vel = std::min(0.0, current.angular_vel + ang_step);
+        return true;
+    }
+
+    //no admissible velocity: the robot is stopped immediately
+    if (best == nullptr) return false;
+
+    out.linear_vel = std::max(current.linear_vel - lin_step, std::min(best->linear_vel, current.linear_vel + lin_step));
+    out.angular_vel = std::max(current.angular_vel - ang_step, std::min(best->angular_vel * 180.0 / M_PI, current.angular_vel + ang_step));
+    return can_move_forward;
+}
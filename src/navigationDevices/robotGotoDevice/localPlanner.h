@@ -0,0 +1,213 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef LOCAL_PLANNER_H
+#define LOCAL_PLANNER_H
+
+#include <yarp/os/Searchable.h>
+#include <yarp/os/Thread.h>
+#include <yarp/dev/IRangefinder2D.h>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+
+/**
+* A square grid centered on the robot, which stores for each cell the distance (m) from the closest laser point.
+* The grid is rebuilt once per control cycle with a two-pass chamfer distance transform, so that the clearance of
+* every pose simulated by the rollouts is a single lookup. The chamfer metric overestimates the euclidean distance by 8% at most.
+*/
+class local_distance_grid
+{
+    std::vector<float> m_distance;
+    size_t             m_size;         //cells per side
+    double             m_resolution;   //m
+    double             m_max_distance; //m, the value of the cells far from every obstacle
+
+public:
+    local_distance_grid();
+
+    /**
+    * Allocates the grid.
+    * @param half_size the distance (m) between the robot and the border of the grid
+    * @param resolution the size of a cell (m)
+    * @param max_distance the distances are saturated to this value (m)
+    */
+    void   configure(double half_size, double resolution, double max_distance);
+
+    /**
+    * Computes the distance field of a laser scan, expressed in the robot reference frame. The points outside the grid are ignored.
+    */
+    void   build(std::vector<yarp::dev::LaserMeasurementData>& laser_data);
+
+    /**
+    * Returns the distance (m) between the point (x,y), expressed in the robot reference frame, and the closest laser point.
+    * The points outside the grid return max_distance.
+    */
+    double clearance(double x, double y) const;
+
+    double resolution() const { return m_resolution; }
+};
+
+/**
+* A small set of threads which execute the same task on a range of indices. The calling thread takes part in the
+* execution, so that the pool can be used inside a control loop without any hand-off latency. Each index is
+* processed exactly once, the indices are distributed dynamically among the threads.
+*/
+class rollout_pool
+{
+    class worker : public yarp::os::Thread
+    {
+        rollout_pool* m_pool;
+    public:
+        worker(rollout_pool* pool) : m_pool(pool) {}
+        virtual void run() override { m_pool->worker_loop(); }
+        virtual void onStop() override { m_pool->wake_workers(); }
+    };
+
+    std::vector<std::unique_ptr<worker> > m_workers;
+    std::mutex                            m_mutex;
+    std::condition_variable               m_work_cond;
+    std::condition_variable               m_done_cond;
+    const std::function<void(size_t)>*    m_task;
+    size_t                                m_task_count;
+    std::atomic<size_t>                   m_next_index;
+    size_t                                m_generation;
+    size_t                                m_active_workers;
+    bool                                  m_stopping;
+
+public:
+    rollout_pool();
+    ~rollout_pool();
+
+    /**
+    * Starts the threads of the pool.
+    * @param threads the number of additional threads. 0 means that the tasks are executed by the calling thread only.
+    * @return false if a thread could not be started
+    */
+    bool   start(size_t threads);
+    void   stop();
+
+    /**
+    * Executes task(i) for each i in [0,count) and returns when all the calls are completed.
+    */
+    void   execute(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    void   worker_loop();
+    void   wake_workers();
+    void   process(const std::function<void(size_t)>& task, size_t count);
+};
+
+/**
+* A Dynamic Window Approach local planner. At each control cycle it samples the (linear, angular) velocities reachable
+* within the acceleration limits and follows the circular arc produced by each sample on a local_distance_grid built from
+* the current laser scan. A sample is admissible if the robot can stop before the first collision along its arc. The admissible
+* samples are scored by the distance from the goal and the heading error after sim_time, by the free distance along the arc and by the speed.
+* The rollouts are evaluated in parallel by a rollout_pool, within a time budget which is a fraction of the control period.
+* The commands are always along the x axis of the robot (linear_dir=0), also on holonomic platforms.
+*/
+class dwa_local_planner
+{
+public:
+    struct command_type
+    {
+        double linear_vel;  //m/s
+        double angular_vel; //deg/s
+    };
+
+private:
+    //a sampled velocity and the evaluation of the corresponding rollout
+    struct rollout_type
+    {
+        double linear_vel;  //m/s
+        double angular_vel; //rad/s
+        double cost;
+        bool   admissible;
+        bool   evaluated;
+    };
+
+    double                    m_robot_radius;      //m
+    double                    m_collision_distance; //m, the robot radius plus the resolution of the grid
+    double                    m_max_lin_acc;       //m/s^2
+    double                    m_max_ang_acc;       //deg/s^2
+    size_t                    m_lin_samples;
+    size_t                    m_ang_samples;
+    double                    m_sim_time;          //s
+    double                    m_window_time;       //s, the width of the dynamic window, expressed as the time needed to reach its borders
+    double                    m_time_budget;       //s
+    double                    m_max_free_distance; //m, the free distances larger than this value do not improve the score
+    double                    m_goal_weight;
+    double                    m_heading_weight;
+    double                    m_clearance_weight;
+    double                    m_speed_weight;
+    size_t                    m_threads;
+
+    local_distance_grid       m_grid;
+    rollout_pool              m_pool;
+    std::vector<rollout_type> m_rollouts;
+    double                    m_goal_x;            //m, the goal in the robot reference frame
+    double                    m_goal_y;            //m
+    double                    m_goal_distance;     //m
+    double                    m_max_lin_speed;     //m/s
+    double                    m_deadline;
+    size_t                    m_skipped_rollouts;
+    double                    m_last_print_time;
+
+public:
+    /**
+    * Constructor. The parameters are read from the DWA_LOCAL_PLANNER and ROBOT_GEOMETRY groups.
+    * @param cfg the configuration of the device
+    * @param period the period of the control loop (s)
+    */
+    dwa_local_planner(yarp::os::Searchable& cfg, double period);
+
+    /**
+    * Starts the threads which evaluate the rollouts.
+    * @return true if the threads were successfully started
+    */
+    bool start();
+    void stop();
+
+    /**
+    * Computes the velocity command which drives the robot towards the goal.
+    * @param laser_data the current laser scan, in the robot reference frame
+    * @param goal_distance the distance between the robot and the goal (m)
+    * @param goal_direction the direction of the goal in the robot reference frame (deg)
+    * @param current the command sent during the previous control cycle, used as center of the dynamic window
+    * @param max_lin_speed the maximum linear velocity (m/s)
+    * @param max_ang_speed the maximum angular velocity (deg/s)
+    * @param dt the time elapsed since the previous command (s), used to limit the acceleration of the output
+    * @param out the best command. It is zero if the robot cannot move without colliding, it decelerates the current command
+    * if the time budget expired before an admissible rollout was found.
+    * @return true if the robot can move forward along a collision-free rollout (or the result is inconclusive because the
+    * time budget expired), false if it can at most rotate in place
+    */
+    bool compute(std::vector<yarp::dev::LaserMeasurementData>& laser_data, double goal_distance, double goal_direction,
+                 const command_type& current, double max_lin_speed, double max_ang_speed, double dt, command_type& out);
+
+private:
+    /**
+    * Simulates the rollout i and computes its cost. Executed by the threads of the pool.
+    */
+    void evaluate(size_t i);
+};
+
+#endif
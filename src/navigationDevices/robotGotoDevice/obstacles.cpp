@@ -31,6 +31,7 @@
 #include <yarp/os/RateThread.h>
 #include <yarp/dev/IRangefinder2D.h>
 #include <string>
+#include <algorithm>
 #include <math.h>
 #include <yarp/math/Math.h>
 #include <yarp/math/Quaternion.h>
@@ -45,6 +46,8 @@ using namespace yarp::math;
 YARP_LOG_COMPONENT(GOTO_OBSTACLES, "navigation.devices.robotGoto.obstacles")
 
 #define DEG2RAD 3.14/180
+//number of discretised directions of the collision envelope (1 deg each)
+#define ENVELOPE_DIRECTIONS 360
 obstacles_class::obstacles_class(Searchable &rf)
 {
     yarp::os::Time::now();
@@ -57,6 +60,9 @@ obstacles_class::obstacles_class(Searchable &rf)
     m_max_detection_distance = 1.5;
     m_min_detection_distance = 0.4;
     m_last_print_time = yarp::os::Time::now();
+    m_envelope_robot_radius = 0;
+    m_envelope_limits_row = -1;
+    m_envelope_limits_distance = 0;
 
     /////////////////
     Bottle geometry_group = rf.findGroup("ROBOT_GEOMETRY");
@@ -110,21 +116,91 @@ obstacles_class::obstacles_class(Searchable &rf)
         m_speed_reduction_factor = obstacles_avoidance_group.check("speed_reduction_factor", Value(0.70)).asDouble();
 }
 
-//checks if a point is inside a polygon
-int obstacles_class::pnpoly(int nvert, double *vertx, double *verty, double testx, double testy)
+void obstacles_class::update_envelope(std::vector<LaserMeasurementData>& laser_data)
 {
-  int i, j, c = 0;
-  for (i = 0, j = nvert-1; i < nvert; j = i++)
-  {
-    if (( (verty[i]>testy) != (verty[j]>testy) ) &&
-          (testx < (vertx[j]-vertx[i]) * (testy-verty[i]) / (verty[j]-verty[i]) + vertx[i]) )
+    size_t las_size = laser_data.size();
+    bool changed = (las_size != m_envelope_beam_angles.size() || m_robot_radius != m_envelope_robot_radius);
+    if (changed == false && las_size > 0)
+    {
+        //checking the first and the last beam is enough to detect a different configuration of the rangefinder
+        double d = 0;
+        double first_angle = 0;
+        double last_angle = 0;
+        laser_data[0].get_polar(d, first_angle);
+        laser_data[las_size - 1].get_polar(d, last_angle);
+        changed = (fabs(first_angle - m_envelope_beam_angles[0]) > 1e-6 || fabs(last_angle - m_envelope_beam_angles[las_size - 1]) > 1e-6);
+    }
+    if (changed == false) return;
+
+    m_envelope_beam_angles.resize(las_size);
+    for (size_t i = 0; i < las_size; i++)
     {
-       c = !c;
+        double d = 0;
+        laser_data[i].get_polar(d, m_envelope_beam_angles[i]);
     }
-  }
-  return c;
+    m_envelope_robot_radius = m_robot_radius;
+    m_envelope.assign(ENVELOPE_DIRECTIONS, envelope_row());
+    m_ranges.resize(las_size);
+    m_envelope_limits_row = -1;
+    yCDebug(GOTO_OBSTACLES) << "Collision envelope reset for" << las_size << "beams";
 }
 
+const obstacles_class::envelope_row& obstacles_class::envelope_row_at(int k)
+{
+    double step = 360.0 / ENVELOPE_DIRECTIONS;
+    size_t las_size = m_envelope_beam_angles.size();
+    envelope_row& row = m_envelope[k];
+    if (row.depth_factor.empty())
+    {
+        //the detection rectangle, rotated by beta, is [0,detection_distance] x [-robot_radius,+robot_radius].
+        //A beam with angle phi relative to beta leaves it through the far side (at detection_distance/cos(phi))
+        //or through one of the lateral sides (at robot_radius/|sin(phi)|), whichever comes first
+        row.depth_factor.resize(las_size);
+        row.lateral_limit.resize(las_size);
+        double beta_rad = (k * step - 180.0) * DEG2RAD;
+        for (size_t i = 0; i < las_size; i++)
+        {
+            double phi = m_envelope_beam_angles[i] - beta_rad;
+            double c = cos(phi);
+            double s = fabs(sin(phi));
+            row.depth_factor[i] = (c > 1e-6) ? (float)(1.0 / c) : 0.0f;
+            row.lateral_limit[i] = (s > 1e-6) ? (float)(m_robot_radius / s) : 1e9f;
+        }
+    }
+    return row;
+}
+
+const std::vector<float>& obstacles_class::envelope_limits(double beta, double detection_distance)
+{
+    double step = 360.0 / ENVELOPE_DIRECTIONS;
+    //the rows cover the directions from -180 to 180 deg, the same range of the beta computed by the controller.
+    //A direction between two rows is not rounded to the nearest one, whose rectangle may miss an obstacle near the far
+    //corners: the limits of both rows are used instead. The union of the two rectangles, with the far side moved forward by
+    //robot_radius*sin(step), contains the rectangle of any direction in between
+    double b = fmod(beta + 180.0, 360.0);
+    if (b < 0) b += 360.0;
+    double position = b / step;
+    int k0 = ((int)floor(position)) % ENVELOPE_DIRECTIONS;
+    bool between = (position - floor(position) > 1e-6);
+    int k1 = between ? (k0 + 1) % ENVELOPE_DIRECTIONS : k0;
+    int key = 2 * k0 + (between ? 1 : 0);
+    if (key == m_envelope_limits_row && detection_distance == m_envelope_limits_distance) return m_envelope_limits;
+
+    const envelope_row& row0 = envelope_row_at(k0);
+    const envelope_row& row1 = envelope_row_at(k1);
+    size_t las_size = m_envelope_beam_angles.size();
+    m_envelope_limits.resize(las_size);
+    float distance = (float)(between ? detection_distance + m_robot_radius * sin(step * DEG2RAD) : detection_distance);
+    for (size_t i = 0; i < las_size; i++)
+    {
+        float limit0 = std::min(distance * row0.depth_factor[i], row0.lateral_limit[i]);
+        float limit1 = std::min(distance * row1.depth_factor[i], row1.lateral_limit[i]);
+        m_envelope_limits[i] = std::max(limit0, limit1);
+    }
+    m_envelope_limits_row = key;
+    m_envelope_limits_distance = detection_distance;
+    return m_envelope_limits;
+}
 
 bool obstacles_class::compute_obstacle_avoidance(std::vector<LaserMeasurementData>& laser_data)
 {
@@ -193,13 +269,6 @@ bool obstacles_class::check_obstacles_in_path(std::vector<LaserMeasurementData>&
 {
     static double last_time_error_message = 0;
     int laser_obstacles  = 0;
-    double goal_distance = 1000; //TO BE COMPLETED
-
-    //compute the polygon
-    double vx[4];
-    double vy[4];
-    double vertx[4];
-    double verty[4];
 
     //on the left the map reference frame, on the right the robot reference frame.
     //laser data is expressed in the robot reference frame
@@ -207,8 +276,6 @@ bool obstacles_class::check_obstacles_in_path(std::vector<LaserMeasurementData>&
     //      Y                  X
     //      |       <-->       |
     //      O--X            Y--O
-    double cbeta             = cos(beta * DEG2RAD);
-    double sbeta             = sin(beta * DEG2RAD);
     double detection_distance = m_min_detection_distance;
 
     if (m_enable_dynamic_max_distance)
@@ -225,36 +292,6 @@ bool obstacles_class::check_obstacles_in_path(std::vector<LaserMeasurementData>&
     if (detection_distance<m_min_detection_distance)
         detection_distance = m_min_detection_distance;
 
-    //these coordinates are in the robot reference frame
-#if 1
-    vx[0] = 0; vy[0] = +m_robot_radius;
-    vx[1] = 0; vy[1] = -m_robot_radius;
-    vx[2] = detection_distance; vy[2] = -m_robot_radius;
-    vx[3] = detection_distance; vy[3] = +m_robot_radius;
-#else
-    vx[0] = m_robot_radius; vy[0] = +m_robot_radius;
-    vx[1] = m_robot_radius; vy[1] = -m_robot_radius;
-    vx[2] = detection_distance; vy[2] = -m_robot_radius;
-    vx[3] = detection_distance; vy[3] = +m_robot_radius;
-#endif
-
-    //rotate the detection area according to the desired robot trajectory
-    vertx[0] = vx[0] * cbeta + vy[0] * (-sbeta);
-    verty[0] = vx[0] * sbeta + vy[0] * cbeta;
-    vertx[1] = vx[1] * cbeta + vy[1] * (-sbeta);
-    verty[1] = vx[1] * sbeta + vy[1] * cbeta;
-    vertx[2] = vx[2] * cbeta + vy[2] * (-sbeta);
-    verty[2] = vx[2] * sbeta + vy[2] * cbeta;
-    vertx[3] = vx[3] * cbeta + vy[3] * (-sbeta);
-    verty[3] = vx[3] * sbeta + vy[3] * cbeta;
-
-#if 0
-    yDebug() << beta << "(" << vertx[0] << verty[0] << ")"
-    << "(" << vertx[1] << verty[1] << ")"
-    << "(" << vertx[2] << verty[2] << ")"
-    << "(" << vertx[3] << verty[3] << ")";
-#endif
-
     size_t las_size = laser_data.size();
 
     if (las_size == 0)
@@ -263,51 +300,33 @@ bool obstacles_class::check_obstacles_in_path(std::vector<LaserMeasurementData>&
         return false;
     }
 
-    /*
-    //this piece of code checks that laser is expressed in the same robot reference frame
-    laser_data.clear();
-    LaserMeasurementData m;
-    m.set_polar(1, 1.5707);
-    double xx, yy;
-    m.get_cartesian(xx, yy); yDebug() << xx << yy;
-    laser_data.push_back(m);
-    */
+    //the detection area (a rectangle of width 2*robot_radius and length detection_distance, rotated according to
+    //the desired robot trajectory) is precomputed as the maximum range of each beam inside it
+    update_envelope(laser_data);
+    const std::vector<float>& limits = envelope_limits(beta, detection_distance);
 
     for (size_t i = 0; i < las_size; i++)
     {
         double d = 0;
         double angle = 0;
         laser_data[i].get_polar(d, angle);
+        m_ranges[i] = (float)d;
+    }
 
-        if (d < m_robot_radius)
-        {
-            laser_obstacles++;
-            if (yarp::os::Time::now() - last_time_error_message > 0.3)
-            {
-                yCError(GOTO_OBSTACLES,"obstacles on the platform");
-                last_time_error_message = yarp::os::Time::now();
-            }
-            continue;
-        }
+    int platform_obstacles = 0;
+    float radius = (float)m_robot_radius;
+    for (size_t i = 0; i < las_size; i++)
+    {
+        platform_obstacles += (m_ranges[i] < radius) ? 1 : 0;
+        laser_obstacles += (m_ranges[i] < radius || m_ranges[i] < limits[i]) ? 1 : 0;
+    }
 
-        double px = 0;
-        double py = 0;
-        //laser scans are in the robot reference frame
-        laser_data[i].get_cartesian(px, py);
-        //vertx and verty  are in the robot reference frame
-        if (pnpoly(4,vertx,verty,px,py)>0)
+    if (platform_obstacles > 0)
+    {
+        if (yarp::os::Time::now() - last_time_error_message > 0.3)
         {
-            if (d < goal_distance)
-            {
-                laser_obstacles++;
-                //yCError("obstacles on the path");
-                continue;
-            }
-            else
-            {
-                //yCError("obstacles on the path, but goal is near");
-                continue;
-            }
+            yCError(GOTO_OBSTACLES,"obstacles on the platform");
+            last_time_error_message = yarp::os::Time::now();
         }
     }
 
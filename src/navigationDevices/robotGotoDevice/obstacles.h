@@ -40,6 +40,7 @@
 #include <yarp/os/LogStream.h>
 #include <yarp/dev/INavigation2D.h>
 #include <string>
+#include <vector>
 #include <math.h>
 #include <mutex>
 #include <yarp/rosmsg/visualization_msgs/MarkerArray.h>
@@ -63,6 +64,22 @@ private:
     double m_robot_laser_t;       //deg
 
     double m_last_print_time;
+
+    //collision envelope of the detection rectangle, see update_envelope()
+    //for each beam i and each discretised direction beta, the rectangle covers the ranges smaller than
+    //min(detection_distance * m_envelope_depth_factor[i], m_envelope_lateral_limit[i])
+    struct envelope_row
+    {
+        std::vector<float> depth_factor;
+        std::vector<float> lateral_limit;
+    };
+    std::vector<envelope_row> m_envelope;                 //one row per direction, computed on first use
+    std::vector<double>       m_envelope_beam_angles;     //rad
+    double                    m_envelope_robot_radius;    //m
+    std::vector<float>        m_ranges;                   //m, the ranges of the current scan
+    std::vector<float>        m_envelope_limits;          //m, the limits currently in use
+    int                       m_envelope_limits_row;      //2*k for the row k, 2*k+1 between the rows k and k+1
+    double                    m_envelope_limits_distance; //m
 public:
     //obstacles avoidance stop block
     double               m_max_obstacle_distance;
@@ -92,15 +109,26 @@ public:
 
 private:
     /**
-    * Checks if a point is inside a n-sided polygons.
-    * @param testx x-coordinate of the point to be tested
-    * @param testy y-coordinate of the point to be tested
-    * @param nvert the number of vertices of the polygon
-    * @param vertx an array of size nvert containing the x-coordinates of all vertices
-    * @param verty an array of size nvert containing the y-coordinates of all vertices
-    * @return true if the requested point is inside the polygon, false otherwise
+    * Invalidates the collision envelope if the beams of the laser or the robot geometry changed since it was computed.
+    * The angle of each beam is assumed to depend only on its index (i.e. on the configuration of the rangefinder).
+    * @param laser_data the current laser scan
+    */
+    void update_envelope(std::vector<LaserMeasurementData>& laser_data);
+
+    /**
+    * Returns the row of the collision envelope of a discretised direction, computing it on first use.
+    * @param k the index of the direction, from 0 (-180 deg) to ENVELOPE_DIRECTIONS-1
+    */
+    const envelope_row& envelope_row_at(int k);
+
+    /**
+    * Returns, for each beam, the maximum range of an obstacle inside the detection rectangle.
+    * If beta falls between two discretised directions, the limits cover the rectangles of both.
+    * The limits are recomputed only when the discretised directions or the detection distance change.
+    * @param beta the direction (in degrees) in which the robot wants to move, in the robot reference frame
+    * @param detection_distance the length of the detection rectangle (m)
     */
-    int pnpoly(int nvert, double *vertx, double *verty, double testx, double testy);
+    const std::vector<float>& envelope_limits(double beta, double detection_distance);
 };
 
 #endif
@@ -35,6 +35,7 @@
 #include <yarp/math/Math.h>
 #include <yarp/math/Quaternion.h>
 #include <algorithm>
+#include <chrono>
 
 #include "robotGotoDev.h"
 #include "obstacles.h"
@@ -62,6 +63,33 @@ std::string getStatusAsString(NavigationStatusEnum status)
     return std::string("unknown");
 }
 
+laser_event_handler::laser_event_handler()
+{
+    m_received_scans = 0;
+    m_consumed_scans = 0;
+    m_last_scan_stamp = 0;
+}
+
+void laser_event_handler::onRead(yarp::os::Bottle& /*scan*/)
+{
+    //the content of the scan is not needed here, only its timestamp
+    yarp::os::Stamp stamp;
+    bool stamp_ok = getEnvelope(stamp) && stamp.isValid();
+    std::lock_guard<std::mutex> lock(m_event_mutex);
+    m_last_scan_stamp = stamp_ok ? stamp.getTime() : 0;
+    m_received_scans++;
+    m_event_cond.notify_one();
+}
+
+bool laser_event_handler::waitForScan(double timeout, double& stamp)
+{
+    std::unique_lock<std::mutex> lock(m_event_mutex);
+    bool received = m_event_cond.wait_for(lock, std::chrono::duration<double>(timeout), [this] { return m_received_scans != m_consumed_scans; });
+    m_consumed_scans = m_received_scans;
+    stamp = m_last_scan_stamp;
+    return received;
+}
+
 GotoThread::GotoThread(double _period, Searchable &_cfg) :
     PeriodicThread(_period),
             m_cfg(_cfg)
@@ -69,18 +97,21 @@ GotoThread::GotoThread(double _period, Searchable &_cfg) :
     yarp::os::Time::now();
     m_status = navigation_status_idle;
     m_obstacle_handler = 0;
+    m_dwa_planner = 0;
     m_loc_timeout_counter = TIMEOUT_MAX;
     m_las_timeout_counter = TIMEOUT_MAX;
     m_retreat_starting_time = 0;
     m_retreat_duration_time = 0;
     m_enable_obstacles_emergency_stop = false;
     m_enable_obstacles_avoidance = false;
+    m_enable_dwa_local_planner = false;
     m_enable_retreat = false;
     m_retreat_duration_default = 0.3;
     m_control_out.zero();
     m_pause_start = 0;
     m_pause_duration = 0;
     m_iLaser = 0;
+    m_iLaserTimed = 0;
     m_iLoc = 0;
     m_min_laser_angle = 0;
     m_max_laser_angle = 0;
@@ -89,6 +120,11 @@ GotoThread::GotoThread(double _period, Searchable &_cfg) :
     m_robot_laser_y = 0;
     m_robot_laser_t = 0;
     m_rosNode = 0;
+    m_event_driven = false;
+    m_watchdog_period = 0.05;
+    m_watchdog_cycles = 0;
+    m_last_laser_stamp = 0;
+    m_port_laser_event = 0;
     m_stats_time_curr = yarp::os::Time::now();
     m_stats_time_last = yarp::os::Time::now();
 }
@@ -287,6 +323,18 @@ bool GotoThread::threadInit()
     if (btmp.check("enable_obstacles_avoidance", Value(0)).asInt() == 1)
         m_enable_obstacles_avoidance = true;
 
+    btmp = m_cfg.findGroup("DWA_LOCAL_PLANNER");
+    if (btmp.check("enable_dwa_local_planner", Value(0)).asInt() == 1)
+        m_enable_dwa_local_planner = true;
+
+    //the local planner is always created, so that it can be enabled at runtime
+    m_dwa_planner = new dwa_local_planner(m_cfg, getPeriod());
+    if (m_dwa_planner->start() == false)
+    {
+        yCError(GOTO_CTRL) << "Unable to start the local planner";
+        return false;
+    }
+
     btmp = m_cfg.findGroup("OBSTACLES_EMERGENCY_STOP");
     if (btmp.check("enable_obstacles_emergency_stop", Value(0)).asInt() == 1)
         m_enable_obstacles_emergency_stop = true;
@@ -384,6 +432,41 @@ bool GotoThread::threadInit()
 
     m_laser_angle_of_view = fabs(m_min_laser_angle) + fabs(m_max_laser_angle);
 
+    //event-driven mode: an additional port receives the scans streamed by the laser server, in order to wake up the control loop
+    if (general_group.check("event_driven"))    { m_event_driven = general_group.find("event_driven").asBool(); }
+    if (general_group.check("watchdog_period")) { m_watchdog_period = general_group.find("watchdog_period").asDouble(); }
+    //by default the streaming port of the laser server is the one used by the Rangefinder2DClient
+    string laser_event_source = laser_remote_port;
+    if (general_group.check("laser_event_port")) { laser_event_source = general_group.find("laser_event_port").asString(); }
+    if (m_event_driven)
+    {
+        if (m_watchdog_period <= 0)
+        {
+            yCError(GOTO_CTRL) << "Invalid watchdog_period parameter:" << m_watchdog_period;
+            return false;
+        }
+        //the timestamps of the scans are used to check that the laser client received the scan which woke up the control loop
+        m_pLas.view(m_iLaserTimed);
+        if (m_iLaserTimed == 0)
+        {
+            yCError(GOTO_CTRL) << "Unable to obtain the timestamps of the laser scans, required by the event-driven mode";
+            return false;
+        }
+        m_port_laser_event = new laser_event_handler;
+        m_port_laser_event->useCallback();
+        if (m_port_laser_event->open(localName + "/laserEvent:i") == false)
+        {
+            yCError(GOTO_CTRL) << "Unable to open the laser event port";
+            return false;
+        }
+        if (yarp::os::Network::connect(laser_event_source, localName + "/laserEvent:i", "udp", false) == false)
+        {
+            yCError(GOTO_CTRL) << "Unable to connect the laser event port to" << laser_event_source;
+            return false;
+        }
+        yCInfo(GOTO_CTRL) << "Event-driven mode enabled, watchdog period:" << m_watchdog_period << "s";
+    }
+
     //automatic connections for debug
     bool autoconnect = false;
     if (general_group.check("autoconnect")) { autoconnect = general_group.find("autoconnect").asBool(); }
@@ -420,6 +503,14 @@ void GotoThread::threadRelease()
     m_port_gui_output.interrupt();
     m_port_gui_output.close();
 
+    if (m_port_laser_event)
+    {
+        m_port_laser_event->interrupt();
+        m_port_laser_event->close();
+        delete m_port_laser_event;
+        m_port_laser_event = 0;
+    }
+
     m_rosGoalInputPort.interrupt();
     m_rosGoalInputPort.close();
 
@@ -437,6 +528,13 @@ void GotoThread::threadRelease()
         delete m_obstacle_handler;
         m_obstacle_handler = 0;
     }
+
+    if (m_dwa_planner)
+    {
+        m_dwa_planner->stop();
+        delete m_dwa_planner;
+        m_dwa_planner = 0;
+    }
 }
 
 bool GotoThread::evaluateLocalization()
@@ -486,6 +584,7 @@ void GotoThread::getLaserData()
     if (ret)
     {
         m_las_timeout_counter = 0;
+        if (m_iLaserTimed) m_last_laser_stamp = m_iLaserTimed->getLastInputStamp().getTime();
     }
     else
     {
@@ -494,6 +593,20 @@ void GotoThread::getLaserData()
     }
 }
 
+bool GotoThread::waitForLaserData(double event_stamp, double deadline)
+{
+    //the scan received by the event port may still be in transit towards the laser client. If the laser server does not send
+    //the timestamps, the check is not possible and the last scan received by the laser client is used.
+    if (event_stamp <= 0) return true;
+    while (true)
+    {
+        double stamp = m_iLaserTimed->getLastInputStamp().getTime();
+        if (stamp > m_last_laser_stamp && stamp >= event_stamp) return true;
+        if (yarp::os::Time::now() >= deadline) return false;
+        yarp::os::Time::delay(0.001);
+    }
+}
+
 void GotoThread::publishCurrentGoal()
 {
     if (!m_publishRosStuff)
@@ -658,6 +771,19 @@ void GotoThread::saturateRobotControls()
 
 void GotoThread::run()
 {
+    //in event-driven mode the cycle starts as soon as a new scan is received. The period of the thread is then
+    //the minimum interval between two cycles, while the watchdog guarantees a minimum rate of the commands.
+    if (m_port_laser_event)
+    {
+        double deadline = yarp::os::Time::now() + m_watchdog_period;
+        double event_stamp = 0;
+        if (m_port_laser_event->waitForScan(m_watchdog_period, event_stamp) == false ||
+            waitForLaserData(event_stamp, deadline) == false)
+        {
+            m_watchdog_cycles++;
+        }
+    }
+
     double m_stats_time_curr = yarp::os::Time::now();
     if (m_stats_time_curr - m_stats_time_last > 5.0)
     {
@@ -685,7 +811,10 @@ void GotoThread::run()
     evaluateLocalization();
     getLaserData();
 
-    //computes the control action
+    //computes the control action. The previous command is the center of the dynamic window of the local planner
+    dwa_local_planner::command_type previous_command;
+    previous_command.linear_vel = m_control_out.linear_vel * cos(m_control_out.linear_dir * DEG2RAD);
+    previous_command.angular_vel = m_control_out.angular_vel;
     m_control_out.zero();
 
     //gamma is the angle between the current robot heading and the target heading
@@ -708,10 +837,22 @@ void GotoThread::run()
     
     //check for obstacles, always performed
     bool obstacles_in_path = false;
+    bool dwa_command_valid = false;
+    dwa_local_planner::command_type dwa_command = { 0, 0 };
     if (m_las_timeout_counter < 300)
     {
-        obstacles_in_path = m_obstacle_handler->check_obstacles_in_path(m_laser_data, beta_robot);
-        if (m_enable_obstacles_avoidance)  m_obstacle_handler->compute_obstacle_avoidance(m_laser_data);
+        if (m_enable_dwa_local_planner && (m_status == navigation_status_moving || m_status == navigation_status_waiting_obstacle))
+        {
+            //the rollouts of the local planner already avoid the obstacles, so the path is blocked only if
+            //the robot cannot move forward along any collision-free rollout
+            obstacles_in_path = !m_dwa_planner->compute(m_laser_data, distance, beta_robot, previous_command, m_max_lin_speed, m_max_ang_speed, getPeriod(), dwa_command);
+            dwa_command_valid = true;
+        }
+        else
+        {
+            obstacles_in_path = m_obstacle_handler->check_obstacles_in_path(m_laser_data, beta_robot);
+            if (m_enable_obstacles_avoidance)  m_obstacle_handler->compute_obstacle_avoidance(m_laser_data);
+        }
     }
 
     double current_time = yarp::os::Time::now();
@@ -773,8 +914,17 @@ void GotoThread::run()
             }
             else // you are far from the goal
             {
+                //the local planner is used only if the laser data are valid, otherwise the proportional controller is used
+                if (dwa_command_valid)
+                {
+                    //===========================
+                    m_control_out.linear_vel = dwa_command.linear_vel;
+                    m_control_out.linear_dir = 0.0;
+                    m_control_out.angular_vel = dwa_command.angular_vel;
+                    //===========================
+                }
                 //your heading is almost facing the goal, thus move forward
-                if (fabs(beta_robot) < m_beta_angle_threshold)
+                else if (fabs(beta_robot) < m_beta_angle_threshold)
                 {
                     if (m_robot_is_holonomic)
                     {
@@ -997,6 +1147,64 @@ bool GotoThread::getCurrentRelTarget(Map2DLocation& target)
     return true; 
 }
 
+double* GotoThread::getControllerParameter(const string& name)
+{
+    if      (name == "linear_tol")     return &m_goal_tolerance_lin;
+    else if (name == "angular_tol")    return &m_goal_tolerance_ang;
+    else if (name == "max_lin_speed")  return &m_max_lin_speed;
+    else if (name == "max_ang_speed")  return &m_max_ang_speed;
+    else if (name == "min_lin_speed")  return &m_min_lin_speed;
+    else if (name == "min_ang_speed")  return &m_min_ang_speed;
+    else if (name == "lin_speed_gain") return &m_gain_lin;
+    else if (name == "ang_speed_gain") return &m_gain_ang;
+    return nullptr;
+}
+
+bool GotoThread::setControllerProfile(const string& name, const Bottle& params)
+{
+    std::vector<std::pair<double*, double> > profile;
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        Bottle* param = params.get(i).asList();
+        if (param == nullptr || param->size() != 2)
+        {
+            yCError(GOTO_CTRL) << "Invalid parameter" << params.get(i).toString() << "in profile" << name;
+            return false;
+        }
+        double* address = getControllerParameter(param->get(0).asString());
+        if (address == nullptr)
+        {
+            yCError(GOTO_CTRL) << "Unknown parameter" << param->get(0).asString() << "in profile" << name;
+            return false;
+        }
+        profile.push_back(std::make_pair(address, param->get(1).asDouble()));
+    }
+
+    m_mutex.wait();
+    m_controller_profiles[name] = profile;
+    m_mutex.post();
+    yCDebug(GOTO_CTRL) << "Controller profile" << name << "stored:" << params.toString();
+    return true;
+}
+
+bool GotoThread::useControllerProfile(const string& name)
+{
+    m_mutex.wait();
+    auto it = m_controller_profiles.find(name);
+    if (it == m_controller_profiles.end())
+    {
+        m_mutex.post();
+        yCError(GOTO_CTRL) << "Unknown controller profile" << name;
+        return false;
+    }
+    for (auto p = it->second.begin(); p != it->second.end(); p++)
+    {
+        *(p->first) = p->second;
+    }
+    m_mutex.post();
+    return true;
+}
+
 void GotoThread::resetParamsToDefaultValue()
 {
     //resets internal variables to default value
@@ -1123,5 +1331,6 @@ void GotoThread::printStats()
     yCDebug(GOTO_CTRL, "* robotGoto thread:");
     yCDebug(GOTO_CTRL, "loc timeouts: %d", m_loc_timeout_counter);
     yCDebug(GOTO_CTRL, "las timeouts: %d", m_las_timeout_counter);
+    if (m_event_driven) yCDebug(GOTO_CTRL, "watchdog cycles: %zu", m_watchdog_cycles);
     yCDebug(GOTO_CTRL,"status: %s", getStatusAsString(m_status).c_str());
 }
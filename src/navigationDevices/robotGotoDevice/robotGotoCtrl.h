@@ -35,6 +35,7 @@
 #include <yarp/os/RateThread.h>
 #include <yarp/os/Semaphore.h>
 #include <yarp/dev/IRangefinder2D.h>
+#include <yarp/dev/IPreciselyTimed.h>
 #include <yarp/os/Log.h>
 #include <yarp/dev/IFrameTransform.h>
 #include <yarp/os/LogStream.h>
@@ -42,10 +43,14 @@
 #include <string>
 #include <math.h>
 #include <mutex>
+#include <condition_variable>
+#include <map>
+#include <vector>
 #include <yarp/rosmsg/visualization_msgs/MarkerArray.h>
 #include <yarp/rosmsg/geometry_msgs/PoseStamped.h>
 #include <yarp/rosmsg/nav_msgs/Path.h>
 #include "obstacles.h"
+#include "localPlanner.h"
 
 using namespace std;
 using namespace yarp::os;
@@ -63,6 +68,34 @@ typedef yarp::os::Publisher<yarp::rosmsg::nav_msgs::Path>              rosPathPu
 const double RAD2DEG  = 180.0/M_PI;
 const double DEG2RAD  = M_PI/180.0;
 
+/**
+* A port connected to the streaming port of the laser server, used only to wake up the control loop when a new scan is available
+* (see GotoThread::m_event_driven). The scan itself is still read through the IRangefinder2D interface, which receives it on a different
+* connection: the timestamp of the event is used to check that the interface already received the same scan.
+*/
+class laser_event_handler : public BufferedPort<yarp::os::Bottle>
+{
+    std::mutex              m_event_mutex;
+    std::condition_variable m_event_cond;
+    size_t                  m_received_scans;
+    size_t                  m_consumed_scans;
+    double                  m_last_scan_stamp;
+
+public:
+    laser_event_handler();
+
+    using BufferedPort<yarp::os::Bottle>::onRead;
+    void onRead(yarp::os::Bottle& scan) override;
+
+    /**
+    * Waits until a scan is received. Returns immediately if a scan was received after the previous call.
+    * @param timeout the maximum waiting time (s)
+    * @param stamp the timestamp of the last received scan, 0 if the laser server does not send the timestamps
+    * @return true if a new scan was received, false if the timeout expired
+    */
+    bool waitForScan(double timeout, double& stamp);
+};
+
 struct target_type
 {
     yarp::dev::Nav2D::Map2DLocation target;
@@ -84,6 +117,7 @@ public:
     bool   m_robot_is_holonomic;
     bool   m_enable_obstacles_emergency_stop;
     bool   m_enable_obstacles_avoidance;
+    bool   m_enable_dwa_local_planner;
     double m_robot_radius;        //m
     double m_robot_laser_x;       //m
     double m_robot_laser_y;       //m
@@ -114,6 +148,12 @@ public:
     double m_default_approach_direction;
     double m_default_approach_speed;
 
+    //event-driven mode: the control cycle starts when a new laser scan is received, or after m_watchdog_period at most
+    bool   m_event_driven;
+    double m_watchdog_period;     //s
+    size_t m_watchdog_cycles;     //the cycles started by the watchdog instead of a new scan
+    double m_last_laser_stamp;    //the timestamp of the last scan read through m_iLaser
+
     //watchdogs for data received from external sources
     double m_stats_time_last;
     double m_stats_time_curr;
@@ -133,6 +173,7 @@ protected:
     PolyDriver                      m_pLas;
     PolyDriver                      m_pLoc;
     IRangefinder2D*                 m_iLaser;
+    IPreciselyTimed*                m_iLaserTimed;
     Nav2D::ILocalization2D*         m_iLoc;
 
     //yarp ports
@@ -141,6 +182,7 @@ protected:
     BufferedPort<yarp::os::Bottle>  m_port_status_output;
     BufferedPort<yarp::os::Bottle>  m_port_speak_output;
     BufferedPort<yarp::os::Bottle>  m_port_gui_output;
+    laser_event_handler*            m_port_laser_event;
 
     //ROS topics
     yarp::os::Node*                 m_rosNode;
@@ -172,6 +214,12 @@ protected:
     //obstacle handler
     obstacles_class*     m_obstacle_handler;
 
+    //local planner, used instead of the proportional controller if m_enable_dwa_local_planner is set
+    dwa_local_planner*   m_dwa_planner;
+
+    //named sets of controller parameters (see setControllerProfile()). Each entry stores the address of the parameter and its value
+    std::map<string, std::vector<std::pair<double*, double> > > m_controller_profiles;
+
     //internal type definition to store control output
     struct
     {
@@ -232,6 +280,24 @@ public:
     * defined in the configuration files.
     */
     void          resetParamsToDefaultValue();
+
+    /**
+    * Stores a named set of controller parameters (speed limits, gains, tolerances), which can be later applied with a single
+    * useControllerProfile() call. A profile with the same name is replaced.
+    * @param name the name of the profile
+    * @param params a list of (param value) pairs. Valid params are: linear_tol, angular_tol, max_lin_speed, max_ang_speed,
+    * min_lin_speed, min_ang_speed, lin_speed_gain, ang_speed_gain.
+    * @return true if the profile is valid, false otherwise (the profile is not stored)
+    */
+    bool          setControllerProfile(const string& name, const yarp::os::Bottle& params);
+
+    /**
+    * Applies all the parameters of a profile previously stored with setControllerProfile(). The parameters are changed atomically
+    * with respect to the control loop.
+    * @param name the name of the profile
+    * @return true if the profile exists, false otherwise
+    */
+    bool          useControllerProfile(const string& name);
     
     /**
     * Terminates a previously started navigation task.
@@ -311,6 +377,14 @@ private:
     * Obtains laser data through a IRangefinder2D interface.
     */
     void getLaserData();
+
+    /**
+    * In event-driven mode, waits until the IRangefinder2D interface receives the scan which woke up the control loop.
+    * @param event_stamp the timestamp of the scan received by the event port
+    * @param deadline the time at which the waiting is interrupted, even if the scan was not received
+    * @return true if the scan was received, false if the deadline expired
+    */
+    bool waitForLaserData(double event_stamp, double deadline);
     
     /**
     * Publishes the current goal on the dedicated ROS topic.
@@ -327,6 +401,12 @@ private:
     */
     void saturateRobotControls();
 
+    /**
+    * Returns the address of a controller parameter, given the name used by the 'set' rpc command.
+    * @return nullptr if the name is not valid
+    */
+    double* getControllerParameter(const string& name);
+
 };
 
 #endif
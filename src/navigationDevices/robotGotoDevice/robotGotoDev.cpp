@@ -172,6 +172,19 @@ bool robotGotoDev  ::parse_respond_string(const yarp::os::Bottle& command, yarp:
                 reply.addString("enable_obstacles_avoidance=true");
             }
         }
+        else if (command.get(1).asString() == "dwa_local_planner")
+        {
+            if (command.get(2).asInt() == 0)
+            {
+                reply.addString("enable_dwa_local_planner=false");
+                gotoThread->m_enable_dwa_local_planner = false;
+            }
+            else
+            {
+                gotoThread->m_enable_dwa_local_planner = true;
+                reply.addString("enable_dwa_local_planner=true");
+            }
+        }
         else if (command.get(1).asString() == "obstacle_stop")
         {
             if (command.get(2).asInt()==0)
@@ -190,6 +203,34 @@ bool robotGotoDev  ::parse_respond_string(const yarp::os::Bottle& command, yarp:
             reply.addString("Unknown set.");
         }
     }
+    else if (command.get(0).asString() == "set_profile")
+    {
+        //set_profile <name> (param value) (param value) ...
+        Bottle params;
+        for (size_t i = 2; i < command.size(); i++)
+        {
+            params.add(command.get(i));
+        }
+        if (gotoThread->setControllerProfile(command.get(1).asString(), params))
+        {
+            reply.addString("ok");
+        }
+        else
+        {
+            reply.addString("Invalid profile.");
+        }
+    }
+    else if (command.get(0).asString() == "use_profile")
+    {
+        if (gotoThread->useControllerProfile(command.get(1).asString()))
+        {
+            reply.addString("ok");
+        }
+        else
+        {
+            reply.addString("Unknown profile.");
+        }
+    }
     else if (command.get(0).asString() == "get")
     {
         if (command.get(1).asString() == "navigation_status")
@@ -314,6 +355,7 @@ bool robotGotoRPCHandler::respond(const yarp::os::Bottle& command, yarp::os::Bot
         reply.addString("set min_ang_speed <deg/s>");
         reply.addString("set obstacle_stop <0/1>");
         reply.addString("set obstacle_avoidance <0/1>");
+        reply.addString("set dwa_local_planner <0/1>");
     }
     else if (command.get(0).isString())
     {
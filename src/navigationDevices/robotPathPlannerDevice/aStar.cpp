@@ -70,7 +70,7 @@ namespace aStar_algorithm
     {
         public:
         node_map_type();
-        node_map_type(yarp::dev::Nav2D::MapGrid2D& map);
+        node_map_type(yarp::dev::Nav2D::MapGrid2D& map, const std::vector<float>* cell_costs);
         ~node_map_type();
 
         public:
@@ -120,7 +120,7 @@ bool aStar_algorithm::operator < (const node_type &a, const node_type &b)
 }
 
 /////////// node_map_type
-aStar_algorithm::node_map_type::node_map_type(MapGrid2D& map)
+aStar_algorithm::node_map_type::node_map_type(MapGrid2D& map, const std::vector<float>* cell_costs)
 {
     w = map.width();
     h = map.height();
@@ -138,12 +138,11 @@ aStar_algorithm::node_map_type::node_map_type(MapGrid2D& map)
                 nodes [x][y].y = y;
                 //--- ---
                 //s_score is disabled by default.
-                //it is can be associated to a particular color code, to generate
+                //it is can be associated to a per-cell cost, to generate
                 //smooth trajectories,i.e.: keep the robot away from walls, using
-                //map skeletonization. The algorithm performances are still to be checked.
-                //nodes [x][y].s_score = 230-imgMat.at<cv::Vec3b>(y,x)[1];
+                //the clearance field of the map (see distanceTransform_algorithm::clearance_map::cost_layer())
                 //--- ---
-                nodes [x][y].s_score = 0;
+                nodes [x][y].s_score = cell_costs ? (*cell_costs)[y * w + x] : 0;
             }
 }
 
@@ -209,11 +208,16 @@ bool aStar_algorithm::unordered_set_type::find(node_type t)
 }
 
 /////////// various
-bool aStar_algorithm::find_astar_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path)
+bool aStar_algorithm::find_astar_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path, const std::vector<float>* cell_costs)
 {
     //implementation of A* algorithm
     std::vector<XYCell> inverse_path;
-    node_map_type node_map(map);
+    if (cell_costs && cell_costs->size() != map.width() * map.height())
+    {
+        yCError(PATHPLAN_ASTAR) << "the size of the cell costs does not match the size of the map";
+        return false;
+    }
+    node_map_type node_map(map, cell_costs);
     int sx=start.x;
     int sy=start.y;
     int gx=goal.x;
@@ -33,9 +33,10 @@ namespace aStar_algorithm
     * @param start the start cell(x,y)
     * @param goal the arrival cell(x,y)
     * @param path the computed sequence of cells required to go from  start cell to goal cell
+    * @param cell_costs an optional additional cost of each cell (row-major, w*h elements), used as s_score
     * @return true if the path exists, false if no valid path has been found
     */
-    bool find_astar_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path);
+    bool find_astar_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, const std::vector<float>* cell_costs = nullptr);
 };
 
 #endif
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <stdlib.h>
+#include <algorithm>
+#include "aStarIndexed.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+
+YARP_LOG_COMPONENT(PATHPLAN_ASTAR_INDEXED, "navigation.devices.robotPathPlanner.aStarIndexed")
+
+namespace
+{
+    //the eight moves of a 8-connected grid, with their associated costs
+    const int    neighbor_dx[8]   = { 0,  0, 1, -1,  1,  1, -1, -1 };
+    const int    neighbor_dy[8]   = { 1, -1, 0,  0,  1, -1,  1, -1 };
+    const double neighbor_cost[8] = { 10, 10, 10, 10, 14, 14, 14, 14 };
+    //the bit of each move inside planning_grid::neighbor_mask()
+    const unsigned int neighbor_bit[8] = { 1u << 7, 1u << 1, 1u << 5, 1u << 3, 1u << 8, 1u << 2, 1u << 6, 1u << 0 };
+
+    //the search, performed either on the map or on its packed copy (see planning_grid)
+    template <typename Grid>
+    bool astar_search(const Grid& grid, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws, const std::vector<float>* cell_costs)
+    {
+        size_t w = grid.width();
+        size_t h = grid.height();
+        if (cell_costs && cell_costs->size() != w * h)
+        {
+            yCError(PATHPLAN_ASTAR_INDEXED) << "the size of the cell costs does not match the size of the map";
+            return false;
+        }
+
+        //checks that start and goal cells are inside the grid map
+        if (start.x >= w || goal.x >= w) return false;
+        if (start.y >= h || goal.y >= h) return false;
+
+        //an occupied goal can never be reached, there is no need to explore the whole map to find it out
+        if (grid.is_free((int)goal.x, (int)goal.y) == false) return false;
+
+        ws.prepare(w, h);
+        cell_index_type start_index = ws.to_index(start);
+        cell_index_type goal_index = ws.to_index(goal);
+        int gx = (int)goal.x;
+        int gy = (int)goal.y;
+
+        ws.set_node(start_index, 0, INVALID_CELL_INDEX);
+        ws.open_set.push(start_index, aStarIndexed_algorithm::octile_distance((int)start.x, (int)start.y, gx, gy));
+
+        while (!ws.open_set.empty())
+        {
+            cell_index_type curr = ws.open_set.pop();
+            if (curr == goal_index)
+            {
+                return ws.reconstruct_path(start_index, goal_index, path);
+            }
+
+            ws.set_closed(curr);
+            ws.stats.expanded_nodes++;
+            if (ws.must_stop())
+            {
+                yCDebug(PATHPLAN_ASTAR_INDEXED) << "search interrupted after" << ws.stats.expanded_nodes << "expansions";
+                return false;
+            }
+
+            int cx = (int)(curr % w);
+            int cy = (int)(curr / w);
+            double curr_g = ws.g_score(curr);
+            if (cell_costs) curr_g += (*cell_costs)[curr];
+            unsigned int free_neighbors = grid.neighbor_mask(cx, cy);
+
+            for (size_t i = 0; i < 8; i++)
+            {
+                int nx = cx + neighbor_dx[i];
+                int ny = cy + neighbor_dy[i];
+                //cells outside the map are never free
+                if ((free_neighbors & neighbor_bit[i]) == 0) continue;
+
+                cell_index_type neighbor = ws.to_index(nx, ny);
+                if (ws.is_closed(neighbor)) continue;
+
+                double tentative_g_score = curr_g + neighbor_cost[i];
+                if (tentative_g_score < ws.g_score(neighbor))
+                {
+                    ws.set_node(neighbor, tentative_g_score, curr);
+                    double f_score = tentative_g_score + aStarIndexed_algorithm::octile_distance(nx, ny, gx, gy);
+                    if (ws.open_set.contains(neighbor)) ws.open_set.decrease_key(neighbor, f_score);
+                    else                                ws.open_set.push(neighbor, f_score);
+                }
+            }
+        }
+
+        //no path found
+        yCDebug(PATHPLAN_ASTAR_INDEXED) << "no path found after" << ws.stats.expanded_nodes << "expansions";
+        return false;
+    }
+}
+
+search_workspace& aStarIndexed_algorithm::default_workspace()
+{
+    static thread_local search_workspace workspace;
+    return workspace;
+}
+
+double aStarIndexed_algorithm::octile_distance(int x1, int y1, int x2, int y2)
+{
+    int dx = abs(x1 - x2);
+    int dy = abs(y1 - y2);
+    return 10.0 * std::max(dx, dy) + 4.0 * std::min(dx, dy);
+}
+
+bool aStarIndexed_algorithm::find_astar_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path)
+{
+    return find_astar_path(map, start, goal, path, default_workspace());
+}
+
+bool aStarIndexed_algorithm::find_astar_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws)
+{
+    return find_astar_path(map, start, goal, path, ws, nullptr);
+}
+
+bool aStarIndexed_algorithm::find_astar_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws, const std::vector<float>* cell_costs)
+{
+    return astar_search(map_grid_view(map), start, goal, path, ws, cell_costs);
+}
+
+bool aStarIndexed_algorithm::find_astar_path(const planning_grid& grid, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws, const std::vector<float>* cell_costs)
+{
+    return astar_search(grid, start, goal, path, ws, cell_costs);
+}
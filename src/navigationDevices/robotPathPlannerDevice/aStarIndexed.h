@@ -0,0 +1,73 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef A_STAR_INDEXED_H
+#define A_STAR_INDEXED_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <deque>
+#include "searchWorkspace.h"
+#include "planningGrid.h"
+
+//! namespace containing an implementation of the A* algorithm based on an indexed binary heap and a reusable workspace
+namespace aStarIndexed_algorithm
+{
+    /**
+    * This method computes (if exists) the path required to go from a start cell to a goal cell.
+    * It uses the same move costs (10 for straight moves, 14 for diagonal moves) of aStar_algorithm::find_astar_path(),
+    * but the search memory is kept in a per-thread workspace, reused across calls.
+    * @param map the gridmap containing the obstacles
+    * @param start the start cell(x,y)
+    * @param goal the arrival cell(x,y)
+    * @param path the computed sequence of cells required to go from  start cell to goal cell
+    * @return true if the path exists, false if no valid path has been found
+    */
+    bool find_astar_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path);
+
+    /**
+    * Same as above, using a workspace provided by the caller.
+    * @param workspace the search memory. After the call, workspace.stats contains the statistics of the search.
+    */
+    bool find_astar_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, planner_search::search_workspace& workspace);
+
+    /**
+    * Same as above, adding to each move the cost of the cell the move starts from (as the s_score of aStar_algorithm).
+    * @param cell_costs the additional cost of each cell (row-major, w*h elements), or nullptr
+    */
+    bool find_astar_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, planner_search::search_workspace& workspace, const std::vector<float>* cell_costs);
+
+    /**
+    * Same as above, reading the obstacles from the packed copy of the map (see planner_search::planning_grid).
+    * @param grid the traversability of the map, 1 bit per cell
+    */
+    bool find_astar_path(const planner_search::planning_grid& grid, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, planner_search::search_workspace& workspace, const std::vector<float>* cell_costs);
+
+    /**
+    * Returns the workspace used by the calling thread when no workspace is explicitly provided.
+    */
+    planner_search::search_workspace& default_workspace();
+
+    /**
+    * The octile distance between two cells, expressed with the same 10/14 costs used by the search.
+    * It is exact on an obstacle-free 8-connected grid, hence admissible and consistent.
+    */
+    double octile_distance(int x1, int y1, int x2, int y2);
+};
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <algorithm>
+#include <limits>
+#include "araStar.h"
+#include "aStarIndexed.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+using namespace araStar_algorithm;
+
+YARP_LOG_COMPONENT(PATHPLAN_ARASTAR, "navigation.devices.robotPathPlanner.araStar")
+
+namespace
+{
+    //the eight moves of a 8-connected grid, with their associated costs
+    const int    neighbor_dx[8]   = { 0,  0, 1, -1,  1,  1, -1, -1 };
+    const int    neighbor_dy[8]   = { 1, -1, 0,  0,  1, -1,  1, -1 };
+    const double neighbor_cost[8] = { 10, 10, 10, 10, 14, 14, 14, 14 };
+    //the bit of each move inside planning_grid::neighbor_mask()
+    const unsigned int neighbor_bit[8] = { 1u << 7, 1u << 1, 1u << 5, 1u << 3, 1u << 8, 1u << 2, 1u << 6, 1u << 0 };
+
+    //the search, performed either on the map or on its packed copy (see planning_grid)
+    template <typename Grid>
+    bool ara_search(const Grid& grid, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws, const std::vector<float>* cell_costs, const ara_parameters& parameters, double& epsilon, solution_callback on_solution)
+    {
+        size_t w = grid.width();
+        size_t h = grid.height();
+        if (cell_costs && cell_costs->size() != w * h)
+        {
+            yCError(PATHPLAN_ARASTAR) << "the size of the cell costs does not match the size of the map";
+            return false;
+        }
+
+        //checks that start and goal cells are inside the grid map
+        if (start.x >= w || goal.x >= w) return false;
+        if (start.y >= h || goal.y >= h) return false;
+
+        //an occupied goal can never be reached, there is no need to explore the whole map to find it out
+        if (grid.is_free((int)goal.x, (int)goal.y) == false) return false;
+
+        ws.prepare(w, h);
+        cell_index_type start_index = ws.to_index(start);
+        cell_index_type goal_index = ws.to_index(goal);
+        int gx = (int)goal.x;
+        int gy = (int)goal.y;
+        auto heuristic = [w, gx, gy](cell_index_type c) { return aStarIndexed_algorithm::octile_distance((int)(c % w), (int)(c / w), gx, gy); };
+
+        double eps = std::max(1.0, parameters.initial_epsilon);
+        ws.set_node(start_index, 0, INVALID_CELL_INDEX);
+        ws.open_set.push(start_index, eps * heuristic(start_index));
+
+        //the closed nodes whose g-score decreased during the current pass. They are expanded again by the next pass.
+        std::vector<cell_index_type> inconsistent;
+        std::vector<cell_index_type> pending;
+        bool found = false;
+        size_t pass = 0;
+        while (true)
+        {
+            //a pass is a weighted A*, which stops as soon as the goal cannot be improved with the current inflation factor
+            pass++;
+            while (!ws.open_set.empty() && ws.g_score(goal_index) > ws.open_set.top_key())
+            {
+                cell_index_type curr = ws.open_set.pop();
+                ws.set_closed(curr);
+                ws.stats.expanded_nodes++;
+                if (ws.must_stop())
+                {
+                    yCDebug(PATHPLAN_ARASTAR) << "search interrupted during pass" << pass << "after" << ws.stats.expanded_nodes << "expansions";
+                    return found;
+                }
+
+                int cx = (int)(curr % w);
+                int cy = (int)(curr / w);
+                double curr_g = ws.g_score(curr);
+                if (cell_costs) curr_g += (*cell_costs)[curr];
+                unsigned int free_neighbors = grid.neighbor_mask(cx, cy);
+
+                for (size_t i = 0; i < 8; i++)
+                {
+                    if ((free_neighbors & neighbor_bit[i]) == 0) continue;
+                    cell_index_type neighbor = ws.to_index(cx + neighbor_dx[i], cy + neighbor_dy[i]);
+
+                    double tentative_g_score = curr_g + neighbor_cost[i];
+                    if (tentative_g_score < ws.g_score(neighbor))
+                    {
+                        ws.set_node(neighbor, tentative_g_score, curr);
+                        if (ws.is_closed(neighbor)) inconsistent.push_back(neighbor);
+                        else                        ws.open_set.update(neighbor, tentative_g_score + eps * heuristic(neighbor));
+                    }
+                }
+            }
+
+            double goal_g = ws.g_score(goal_index);
+            if (goal_g == std::numeric_limits<double>::infinity())
+            {
+                //no path found (this can happen only during the first pass)
+                yCDebug(PATHPLAN_ARASTAR) << "no path found after" << ws.stats.expanded_nodes << "expansions";
+                return false;
+            }
+
+            //the nodes to be expanded by the next pass are the open ones and the inconsistent ones.
+            //Their lowest (non inflated) f-score is a lower bound of the optimal cost.
+            pending.clear();
+            while (!ws.open_set.empty()) pending.push_back(ws.open_set.pop());
+            pending.insert(pending.end(), inconsistent.begin(), inconsistent.end());
+            inconsistent.clear();
+            double lower_bound = goal_g;
+            for (auto it = pending.begin(); it != pending.end(); it++)
+            {
+                lower_bound = std::min(lower_bound, ws.g_score(*it) + heuristic(*it));
+            }
+            double bound = (lower_bound > 0) ? std::min(eps, goal_g / lower_bound) : 1.0;
+
+            std::deque<XYCell> solution;
+            if (ws.reconstruct_path(start_index, goal_index, solution) == false)
+            {
+                yCError(PATHPLAN_ARASTAR) << "unable to reconstruct the path computed during pass" << pass;
+                return found;
+            }
+            path = solution;
+            epsilon = bound;
+            found = true;
+            yCDebug(PATHPLAN_ARASTAR) << "pass" << pass << "(epsilon" << eps << ") found a path with suboptimality bound" << bound << "after" << ws.stats.expanded_nodes << "expansions";
+            if (on_solution) on_solution(path, epsilon);
+            if (bound <= 1.0 || parameters.epsilon_step <= 0) return true;
+
+            //next pass: lower inflation factor, the pending nodes are moved in the open set with the new keys
+            eps = std::max(1.0, std::min(eps, bound) - parameters.epsilon_step);
+            ws.clear_closed_set();
+            for (auto it = pending.begin(); it != pending.end(); it++)
+            {
+                ws.open_set.update(*it, ws.g_score(*it) + eps * heuristic(*it));
+            }
+        }
+    }
+}
+
+bool araStar_algorithm::find_ara_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws, const std::vector<float>* cell_costs, const ara_parameters& parameters, double& epsilon, solution_callback on_solution)
+{
+    return ara_search(map_grid_view(map), start, goal, path, ws, cell_costs, parameters, epsilon, on_solution);
+}
+
+bool araStar_algorithm::find_ara_path(const planning_grid& grid, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws, const std::vector<float>* cell_costs, const ara_parameters& parameters, double& epsilon, solution_callback on_solution)
+{
+    return ara_search(grid, start, goal, path, ws, cell_costs, parameters, epsilon, on_solution);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef ARA_STAR_H
+#define ARA_STAR_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include "searchWorkspace.h"
+#include "planningGrid.h"
+
+//! namespace containing an implementation of the Anytime Repairing A* algorithm (Likhachev, Gordon and Thrun, 2003)
+namespace araStar_algorithm
+{
+    struct ara_parameters
+    {
+        double initial_epsilon; //the inflation factor of the heuristic used by the first pass (>= 1)
+        double epsilon_step;    //the amount subtracted to the inflation factor after each pass (> 0)
+
+        ara_parameters() : initial_epsilon(3.0), epsilon_step(0.5) {}
+    };
+
+    /**
+    * Called each time a pass of the search produces a path.
+    * @param path the sequence of cells from the start cell (excluded) to the goal cell (included)
+    * @param epsilon the cost of the path is at most epsilon times the cost of the optimal path
+    */
+    typedef std::function<void(const std::deque<yarp::dev::Nav2D::XYCell>& path, double epsilon)> solution_callback;
+
+    /**
+    * This method computes (if exists) the path required to go from a start cell to a goal cell, as an anytime search.
+    * The first pass is a weighted A* (heuristic inflated by initial_epsilon), which quickly finds a bounded-suboptimal path.
+    * The following passes decrease the inflation factor and reuse the g-scores computed so far, re-expanding only the
+    * nodes whose cost changed. The search ends when a pass with epsilon = 1 completes (the path is optimal) or when
+    * the search_control of the workspace requests to stop: in this case the best path found so far is returned.
+    * It uses the same move costs (10 for straight moves, 14 for diagonal moves) of aStarIndexed_algorithm::find_astar_path().
+    * @param map the gridmap containing the obstacles
+    * @param start the start cell(x,y)
+    * @param goal the arrival cell(x,y)
+    * @param path the best computed sequence of cells required to go from start cell to goal cell
+    * @param workspace the search memory. After the call, workspace.stats contains the statistics of all the passes.
+    * @param cell_costs the additional cost of each cell (row-major, w*h elements), or nullptr
+    * @param parameters the inflation factors used by the passes
+    * @param epsilon the suboptimality bound of the returned path
+    * @param on_solution if not null, it is called at the end of each pass which produced a path
+    * @return true if a path has been found, false if no path exists or the search has been stopped before finding one
+    */
+    bool find_ara_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, planner_search::search_workspace& workspace, const std::vector<float>* cell_costs, const ara_parameters& parameters, double& epsilon, solution_callback on_solution = nullptr);
+
+    /**
+    * Same as above, reading the obstacles from the packed copy of the map (see planner_search::planning_grid).
+    * @param grid the traversability of the map, 1 bit per cell
+    */
+    bool find_ara_path(const planner_search::planning_grid& grid, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, planner_search::search_workspace& workspace, const std::vector<float>* cell_costs, const ara_parameters& parameters, double& epsilon, solution_callback on_solution = nullptr);
+};
+
+#endif
@@ -0,0 +1,280 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <limits>
+#include <algorithm>
+#include "dStarLite.h"
+#include "aStarIndexed.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+using namespace dStarLite_algorithm;
+
+YARP_LOG_COMPONENT(PATHPLAN_DSTAR, "navigation.devices.robotPathPlanner.dStarLite")
+
+namespace
+{
+    const int    neighbor_dx[8]   = { 0,  0, 1, -1,  1,  1, -1, -1 };
+    const int    neighbor_dy[8]   = { 1, -1, 0,  0,  1, -1,  1, -1 };
+    const double neighbor_cost[8] = { 10, 10, 10, 10, 14, 14, 14, 14 };
+    const float  INF = std::numeric_limits<float>::infinity();
+
+    //D* Lite keys are pairs [k1;k2] compared lexicographically. Since all the costs are integers,
+    //the pair can be packed in a single double (k1*KEY_SCALE+k2) which preserves the ordering
+    //as long as k2 < KEY_SCALE, i.e. paths shorter than ~80km on a 5cm grid.
+    const double KEY_SCALE = 16777216.0;
+}
+
+dstar_lite_planner::dstar_lite_planner()
+{
+    m_width = 0;
+    m_height = 0;
+    m_goal = INVALID_CELL_INDEX;
+    m_last_start = INVALID_CELL_INDEX;
+    m_km = 0;
+    m_initialized = false;
+    control = nullptr;
+    m_open_set.stats = &stats;
+}
+
+void dstar_lite_planner::reset()
+{
+    m_initialized = false;
+}
+
+bool dstar_lite_planner::is_initialized_for(const std::string& map_name, XYCell goal) const
+{
+    if (!m_initialized) return false;
+    if (map_name != m_map_name) return false;
+    if (goal.x >= m_width || goal.y >= m_height) return false;
+    return to_index(goal.x, goal.y) == m_goal;
+}
+
+bool dstar_lite_planner::initialize(const MapGrid2D& map, XYCell goal, const std::function<bool(const XYCell&)>& is_cell_free)
+{
+    m_initialized = false;
+    if (goal.x >= map.width() || goal.y >= map.height()) return false;
+
+    if (m_width != map.width() || m_height != map.height())
+    {
+        m_width = map.width();
+        m_height = map.height();
+        m_open_set.resize(m_width * m_height);
+    }
+    else
+    {
+        m_open_set.clear();
+    }
+    m_g.assign(m_width * m_height, INF);
+    m_rhs.assign(m_width * m_height, INF);
+    m_free.resize(m_width * m_height);
+    for (size_t y = 0; y < m_height; y++)
+        for (size_t x = 0; x < m_width; x++)
+            m_free[to_index(x, y)] = (is_cell_free ? is_cell_free(XYCell(x, y)) : map.isFree(XYCell(x, y))) ? 1 : 0;
+
+    m_map_name = map.getMapName();
+    m_goal = to_index(goal.x, goal.y);
+    m_last_start = INVALID_CELL_INDEX;
+    m_km = 0;
+    m_rhs[m_goal] = 0;
+    stats.clear();
+    m_initialized = true;
+    return true;
+}
+
+double dstar_lite_planner::heuristic(cell_index_type a, cell_index_type b) const
+{
+    return aStarIndexed_algorithm::octile_distance((int)(a % m_width), (int)(a / m_width), (int)(b % m_width), (int)(b / m_width));
+}
+
+double dstar_lite_planner::calculate_key(cell_index_type s, cell_index_type start) const
+{
+    double k2 = std::min(m_g[s], m_rhs[s]);
+    double k1 = k2 + heuristic(start, s) + m_km;
+    return k1 * KEY_SCALE + k2;
+}
+
+double dstar_lite_planner::min_successor_cost(cell_index_type s) const
+{
+    int sx = (int)(s % m_width);
+    int sy = (int)(s / m_width);
+    double best = INF;
+    for (size_t i = 0; i < 8; i++)
+    {
+        int nx = sx + neighbor_dx[i];
+        int ny = sy + neighbor_dy[i];
+        if (nx < 0 || ny < 0 || nx >= (int)m_width || ny >= (int)m_height) continue;
+        cell_index_type n = to_index(nx, ny);
+        if (!m_free[n]) continue;
+        double c = neighbor_cost[i] + m_g[n];
+        if (c < best) best = c;
+    }
+    return best;
+}
+
+void dstar_lite_planner::update_vertex(cell_index_type s, cell_index_type start)
+{
+    bool consistent = (m_g[s] == m_rhs[s]);
+    bool in_open_set = m_open_set.contains(s);
+    if (!consistent)
+    {
+        m_open_set.update(s, calculate_key(s, start));
+    }
+    else if (in_open_set)
+    {
+        m_open_set.remove(s);
+    }
+}
+
+void dstar_lite_planner::update_neighbors_of(cell_index_type s)
+{
+    //the cells whose rhs depends on g(s) or on the traversability of s are the 8 neighbors of s
+    int sx = (int)(s % m_width);
+    int sy = (int)(s / m_width);
+    for (size_t i = 0; i < 8; i++)
+    {
+        int nx = sx + neighbor_dx[i];
+        int ny = sy + neighbor_dy[i];
+        if (nx < 0 || ny < 0 || nx >= (int)m_width || ny >= (int)m_height) continue;
+        cell_index_type n = to_index(nx, ny);
+        if (n != m_goal) m_rhs[n] = (float)min_successor_cost(n);
+        update_vertex(n, m_last_start);
+    }
+}
+
+bool dstar_lite_planner::compute_shortest_path(cell_index_type start)
+{
+    //if the search is interrupted, the queue is left in a consistent state and the next call resumes it
+    while (!m_open_set.empty() &&
+           (m_open_set.top_key() < calculate_key(start, start) || m_rhs[start] > m_g[start]))
+    {
+        cell_index_type u = m_open_set.top();
+        double k_old = m_open_set.top_key();
+        double k_new = calculate_key(u, start);
+        stats.expanded_nodes++;
+        if (control && (stats.expanded_nodes % SEARCH_CONTROL_CHECK_PERIOD) == 0 && control->should_stop())
+        {
+            return false;
+        }
+
+        if (k_old < k_new)
+        {
+            m_open_set.update(u, k_new);
+        }
+        else if (m_g[u] > m_rhs[u])
+        {
+            m_g[u] = m_rhs[u];
+            m_open_set.remove(u);
+            if (m_free[u]) update_neighbors_of(u);
+        }
+        else
+        {
+            m_g[u] = INF;
+            if (u != m_goal) m_rhs[u] = (float)min_successor_cost(u);
+            update_vertex(u, start);
+            if (m_free[u]) update_neighbors_of(u);
+        }
+    }
+    return true;
+}
+
+bool dstar_lite_planner::is_cell_free(XYCell cell) const
+{
+    if (cell.x >= m_width || cell.y >= m_height) return false;
+    return m_free[to_index(cell.x, cell.y)] != 0;
+}
+
+void dstar_lite_planner::set_cell_free(XYCell cell, bool free)
+{
+    if (!m_initialized) return;
+    if (cell.x >= m_width || cell.y >= m_height) return;
+    cell_index_type i = to_index(cell.x, cell.y);
+    if ((m_free[i] != 0) == free) return;
+    m_free[i] = free ? 1 : 0;
+    //before the goal is seeded all the nodes are at their initial values (g=rhs=inf, rhs(goal)=0), which do not depend on the traversability
+    if (m_last_start == INVALID_CELL_INDEX) return;
+    //only the edges entering the cell changed their cost: the affected nodes are the neighbors of the cell
+    update_neighbors_of(i);
+}
+
+bool dstar_lite_planner::compute_path(XYCell start, std::deque<XYCell>& path)
+{
+    if (!m_initialized) return false;
+    if (start.x >= m_width || start.y >= m_height) return false;
+    if (!m_free[m_goal]) return false;
+
+    cell_index_type s = to_index(start.x, start.y);
+    if (m_last_start == INVALID_CELL_INDEX)
+    {
+        m_open_set.update(m_goal, calculate_key(m_goal, s));
+    }
+    else if (m_last_start != s)
+    {
+        //the robot moved: the heuristic of all the queued keys is corrected by km
+        m_km += heuristic(m_last_start, s);
+    }
+    m_last_start = s;
+
+    size_t expanded_before = stats.expanded_nodes;
+    bool completed = compute_shortest_path(s);
+    yCDebug(PATHPLAN_DSTAR) << "compute_path expanded" << stats.expanded_nodes - expanded_before << "nodes";
+    if (!completed)
+    {
+        yCDebug(PATHPLAN_DSTAR) << "search interrupted";
+        return false;
+    }
+
+    if (m_rhs[s] == INF && s != m_goal) return false;
+
+    //the path is obtained following the gradient of g, from the start to the goal
+    std::deque<XYCell> cells;
+    cell_index_type curr = s;
+    size_t max_length = m_width * m_height;
+    while (curr != m_goal)
+    {
+        int cx = (int)(curr % m_width);
+        int cy = (int)(curr / m_width);
+        double best = INF;
+        cell_index_type best_n = INVALID_CELL_INDEX;
+        for (size_t i = 0; i < 8; i++)
+        {
+            int nx = cx + neighbor_dx[i];
+            int ny = cy + neighbor_dy[i];
+            if (nx < 0 || ny < 0 || nx >= (int)m_width || ny >= (int)m_height) continue;
+            cell_index_type n = to_index(nx, ny);
+            if (!m_free[n]) continue;
+            double c = neighbor_cost[i] + m_g[n];
+            if (c < best) { best = c; best_n = n; }
+        }
+        if (best_n == INVALID_CELL_INDEX || best == INF || cells.size() > max_length)
+        {
+            yCError(PATHPLAN_DSTAR) << "Unable to extract the path from the D* Lite search state";
+            return false;
+        }
+        cells.push_back(XYCell(best_n % m_width, best_n / m_width));
+        curr = best_n;
+    }
+    path.insert(path.end(), cells.begin(), cells.end());
+    return true;
+}
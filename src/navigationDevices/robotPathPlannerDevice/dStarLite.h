@@ -0,0 +1,107 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef D_STAR_LITE_H
+#define D_STAR_LITE_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <functional>
+#include "searchWorkspace.h"
+
+//! namespace containing an implementation of the D* Lite incremental planning algorithm (Koenig and Likhachev, 2002)
+namespace dStarLite_algorithm
+{
+    /**
+    * An incremental planner which keeps its search state between calls. The search is performed backwards,
+    * from the goal to the robot, so that the robot motion and the change of a few cells only require the
+    * repair of the affected nodes, instead of a new search from scratch.
+    * Move costs are the same used by aStar_algorithm (10 for straight moves, 14 for diagonal moves); a move is
+    * forbidden if the destination cell is not free.
+    */
+    class dstar_lite_planner
+    {
+        std::vector<float>               m_g;
+        std::vector<float>               m_rhs;
+        std::vector<unsigned char>       m_free;
+        planner_search::indexed_heap     m_open_set;
+        size_t                           m_width;
+        size_t                           m_height;
+        planner_search::cell_index_type  m_goal;
+        planner_search::cell_index_type  m_last_start;
+        double                           m_km;
+        bool                             m_initialized;
+        std::string                      m_map_name;
+
+        public:
+        planner_search::search_stats     stats;
+        const planner_search::search_control* control;
+
+        dstar_lite_planner();
+
+        /**
+        * Discards the current search state and prepares a new search towards the given goal.
+        * The traversability of the cells is written directly, without propagating any change, since no node has been expanded yet.
+        * @param map the gridmap used to initialize the traversability of each cell
+        * @param goal the arrival cell(x,y)
+        * @param is_cell_free if set, it is used instead of map.isFree() to obtain the traversability of each cell
+        * @return false if the goal is outside the map
+        */
+        bool initialize(const yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell goal,
+                        const std::function<bool(const yarp::dev::Nav2D::XYCell&)>& is_cell_free = nullptr);
+
+        /**
+        * Discards the current search state. The next call to is_initialized_for() will return false.
+        */
+        void reset();
+
+        /**
+        * @return true if the planner is currently storing a search towards the given goal, on the given map
+        */
+        bool is_initialized_for(const std::string& map_name, yarp::dev::Nav2D::XYCell goal) const;
+
+        /**
+        * Changes the traversability of a single cell and repairs the affected nodes. Before the first call to compute_path()
+        * only the traversability is changed, since there is no search state to repair.
+        */
+        void set_cell_free(yarp::dev::Nav2D::XYCell cell, bool free);
+        bool is_cell_free(yarp::dev::Nav2D::XYCell cell) const;
+
+        /**
+        * Computes (or repairs) the shortest path from the given start cell to the goal.
+        * @param start the start cell(x,y), typically the current robot position
+        * @param path the computed sequence of cells (start cell excluded, goal cell included)
+        * @return true if the path exists, false if no valid path has been found
+        */
+        bool compute_path(yarp::dev::Nav2D::XYCell start, std::deque<yarp::dev::Nav2D::XYCell>& path);
+
+        private:
+        planner_search::cell_index_type to_index(size_t x, size_t y) const { return static_cast<planner_search::cell_index_type>(y * m_width + x); }
+        double heuristic(planner_search::cell_index_type a, planner_search::cell_index_type b) const;
+        double calculate_key(planner_search::cell_index_type s, planner_search::cell_index_type start) const;
+        double min_successor_cost(planner_search::cell_index_type s) const;
+        void   update_vertex(planner_search::cell_index_type s, planner_search::cell_index_type start);
+        void   update_neighbors_of(planner_search::cell_index_type s);
+        bool   compute_shortest_path(planner_search::cell_index_type start);
+    };
+};
+
+#endif
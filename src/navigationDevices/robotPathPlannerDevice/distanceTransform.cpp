@@ -0,0 +1,204 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <math.h>
+#include "distanceTransform.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace distanceTransform_algorithm;
+
+YARP_LOG_COMPONENT(PATHPLAN_DISTANCE_TRANSFORM, "navigation.devices.robotPathPlanner.distanceTransform")
+
+namespace
+{
+    const double EDT_INF = 1e20;
+
+    //one-dimensional squared distance transform of the sampled function f (lower envelope of parabolas)
+    void edt_1d(const double* f, size_t n, double* d, int* v, double* z)
+    {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -EDT_INF;
+        z[1] = +EDT_INF;
+        for (int q = 1; q < (int)n; q++)
+        {
+            double s = ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+            while (s <= z[k])
+            {
+                k--;
+                s = ((f[q] + (double)q * q) - (f[v[k]] + (double)v[k] * v[k])) / (2.0 * q - 2.0 * v[k]);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = +EDT_INF;
+        }
+        k = 0;
+        for (int q = 0; q < (int)n; q++)
+        {
+            while (z[k + 1] < q) k++;
+            d[q] = (double)(q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    }
+
+    bool is_obstacle_flag(MapGrid2D::map_flags flag)
+    {
+        //the same cells which are enlarged by MapGrid2D::enlargeObstacles()
+        return (flag == MapGrid2D::MAP_CELL_WALL ||
+                flag == MapGrid2D::MAP_CELL_UNKNOWN ||
+                flag == MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE ||
+                flag == MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE);
+    }
+}
+
+void distanceTransform_algorithm::compute_squared_edt(const std::vector<uint8_t>& obstacles, size_t width, size_t height, std::vector<float>& sq_distance)
+{
+    size_t n = std::max(width, height);
+    std::vector<double> f(n);
+    std::vector<double> d(n);
+    std::vector<double> z(n + 1);
+    std::vector<int>    v(n);
+    std::vector<double> tmp(width * height);
+
+    //columns
+    for (size_t x = 0; x < width; x++)
+    {
+        for (size_t y = 0; y < height; y++) f[y] = obstacles[y * width + x] ? 0 : EDT_INF;
+        edt_1d(f.data(), height, d.data(), v.data(), z.data());
+        for (size_t y = 0; y < height; y++) tmp[y * width + x] = d[y];
+    }
+    //rows
+    sq_distance.resize(width * height);
+    for (size_t y = 0; y < height; y++)
+    {
+        edt_1d(&tmp[y * width], width, d.data(), v.data(), z.data());
+        for (size_t x = 0; x < width; x++) sq_distance[y * width + x] = (float)std::min(d[x], EDT_INF);
+    }
+}
+
+/////////// clearance_map
+clearance_map::clearance_map()
+{
+    m_width = 0;
+    m_height = 0;
+    m_resolution = 0;
+    m_cost_max_distance = 0;
+    m_cost_weight = 0;
+}
+
+bool clearance_map::matches(const MapGrid2D& map) const
+{
+    return (m_width == map.width() && m_height == map.height() && m_sq_distance.size() == m_width * m_height);
+}
+
+bool clearance_map::update(const MapGrid2D& map)
+{
+    std::vector<uint8_t> obstacles(map.width() * map.height());
+    for (size_t y = 0; y < map.height(); y++)
+        for (size_t x = 0; x < map.width(); x++)
+        {
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(XYCell(x, y), flag);
+            obstacles[y * map.width() + x] = is_obstacle_flag(flag) ? 1 : 0;
+        }
+    double resolution = 0;
+    map.getResolution(resolution);
+
+    if (matches(map) &&
+        m_map_name == map.getMapName() &&
+        m_resolution == resolution &&
+        m_obstacles == obstacles)
+    {
+        yCDebug(PATHPLAN_DISTANCE_TRANSFORM) << "Using the cached clearance field of map" << m_map_name;
+        return false;
+    }
+
+    double t1 = yarp::os::Time::now();
+    m_map_name = map.getMapName();
+    m_width = map.width();
+    m_height = map.height();
+    m_resolution = resolution;
+    m_obstacles.swap(obstacles);
+    compute_squared_edt(m_obstacles, m_width, m_height, m_sq_distance);
+    m_cost_layer.reset();
+    yCDebug(PATHPLAN_DISTANCE_TRANSFORM) << "Clearance field of map" << m_map_name << "computed in" << yarp::os::Time::now() - t1 << "s";
+    return true;
+}
+
+double clearance_map::clearance(const XYCell& cell) const
+{
+    if (cell.x >= m_width || cell.y >= m_height) return 0;
+    return sqrt(m_sq_distance[cell.y * m_width + cell.x]) * m_resolution;
+}
+
+void clearance_map::inflate(MapGrid2D& map, double radius) const
+{
+    if (radius <= 0 || m_resolution <= 0) return;
+    if (!matches(map))
+    {
+        yCError(PATHPLAN_DISTANCE_TRANSFORM) << "inflate: the clearance field does not match the size of the map";
+        return;
+    }
+    //enlargeObstacles() grows the obstacles by ceil(radius/resolution) cells (4-connected steps): a disc with the same radius contains them
+    double cells = ceil(radius / m_resolution);
+    float threshold = (float)(cells * cells);
+    for (size_t y = 0; y < m_height; y++)
+        for (size_t x = 0; x < m_width; x++)
+        {
+            size_t i = y * m_width + x;
+            if (m_obstacles[i] || m_sq_distance[i] > threshold) continue;
+            XYCell c(x, y);
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(c, flag);
+            if (flag == MapGrid2D::MAP_CELL_FREE) map.setMapFlag(c, MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE);
+        }
+}
+
+bool clearance_map::is_inflated(const XYCell& cell, double radius) const
+{
+    if (radius <= 0 || m_resolution <= 0) return false;
+    if (cell.x >= m_width || cell.y >= m_height) return false;
+    size_t i = cell.y * m_width + cell.x;
+    double cells = ceil(radius / m_resolution);
+    return (m_obstacles[i] == 0 && m_sq_distance[i] <= (float)(cells * cells));
+}
+
+std::shared_ptr<const std::vector<float> > clearance_map::cost_layer(double max_distance, double weight)
+{
+    if (weight <= 0 || max_distance <= 0 || m_resolution <= 0) return nullptr;
+    if (m_cost_layer && m_cost_max_distance == max_distance && m_cost_weight == weight) return m_cost_layer;
+
+    std::shared_ptr<std::vector<float> > layer = std::make_shared<std::vector<float> >(m_width * m_height, 0.0f);
+    double max_cells = max_distance / m_resolution;
+    for (size_t i = 0; i < m_sq_distance.size(); i++)
+    {
+        double d = sqrt(m_sq_distance[i]);
+        if (d < max_cells) (*layer)[i] = (float)(weight * (1.0 - d / max_cells));
+    }
+    m_cost_layer = layer;
+    m_cost_max_distance = max_distance;
+    m_cost_weight = weight;
+    return m_cost_layer;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef DISTANCE_TRANSFORM_H
+#define DISTANCE_TRANSFORM_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+
+//! namespace containing an implementation of the Euclidean distance transform (Felzenszwalb and Huttenlocher, 2012)
+namespace distanceTransform_algorithm
+{
+    /**
+    * Computes the squared Euclidean distance transform of a grid, in linear time.
+    * @param obstacles a w*h row-major grid: non-zero values are the cells from which the distance is measured
+    * @param width the width of the grid (cells)
+    * @param height the height of the grid (cells)
+    * @param sq_distance filled with the squared distance (cells^2) of each cell from the nearest obstacle
+    */
+    void compute_squared_edt(const std::vector<uint8_t>& obstacles, size_t width, size_t height, std::vector<float>& sq_distance);
+
+    /**
+    * The clearance of each cell of a map, i.e. its distance from the nearest obstacle (walls, unknown cells and temporary obstacles).
+    * The field is computed once per map and cached: the enlargement of the obstacles for any radius then becomes a threshold test,
+    * and the same field can be converted in a per-cell cost which keeps the computed paths away from the obstacles.
+    */
+    class clearance_map
+    {
+        std::string                                m_map_name;
+        size_t                                     m_width;
+        size_t                                     m_height;
+        double                                     m_resolution;
+        std::vector<uint8_t>                       m_obstacles;
+        std::vector<float>                         m_sq_distance;
+        std::shared_ptr<const std::vector<float> > m_cost_layer;
+        double                                     m_cost_max_distance;
+        double                                     m_cost_weight;
+
+        public:
+        clearance_map();
+
+        /**
+        * Computes the field of the given map. Nothing is done if the obstacles of the map are the same of the previous call.
+        * @param map the gridmap (before the enlargement of the obstacles)
+        * @return true if the field has been recomputed, false if the cached one has been kept
+        */
+        bool update(const yarp::dev::Nav2D::MapGrid2D& map);
+
+        /**
+        * @return true if the field has the same size of the given map
+        */
+        bool matches(const yarp::dev::Nav2D::MapGrid2D& map) const;
+
+        /**
+        * @return the distance (m) of a cell from the nearest obstacle
+        */
+        double clearance(const yarp::dev::Nav2D::XYCell& cell) const;
+
+        /**
+        * Marks as MAP_CELL_ENLARGED_OBSTACLE all the free cells whose clearance is smaller than the given radius.
+        * The result contains the one of MapGrid2D::enlargeObstacles() with the same radius.
+        * @param map the gridmap to be modified. It must be the map used to compute the field.
+        * @param radius the enlargement radius (m)
+        */
+        void inflate(yarp::dev::Nav2D::MapGrid2D& map, double radius) const;
+
+        /**
+        * @return true if inflate() with the given radius would mark the cell (provided that the cell is free)
+        */
+        bool is_inflated(const yarp::dev::Nav2D::XYCell& cell, double radius) const;
+
+        /**
+        * Returns a per-cell cost, which decreases linearly from weight (on the obstacles) to zero (at max_distance from them).
+        * The layer is computed only once for each combination of parameters.
+        * @param max_distance the distance (m) beyond which the cost is zero
+        * @param weight the cost of a cell adjacent to an obstacle, expressed in the units of the move costs (10 = one cell)
+        * @return the cost of each cell (row-major), or nullptr if the cost is disabled (weight <= 0)
+        */
+        std::shared_ptr<const std::vector<float> > cost_layer(double max_distance, double weight);
+    };
+};
+
+#endif
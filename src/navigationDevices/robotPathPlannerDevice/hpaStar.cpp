@@ -0,0 +1,468 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <limits>
+#include <queue>
+#include <functional>
+#include <algorithm>
+#include "hpaStar.h"
+#include "aStarIndexed.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+using namespace hpaStar_algorithm;
+
+YARP_LOG_COMPONENT(PATHPLAN_HPASTAR, "navigation.devices.robotPathPlanner.hpaStar")
+
+namespace
+{
+    const int    neighbor_dx[8]   = { 0,  0, 1, -1,  1,  1, -1, -1 };
+    const int    neighbor_dy[8]   = { 1, -1, 0,  0,  1, -1,  1, -1 };
+    const double neighbor_cost[8] = { 10, 10, 10, 10, 14, 14, 14, 14 };
+    const double INF = std::numeric_limits<double>::infinity();
+
+    //entrances shorter than this value are represented by a single transition (placed in the middle),
+    //the longer ones by two transitions (placed at the two ends)
+    const size_t MAX_SINGLE_TRANSITION_LENGTH = 6;
+
+    //a search (A* if a target is given, Dijkstra otherwise) restricted to a rectangular area of the map
+    class local_search
+    {
+        search_workspace m_ws;
+        search_area      m_area;
+        XYCell           m_source;
+
+        public:
+        local_search(size_t max_area_size)
+        {
+            //the workspace is always prepared with the same size, so that its memory is allocated only once
+            m_ws.prepare(max_area_size, max_area_size);
+        }
+
+        cell_index_type local_index(const XYCell& c) const
+        {
+            return m_ws.to_index(c.x - m_area.x_min, c.y - m_area.y_min);
+        }
+
+        bool inside(int x, int y) const
+        {
+            return (x >= (int)m_area.x_min && y >= (int)m_area.y_min && x <= (int)m_area.x_max && y <= (int)m_area.y_max);
+        }
+
+        bool run(const MapGrid2D& map, const search_area& area, XYCell source, const XYCell* target)
+        {
+            m_ws.prepare(m_ws.width(), m_ws.height());
+            m_area = area;
+            m_source = source;
+            if (!inside((int)source.x, (int)source.y)) return false;
+            if (target && !inside((int)target->x, (int)target->y)) return false;
+
+            cell_index_type source_index = local_index(source);
+            cell_index_type target_index = target ? local_index(*target) : INVALID_CELL_INDEX;
+            m_ws.set_node(source_index, 0, INVALID_CELL_INDEX);
+            m_ws.open_set.push(source_index, 0);
+            while (!m_ws.open_set.empty())
+            {
+                cell_index_type curr = m_ws.open_set.pop();
+                if (curr == target_index) return true;
+                m_ws.set_closed(curr);
+
+                XYCell c = m_ws.to_cell(curr);
+                int cx = (int)(c.x + m_area.x_min);
+                int cy = (int)(c.y + m_area.y_min);
+                double curr_g = m_ws.g_score(curr);
+                for (size_t i = 0; i < 8; i++)
+                {
+                    int nx = cx + neighbor_dx[i];
+                    int ny = cy + neighbor_dy[i];
+                    if (!inside(nx, ny)) continue;
+                    cell_index_type n = m_ws.to_index(nx - m_area.x_min, ny - m_area.y_min);
+                    if (m_ws.is_closed(n)) continue;
+                    if (map.isFree(XYCell(nx, ny)) == false) continue;
+                    double g = curr_g + neighbor_cost[i];
+                    if (g < m_ws.g_score(n))
+                    {
+                        m_ws.set_node(n, g, curr);
+                        double f = g;
+                        if (target) f += aStarIndexed_algorithm::octile_distance(nx, ny, (int)target->x, (int)target->y);
+                        if (m_ws.open_set.contains(n)) m_ws.open_set.decrease_key(n, f);
+                        else                           m_ws.open_set.push(n, f);
+                    }
+                }
+            }
+            return (target == nullptr);
+        }
+
+        double cost_to(const XYCell& c) const
+        {
+            if (!inside((int)c.x, (int)c.y)) return INF;
+            return m_ws.g_score(local_index(c));
+        }
+
+        bool path_to(const XYCell& target, std::deque<XYCell>& path) const
+        {
+            std::deque<XYCell> local_path;
+            if (!m_ws.reconstruct_path(local_index(m_source), local_index(target), local_path)) return false;
+            for (auto it = local_path.begin(); it != local_path.end(); it++)
+            {
+                path.push_back(XYCell(it->x + m_area.x_min, it->y + m_area.y_min));
+            }
+            return true;
+        }
+    };
+}
+
+/////////// abstract_graph
+abstract_graph::abstract_graph()
+{
+    map_hash = 0;
+    width = 0;
+    height = 0;
+    cluster_size = 0;
+    clusters_x = 0;
+    clusters_y = 0;
+    build_time = 0;
+}
+
+size_t abstract_graph::cluster_of(const XYCell& cell) const
+{
+    return (cell.y / cluster_size) * clusters_x + (cell.x / cluster_size);
+}
+
+search_area abstract_graph::cluster_area(size_t cluster) const
+{
+    search_area area;
+    area.x_min = (cluster % clusters_x) * cluster_size;
+    area.y_min = (cluster / clusters_x) * cluster_size;
+    area.x_max = std::min(area.x_min + cluster_size, width) - 1;
+    area.y_max = std::min(area.y_min + cluster_size, height) - 1;
+    return area;
+}
+
+size_t abstract_graph::add_node(const XYCell& cell, std::map<size_t, size_t>& node_of_cell)
+{
+    size_t key = cell.y * width + cell.x;
+    auto it = node_of_cell.find(key);
+    if (it != node_of_cell.end()) return it->second;
+
+    abstract_node n;
+    n.cell = cell;
+    n.cluster = cluster_of(cell);
+    nodes.push_back(n);
+    size_t id = nodes.size() - 1;
+    cluster_nodes[n.cluster].push_back(id);
+    node_of_cell[key] = id;
+    return id;
+}
+
+void abstract_graph::add_entrance(const XYCell& a, const XYCell& b, std::map<size_t, size_t>& node_of_cell)
+{
+    size_t na = add_node(a, node_of_cell);
+    size_t nb = add_node(b, node_of_cell);
+    abstract_edge e;
+    e.cost = 10;
+    e.to = nb;
+    nodes[na].edges.push_back(e);
+    e.to = na;
+    nodes[nb].edges.push_back(e);
+}
+
+bool abstract_graph::build(const MapGrid2D& map, size_t _cluster_size)
+{
+    double t1 = yarp::os::Time::now();
+    if (_cluster_size < 2) return false;
+    map_name = map.getMapName();
+    map_hash = compute_map_hash(map);
+    width = map.width();
+    height = map.height();
+    cluster_size = _cluster_size;
+    clusters_x = (width + cluster_size - 1) / cluster_size;
+    clusters_y = (height + cluster_size - 1) / cluster_size;
+    nodes.clear();
+    cluster_nodes.assign(clusters_x * clusters_y, std::vector<size_t>());
+    std::map<size_t, size_t> node_of_cell;
+
+    //entrances along the borders between each cluster and the next cluster on its right (vertical borders)
+    //and between each cluster and the next cluster below it (horizontal borders)
+    for (int border = 0; border < 2; border++)
+    {
+        bool vertical = (border == 0);
+        size_t n_lines = vertical ? clusters_x - 1 : clusters_y - 1;
+        size_t length = vertical ? height : width;
+        for (size_t line = 0; line < n_lines; line++)
+        {
+            size_t side_b = (line + 1) * cluster_size;
+            size_t side_a = side_b - 1;
+            for (size_t seg0 = 0; seg0 < length; seg0 += cluster_size)
+            {
+                size_t seg1 = std::min(seg0 + cluster_size, length) - 1;
+                bool   in_segment = false;
+                size_t segment_start = 0;
+                for (size_t k = seg0; k <= seg1 + 1; k++)
+                {
+                    bool ok = false;
+                    if (k <= seg1)
+                    {
+                        XYCell a = vertical ? XYCell(side_a, k) : XYCell(k, side_a);
+                        XYCell b = vertical ? XYCell(side_b, k) : XYCell(k, side_b);
+                        ok = map.isFree(a) && map.isFree(b);
+                    }
+                    if (ok && !in_segment)
+                    {
+                        in_segment = true;
+                        segment_start = k;
+                    }
+                    else if (!ok && in_segment)
+                    {
+                        in_segment = false;
+                        size_t segment_end = k - 1;
+                        std::vector<size_t> transitions;
+                        if (segment_end - segment_start + 1 < MAX_SINGLE_TRANSITION_LENGTH)
+                        {
+                            transitions.push_back((segment_start + segment_end) / 2);
+                        }
+                        else
+                        {
+                            transitions.push_back(segment_start);
+                            transitions.push_back(segment_end);
+                        }
+                        for (auto t = transitions.begin(); t != transitions.end(); t++)
+                        {
+                            XYCell a = vertical ? XYCell(side_a, *t) : XYCell(*t, side_a);
+                            XYCell b = vertical ? XYCell(side_b, *t) : XYCell(*t, side_b);
+                            add_entrance(a, b, node_of_cell);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //intra-edges: the cost of the paths connecting the nodes of the same cluster, without leaving the cluster
+    local_search search(cluster_size);
+    for (size_t c = 0; c < cluster_nodes.size(); c++)
+    {
+        const std::vector<size_t>& cn = cluster_nodes[c];
+        search_area area = cluster_area(c);
+        for (size_t i = 0; i < cn.size(); i++)
+        {
+            search.run(map, area, nodes[cn[i]].cell, nullptr);
+            for (size_t j = 0; j < cn.size(); j++)
+            {
+                if (i == j) continue;
+                double cost = search.cost_to(nodes[cn[j]].cell);
+                if (cost == INF) continue;
+                abstract_edge e;
+                e.to = cn[j];
+                e.cost = cost;
+                nodes[cn[i]].edges.push_back(e);
+            }
+        }
+    }
+
+    build_time = yarp::os::Time::now() - t1;
+    yCInfo(PATHPLAN_HPASTAR) << "Abstract graph of map" << map_name << "built:" << nodes.size() << "nodes," << clusters_x * clusters_y << "clusters," << build_time << "s";
+    return true;
+}
+
+/////////// abstract_graph_cache
+std::shared_ptr<const abstract_graph> abstract_graph_cache::get(const MapGrid2D& map, size_t cluster_size)
+{
+    uint64_t hash = compute_map_hash(map);
+    auto it = m_graphs.find(map.getMapName());
+    if (it != m_graphs.end() &&
+        it->second->map_hash == hash &&
+        it->second->cluster_size == cluster_size)
+    {
+        yCDebug(PATHPLAN_HPASTAR) << "Using cached abstract graph of map" << map.getMapName();
+        return it->second;
+    }
+
+    std::shared_ptr<abstract_graph> graph = std::make_shared<abstract_graph>();
+    if (graph->build(map, cluster_size) == false)
+    {
+        yCError(PATHPLAN_HPASTAR) << "Unable to build the abstract graph of map" << map.getMapName();
+        return nullptr;
+    }
+    m_graphs[map.getMapName()] = graph;
+    return graph;
+}
+
+void abstract_graph_cache::clear()
+{
+    m_graphs.clear();
+}
+
+/////////// various
+uint64_t hpaStar_algorithm::compute_map_hash(const MapGrid2D& map)
+{
+    //FNV-1a hash of the map size and of the traversability of all the cells (packed 8 cells per byte)
+    uint64_t hash = 14695981039346656037ULL;
+    auto hash_byte = [&hash](uint8_t byte) { hash ^= byte; hash *= 1099511628211ULL; };
+    for (size_t i = 0; i < sizeof(size_t); i++) hash_byte((uint8_t)(map.width() >> (8 * i)));
+    for (size_t i = 0; i < sizeof(size_t); i++) hash_byte((uint8_t)(map.height() >> (8 * i)));
+    uint8_t byte = 0;
+    size_t bits = 0;
+    for (size_t y = 0; y < map.height(); y++)
+        for (size_t x = 0; x < map.width(); x++)
+        {
+            byte = (uint8_t)((byte << 1) | (map.isFree(XYCell(x, y)) ? 1 : 0));
+            if (++bits == 8) { hash_byte(byte); byte = 0; bits = 0; }
+        }
+    if (bits > 0) hash_byte(byte);
+    return hash;
+}
+
+bool hpaStar_algorithm::find_hpa_path(const abstract_graph& graph, const MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path)
+{
+    if (graph.width != map.width() || graph.height != map.height())
+    {
+        yCError(PATHPLAN_HPASTAR) << "The abstract graph does not match the size of the map";
+        return false;
+    }
+    if (start.x >= graph.width || goal.x >= graph.width) return false;
+    if (start.y >= graph.height || goal.y >= graph.height) return false;
+    if (map.isFree(goal) == false) return false;
+    if (start.x == goal.x && start.y == goal.y) return true;
+
+    local_search search(graph.cluster_size);
+    size_t start_cluster = graph.cluster_of(start);
+    size_t goal_cluster = graph.cluster_of(goal);
+
+    //start and goal in the same cluster: try first a path which does not leave the cluster
+    if (start_cluster == goal_cluster &&
+        search.run(map, graph.cluster_area(start_cluster), start, &goal))
+    {
+        return search.path_to(goal, path);
+    }
+
+    //start and goal are temporarily connected to the nodes of their clusters
+    const size_t N = graph.nodes.size();
+    const size_t S = N;
+    const size_t G = N + 1;
+    std::vector<abstract_edge> start_edges;
+    std::vector<double> cost_to_goal(N, INF);
+    search.run(map, graph.cluster_area(start_cluster), start, nullptr);
+    for (auto it = graph.cluster_nodes[start_cluster].begin(); it != graph.cluster_nodes[start_cluster].end(); it++)
+    {
+        double cost = search.cost_to(graph.nodes[*it].cell);
+        if (cost == INF) continue;
+        abstract_edge e;
+        e.to = *it;
+        e.cost = cost;
+        start_edges.push_back(e);
+    }
+    search.run(map, graph.cluster_area(goal_cluster), goal, nullptr);
+    for (auto it = graph.cluster_nodes[goal_cluster].begin(); it != graph.cluster_nodes[goal_cluster].end(); it++)
+    {
+        cost_to_goal[*it] = search.cost_to(graph.nodes[*it].cell);
+    }
+
+    //A* on the abstract graph
+    std::vector<double> dist(N + 2, INF);
+    std::vector<size_t> came_from(N + 2, N + 2);
+    std::vector<bool>   closed(N + 2, false);
+    typedef std::pair<double, size_t> queue_item;
+    std::priority_queue<queue_item, std::vector<queue_item>, std::greater<queue_item> > open_set;
+    auto heuristic = [&](size_t n)
+    {
+        XYCell c = (n == S) ? start : (n == G) ? goal : graph.nodes[n].cell;
+        return aStarIndexed_algorithm::octile_distance((int)c.x, (int)c.y, (int)goal.x, (int)goal.y);
+    };
+    dist[S] = 0;
+    open_set.push(queue_item(heuristic(S), S));
+    while (!open_set.empty())
+    {
+        size_t u = open_set.top().second;
+        open_set.pop();
+        if (closed[u]) continue;
+        closed[u] = true;
+        if (u == G) break;
+
+        const std::vector<abstract_edge>& edges = (u == S) ? start_edges : graph.nodes[u].edges;
+        for (auto e = edges.begin(); e != edges.end(); e++)
+        {
+            if (closed[e->to]) continue;
+            double d = dist[u] + e->cost;
+            if (d < dist[e->to])
+            {
+                dist[e->to] = d;
+                came_from[e->to] = u;
+                open_set.push(queue_item(d + heuristic(e->to), e->to));
+            }
+        }
+        if (u != S && cost_to_goal[u] != INF)
+        {
+            double d = dist[u] + cost_to_goal[u];
+            if (d < dist[G])
+            {
+                dist[G] = d;
+                came_from[G] = u;
+                open_set.push(queue_item(d, G));
+            }
+        }
+    }
+    if (dist[G] == INF)
+    {
+        return false;
+    }
+
+    //refinement: each abstract edge is converted in a sequence of cells
+    std::vector<size_t> abstract_path;
+    for (size_t n = G; n != S; n = came_from[n]) abstract_path.push_back(n);
+    std::reverse(abstract_path.begin(), abstract_path.end());
+
+    std::deque<XYCell> cells;
+    XYCell prev = start;
+    for (auto it = abstract_path.begin(); it != abstract_path.end(); it++)
+    {
+        XYCell next = (*it == G) ? goal : graph.nodes[*it].cell;
+        if (next.x == prev.x && next.y == prev.y) continue;
+        size_t prev_cluster = graph.cluster_of(prev);
+        if (prev_cluster != graph.cluster_of(next))
+        {
+            //inter-edge: the two cells are adjacent. The entrance is checked since the graph may be older than the map
+            if (map.isFree(next) == false)
+            {
+                yCWarning(PATHPLAN_HPASTAR) << "Refinement failed: the map does not match its abstract graph";
+                return false;
+            }
+            cells.push_back(next);
+        }
+        else
+        {
+            //intra-edge: the path is searched inside the cluster only
+            if (!search.run(map, graph.cluster_area(prev_cluster), prev, &next) ||
+                !search.path_to(next, cells))
+            {
+                yCWarning(PATHPLAN_HPASTAR) << "Refinement failed: the map does not match its abstract graph";
+                return false;
+            }
+        }
+        prev = next;
+    }
+    path.insert(path.end(), cells.begin(), cells.end());
+    return true;
+}
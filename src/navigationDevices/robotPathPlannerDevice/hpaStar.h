@@ -0,0 +1,136 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef HPA_STAR_H
+#define HPA_STAR_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include "searchWorkspace.h"
+
+//! namespace containing an implementation of the Hierarchical Path-Finding A* algorithm (Botea, Muller and Schaeffer, 2004)
+namespace hpaStar_algorithm
+{
+    //the default size (cells) of the side of a cluster
+    const size_t DEFAULT_CLUSTER_SIZE = 32;
+
+    //a rectangular portion of the map (bounds included)
+    struct search_area
+    {
+        size_t x_min;
+        size_t y_min;
+        size_t x_max;
+        size_t y_max;
+    };
+
+    struct abstract_edge
+    {
+        size_t to;
+        double cost;
+    };
+
+    //an abstract node is a cell placed at the entrance of a cluster
+    struct abstract_node
+    {
+        yarp::dev::Nav2D::XYCell   cell;
+        size_t                     cluster;
+        std::vector<abstract_edge> edges;
+    };
+
+    /**
+    * The abstract graph of a map. The map is partitioned in square clusters: the nodes of the graph are the cells
+    * placed at the entrances between adjacent clusters and the edges store the cost of the paths connecting them,
+    * either inside a cluster (intra-edges) or crossing the border between two clusters (inter-edges).
+    */
+    class abstract_graph
+    {
+        public:
+        std::string                        map_name;
+        uint64_t                           map_hash;
+        size_t                             width;
+        size_t                             height;
+        size_t                             cluster_size;
+        size_t                             clusters_x;
+        size_t                             clusters_y;
+        std::vector<abstract_node>         nodes;
+        std::vector<std::vector<size_t> >  cluster_nodes;
+        double                             build_time;
+
+        abstract_graph();
+
+        /**
+        * Builds the abstract graph of a map. The cost of this operation is proportional to the map size.
+        * @param map the gridmap containing the obstacles
+        * @param cluster_size the size (cells) of the side of a cluster
+        * @return true if the graph was successfully built
+        */
+        bool build(const yarp::dev::Nav2D::MapGrid2D& map, size_t cluster_size);
+
+        size_t      cluster_of(const yarp::dev::Nav2D::XYCell& cell) const;
+        search_area cluster_area(size_t cluster) const;
+
+        private:
+        size_t add_node(const yarp::dev::Nav2D::XYCell& cell, std::map<size_t, size_t>& node_of_cell);
+        void   add_entrance(const yarp::dev::Nav2D::XYCell& a, const yarp::dev::Nav2D::XYCell& b, std::map<size_t, size_t>& node_of_cell);
+    };
+
+    /**
+    * A cache of abstract graphs, one for each map name. A graph is rebuilt only if the content of the map
+    * (or the cluster size) changed since the graph was built.
+    */
+    class abstract_graph_cache
+    {
+        std::map<std::string, std::shared_ptr<const abstract_graph> > m_graphs;
+
+        public:
+        /**
+        * Returns the graph associated to the given map, building it if necessary.
+        * @param map the gridmap containing the obstacles
+        * @param cluster_size the size (cells) of the side of a cluster
+        * @return the abstract graph, or nullptr if the graph cannot be built
+        */
+        std::shared_ptr<const abstract_graph> get(const yarp::dev::Nav2D::MapGrid2D& map, size_t cluster_size);
+        void clear();
+    };
+
+    /**
+    * Computes an hash of the map content (size and traversability of each cell).
+    */
+    uint64_t compute_map_hash(const yarp::dev::Nav2D::MapGrid2D& map);
+
+    /**
+    * This method computes (if exists) the path required to go from a start cell to a goal cell, using a precomputed abstract graph.
+    * The search is performed on the abstract graph first, then the path is refined at full resolution only inside the clusters
+    * crossed by the abstract path. The result is not guaranteed to be optimal.
+    * @param graph the abstract graph of the map
+    * @param map the gridmap containing the obstacles
+    * @param start the start cell(x,y)
+    * @param goal the arrival cell(x,y)
+    * @param path the computed sequence of cells required to go from  start cell to goal cell
+    * @return true if the path exists, false if no valid path has been found
+    */
+    bool find_hpa_path(const abstract_graph& graph, const yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path);
+};
+
+#endif
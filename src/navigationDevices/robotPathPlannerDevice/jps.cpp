@@ -0,0 +1,265 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <vector>
+#include "jps.h"
+#include "aStarIndexed.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+
+YARP_LOG_COMPONENT(PATHPLAN_JPS, "navigation.devices.robotPathPlanner.jps")
+
+namespace
+{
+    //moves from (x,y) along the row, in the direction dx, until a jump point is found (see planning_grid::jump_horizontal()).
+    //This generic version tests one cell at a time.
+    template <typename Grid>
+    bool jump_horizontal(const Grid& grid, int x, int y, int dx, int gx, int gy, int& jx)
+    {
+        while (true)
+        {
+            x += dx;
+            if (!grid.is_free(x, y)) return false;
+            if ((x == gx && y == gy) ||
+                (grid.is_free(x + dx, y + 1) && !grid.is_free(x, y + 1)) ||
+                (grid.is_free(x + dx, y - 1) && !grid.is_free(x, y - 1)))
+            {
+                jx = x; return true;
+            }
+        }
+    }
+
+    //the packed grid tests 64 cells at a time
+    bool jump_horizontal(const planning_grid& grid, int x, int y, int dx, int gx, int gy, int& jx)
+    {
+        return grid.jump_horizontal(x, y, dx, gx, gy, jx);
+    }
+
+    //helper class which performs the jumps on a given grid (the map or its packed copy). Cells outside the map are considered occupied.
+    template <typename Grid>
+    class jump_helper
+    {
+        const Grid&      m_grid;
+        int              m_gx;
+        int              m_gy;
+
+        public:
+        jump_helper(const Grid& grid, XYCell goal) :
+            m_grid(grid), m_gx((int)goal.x), m_gy((int)goal.y) {}
+
+        bool free(int x, int y) const
+        {
+            return m_grid.is_free(x, y);
+        }
+
+        //moves from (x,y) along the direction (dx,dy) until a jump point is found.
+        //returns false if the search hits an obstacle or the border of the map.
+        bool jump(int x, int y, int dx, int dy, int& jx, int& jy) const
+        {
+            if (dy == 0)
+            {
+                jy = y;
+                return jump_horizontal(m_grid, x, y, dx, m_gx, m_gy, jx);
+            }
+            while (true)
+            {
+                x += dx;
+                y += dy;
+                if (!free(x, y)) return false;
+                if (x == m_gx && y == m_gy) { jx = x; jy = y; return true; }
+
+                if (dx != 0 && dy != 0)
+                {
+                    //diagonal move: check for forced neighbors, then perform the straight jumps
+                    if ((free(x - dx, y + dy) && !free(x - dx, y)) ||
+                        (free(x + dx, y - dy) && !free(x, y - dy)))
+                    {
+                        jx = x; jy = y; return true;
+                    }
+                    int tx, ty;
+                    if (jump(x, y, dx, 0, tx, ty) || jump(x, y, 0, dy, tx, ty))
+                    {
+                        jx = x; jy = y; return true;
+                    }
+                }
+                else
+                {
+                    //vertical move
+                    if ((free(x + 1, y + dy) && !free(x + 1, y)) ||
+                        (free(x - 1, y + dy) && !free(x - 1, y)))
+                    {
+                        jx = x; jy = y; return true;
+                    }
+                }
+            }
+        }
+
+        //computes the directions to be explored from (x,y), given the direction of arrival (dx,dy)
+        void pruned_directions(int x, int y, int dx, int dy, std::vector<std::pair<int, int> >& dirs) const
+        {
+            dirs.clear();
+            if (dx == 0 && dy == 0)
+            {
+                //start node: all the neighbors are explored
+                for (int ix = -1; ix <= 1; ix++)
+                    for (int iy = -1; iy <= 1; iy++)
+                        if ((ix != 0 || iy != 0) && free(x + ix, y + iy)) dirs.push_back(std::make_pair(ix, iy));
+            }
+            else if (dx != 0 && dy != 0)
+            {
+                if (free(x + dx, y))      dirs.push_back(std::make_pair(dx, 0));
+                if (free(x, y + dy))      dirs.push_back(std::make_pair(0, dy));
+                if (free(x + dx, y + dy)) dirs.push_back(std::make_pair(dx, dy));
+                if (!free(x - dx, y) && free(x - dx, y + dy)) dirs.push_back(std::make_pair(-dx, dy));
+                if (!free(x, y - dy) && free(x + dx, y - dy)) dirs.push_back(std::make_pair(dx, -dy));
+            }
+            else if (dx != 0)
+            {
+                if (free(x + dx, y)) dirs.push_back(std::make_pair(dx, 0));
+                if (!free(x, y + 1) && free(x + dx, y + 1)) dirs.push_back(std::make_pair(dx, 1));
+                if (!free(x, y - 1) && free(x + dx, y - 1)) dirs.push_back(std::make_pair(dx, -1));
+            }
+            else
+            {
+                if (free(x, y + dy)) dirs.push_back(std::make_pair(0, dy));
+                if (!free(x + 1, y) && free(x + 1, y + dy)) dirs.push_back(std::make_pair(1, dy));
+                if (!free(x - 1, y) && free(x - 1, y + dy)) dirs.push_back(std::make_pair(-1, dy));
+            }
+        }
+    };
+
+    int sign(int v) { return (v > 0) - (v < 0); }
+
+    //the search, performed either on the map or on its packed copy (see planning_grid)
+    template <typename Grid>
+    bool jps_search(const Grid& grid, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws)
+    {
+        size_t w = grid.width();
+        size_t h = grid.height();
+
+        //checks that start and goal cells are inside the grid map
+        if (start.x >= w || goal.x >= w) return false;
+        if (start.y >= h || goal.y >= h) return false;
+        if (grid.is_free((int)goal.x, (int)goal.y) == false) return false;
+
+        ws.prepare(w, h);
+        jump_helper<Grid> helper(grid, goal);
+        cell_index_type start_index = ws.to_index(start);
+        cell_index_type goal_index = ws.to_index(goal);
+        int gx = (int)goal.x;
+        int gy = (int)goal.y;
+
+        ws.set_node(start_index, 0, INVALID_CELL_INDEX);
+        ws.open_set.push(start_index, aStarIndexed_algorithm::octile_distance((int)start.x, (int)start.y, gx, gy));
+
+        std::vector<std::pair<int, int> > directions;
+        while (!ws.open_set.empty())
+        {
+            cell_index_type curr = ws.open_set.pop();
+            if (curr == goal_index)
+            {
+                //the came_from chain contains only the jump points: the intermediate cells are added here
+                std::deque<XYCell> jump_points;
+                if (!ws.reconstruct_path(start_index, goal_index, jump_points)) return false;
+                XYCell prev = start;
+                for (auto it = jump_points.begin(); it != jump_points.end(); it++)
+                {
+                    int x = (int)prev.x;
+                    int y = (int)prev.y;
+                    int sx = sign((int)it->x - x);
+                    int sy = sign((int)it->y - y);
+                    while (x != (int)it->x || y != (int)it->y)
+                    {
+                        x += sx;
+                        y += sy;
+                        path.push_back(XYCell(x, y));
+                    }
+                    prev = *it;
+                }
+                return true;
+            }
+
+            ws.set_closed(curr);
+            ws.stats.expanded_nodes++;
+            if (ws.must_stop())
+            {
+                yCDebug(PATHPLAN_JPS) << "search interrupted after" << ws.stats.expanded_nodes << "expansions";
+                return false;
+            }
+
+            int cx = (int)(curr % w);
+            int cy = (int)(curr / w);
+            double curr_g = ws.g_score(curr);
+
+            int dx = 0;
+            int dy = 0;
+            cell_index_type parent = ws.came_from(curr);
+            if (parent != INVALID_CELL_INDEX)
+            {
+                dx = sign(cx - (int)(parent % w));
+                dy = sign(cy - (int)(parent / w));
+            }
+
+            helper.pruned_directions(cx, cy, dx, dy, directions);
+            for (auto it = directions.begin(); it != directions.end(); it++)
+            {
+                int jx, jy;
+                if (!helper.jump(cx, cy, it->first, it->second, jx, jy)) continue;
+
+                cell_index_type successor = ws.to_index(jx, jy);
+                if (ws.is_closed(successor)) continue;
+
+                //a jump is either purely straight or purely diagonal, so its cost is the octile distance
+                double tentative_g_score = curr_g + aStarIndexed_algorithm::octile_distance(cx, cy, jx, jy);
+                if (tentative_g_score < ws.g_score(successor))
+                {
+                    ws.set_node(successor, tentative_g_score, curr);
+                    double f_score = tentative_g_score + aStarIndexed_algorithm::octile_distance(jx, jy, gx, gy);
+                    if (ws.open_set.contains(successor)) ws.open_set.decrease_key(successor, f_score);
+                    else                                 ws.open_set.push(successor, f_score);
+                }
+            }
+        }
+
+        //no path found
+        yCDebug(PATHPLAN_JPS) << "no path found after" << ws.stats.expanded_nodes << "expansions";
+        return false;
+    }
+}
+
+bool jps_algorithm::find_jps_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path)
+{
+    return find_jps_path(map, start, goal, path, aStarIndexed_algorithm::default_workspace());
+}
+
+bool jps_algorithm::find_jps_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws)
+{
+    return jps_search(map_grid_view(map), start, goal, path, ws);
+}
+
+bool jps_algorithm::find_jps_path(const planning_grid& grid, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws)
+{
+    return jps_search(grid, start, goal, path, ws);
+}
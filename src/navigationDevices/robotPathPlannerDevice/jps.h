@@ -0,0 +1,57 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef JPS_H
+#define JPS_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <deque>
+#include "searchWorkspace.h"
+#include "planningGrid.h"
+
+//! namespace containing an implementation of the Jump Point Search algorithm (Harabor and Grastien, 2011) on 8-connected grids
+namespace jps_algorithm
+{
+    /**
+    * This method computes (if exists) the path required to go from a start cell to a goal cell.
+    * Only the jump points are inserted in the open set, but the returned path contains every cell
+    * (as aStar_algorithm::find_astar_path() does) and it has the same cost, using 10 for straight moves and 14 for diagonal moves.
+    * @param map the gridmap containing the obstacles
+    * @param start the start cell(x,y)
+    * @param goal the arrival cell(x,y)
+    * @param path the computed sequence of cells required to go from  start cell to goal cell
+    * @return true if the path exists, false if no valid path has been found
+    */
+    bool find_jps_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path);
+
+    /**
+    * Same as above, using a workspace provided by the caller.
+    * @param workspace the search memory. After the call, workspace.stats contains the statistics of the search.
+    */
+    bool find_jps_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, planner_search::search_workspace& workspace);
+
+    /**
+    * Same as above, reading the obstacles from the packed copy of the map (see planner_search::planning_grid).
+    * The horizontal jumps scan 64 cells with each group of word operations.
+    * @param grid the traversability of the map, 1 bit per cell
+    */
+    bool find_jps_path(const planner_search::planning_grid& grid, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, planner_search::search_workspace& workspace);
+};
+
+#endif
@@ -0,0 +1,343 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/dev/MapGrid2D.h>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "layeredCostmap.h"
+
+using namespace std;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace obstacle_layers;
+
+void obstacle_layers::add_bounds(window_bounds& bounds, bool& bounds_empty, const window_bounds& other)
+{
+    if (bounds_empty)
+    {
+        bounds = other;
+        bounds_empty = false;
+        return;
+    }
+    bounds.x_min = std::min(bounds.x_min, other.x_min);
+    bounds.y_min = std::min(bounds.y_min, other.y_min);
+    bounds.x_max = std::max(bounds.x_max, other.x_max);
+    bounds.y_max = std::max(bounds.y_max, other.y_max);
+}
+
+namespace
+{
+    window_bounds whole_map(size_t width, size_t height)
+    {
+        window_bounds b;
+        b.x_min = 0;
+        b.y_min = 0;
+        b.x_max = (width > 0) ? width - 1 : 0;
+        b.y_max = (height > 0) ? height - 1 : 0;
+        return b;
+    }
+
+    //even-odd rule, in cell coordinates
+    bool inside_polygon(const std::vector<XYCell>& polygon, double x, double y)
+    {
+        bool inside = false;
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            double xi = polygon[i].x, yi = polygon[i].y;
+            double xj = polygon[j].x, yj = polygon[j].y;
+            if (((yi > y) != (yj > y)) && (x < (xj - xi) * (y - yi) / (yj - yi) + xi)) inside = !inside;
+        }
+        return inside;
+    }
+}
+
+/////////// static_layer
+static_layer::static_layer()
+{
+    m_width = 0;
+    m_height = 0;
+    m_changed_empty = true;
+}
+
+void static_layer::set_map(const MapGrid2D& map)
+{
+    m_width = map.width();
+    m_height = map.height();
+    m_flags.resize(m_width * m_height);
+    for (size_t y = 0; y < m_height; y++)
+        for (size_t x = 0; x < m_width; x++)
+        {
+            MapGrid2D::map_flags flag;
+            map.getMapFlag(XYCell(x, y), flag);
+            m_flags[y * m_width + x] = (uint8_t)flag;
+        }
+    m_changed = whole_map(m_width, m_height);
+    m_changed_empty = (m_flags.empty());
+}
+
+void static_layer::add_obstacles(const std::vector<XYCell>& cells, MapGrid2D::map_flags flag)
+{
+    for (auto it = cells.begin(); it != cells.end(); it++)
+    {
+        if (it->x >= m_width || it->y >= m_height) continue;
+        uint8_t& f = m_flags[it->y * m_width + it->x];
+        if (f != MapGrid2D::MAP_CELL_FREE) continue;
+        f = (uint8_t)flag;
+        window_bounds b;
+        b.x_min = b.x_max = it->x;
+        b.y_min = b.y_max = it->y;
+        add_bounds(m_changed, m_changed_empty, b);
+    }
+}
+
+bool static_layer::changed_bounds(window_bounds& bounds) const
+{
+    if (m_changed_empty) return false;
+    bounds = m_changed;
+    return true;
+}
+
+void static_layer::clear_changes()
+{
+    m_changed_empty = true;
+}
+
+MapGrid2D::map_flags static_layer::flag_at(const XYCell& cell) const
+{
+    if (cell.x >= m_width || cell.y >= m_height) return MapGrid2D::MAP_CELL_FREE;
+    return (MapGrid2D::map_flags)m_flags[cell.y * m_width + cell.x];
+}
+
+/////////// keep_out_layer
+keep_out_layer::keep_out_layer()
+{
+    m_width = 0;
+    m_height = 0;
+    m_changed_empty = true;
+    m_areas_empty = true;
+}
+
+void keep_out_layer::set_areas(const MapGrid2D& map, const std::vector<Map2DArea>& areas)
+{
+    if (map.width() != m_width || map.height() != m_height)
+    {
+        m_width = map.width();
+        m_height = map.height();
+        m_mask.assign(m_width * m_height, 0);
+        m_areas_empty = true;
+        m_changed = whole_map(m_width, m_height);
+        m_changed_empty = (m_mask.empty());
+    }
+    else if (m_areas_empty == false)
+    {
+        //the old areas are removed
+        for (size_t y = m_areas_bounds.y_min; y <= m_areas_bounds.y_max; y++)
+        {
+            memset(&m_mask[y * m_width + m_areas_bounds.x_min], 0, m_areas_bounds.x_max - m_areas_bounds.x_min + 1);
+        }
+        add_bounds(m_changed, m_changed_empty, m_areas_bounds);
+        m_areas_empty = true;
+    }
+    if (m_width == 0 || m_height == 0) return;
+
+    for (auto it = areas.begin(); it != areas.end(); it++)
+    {
+        if (it->points.size() < 3) continue;
+        std::vector<XYCell> polygon;
+        window_bounds b;
+        for (size_t j = 0; j < it->points.size(); j++)
+        {
+            XYCell c = map.world2Cell(XYWorld(it->points[j].x, it->points[j].y));
+            c.x = std::min(c.x, m_width - 1);
+            c.y = std::min(c.y, m_height - 1);
+            polygon.push_back(c);
+            if (j == 0) { b.x_min = b.x_max = c.x; b.y_min = b.y_max = c.y; }
+            b.x_min = std::min(b.x_min, c.x);
+            b.y_min = std::min(b.y_min, c.y);
+            b.x_max = std::max(b.x_max, c.x);
+            b.y_max = std::max(b.y_max, c.y);
+        }
+        for (size_t y = b.y_min; y <= b.y_max; y++)
+            for (size_t x = b.x_min; x <= b.x_max; x++)
+            {
+                if (inside_polygon(polygon, (double)x, (double)y)) m_mask[y * m_width + x] = 1;
+            }
+        add_bounds(m_areas_bounds, m_areas_empty, b);
+        add_bounds(m_changed, m_changed_empty, b);
+    }
+}
+
+bool keep_out_layer::changed_bounds(window_bounds& bounds) const
+{
+    if (m_changed_empty) return false;
+    bounds = m_changed;
+    return true;
+}
+
+void keep_out_layer::clear_changes()
+{
+    m_changed_empty = true;
+}
+
+MapGrid2D::map_flags keep_out_layer::flag_at(const XYCell& cell) const
+{
+    if (cell.x >= m_width || cell.y >= m_height) return MapGrid2D::MAP_CELL_FREE;
+    return m_mask[cell.y * m_width + cell.x] ? MapGrid2D::MAP_CELL_KEEP_OUT : MapGrid2D::MAP_CELL_FREE;
+}
+
+/////////// inflation_layer
+inflation_layer::inflation_layer()
+{
+    m_field = nullptr;
+    m_radius = 0;
+    m_width = 0;
+    m_height = 0;
+    m_changed = false;
+}
+
+void inflation_layer::set_field(const distanceTransform_algorithm::clearance_map* field, const MapGrid2D& map, double radius)
+{
+    //the field is recomputed only when the static map changes, so any call invalidates the whole layer
+    m_field = field;
+    m_radius = radius;
+    m_width = map.width();
+    m_height = map.height();
+    m_changed = (m_width > 0 && m_height > 0);
+}
+
+bool inflation_layer::changed_bounds(window_bounds& bounds) const
+{
+    if (m_changed == false) return false;
+    bounds = whole_map(m_width, m_height);
+    return true;
+}
+
+void inflation_layer::clear_changes()
+{
+    m_changed = false;
+}
+
+MapGrid2D::map_flags inflation_layer::flag_at(const XYCell& cell) const
+{
+    if (m_field == nullptr) return MapGrid2D::MAP_CELL_FREE;
+    return m_field->is_inflated(cell, m_radius) ? MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE : MapGrid2D::MAP_CELL_FREE;
+}
+
+/////////// laser_obstacle_layer
+laser_obstacle_layer::laser_obstacle_layer()
+{
+    m_source = nullptr;
+    m_previous_empty = true;
+}
+
+bool laser_obstacle_layer::changed_bounds(window_bounds& bounds) const
+{
+    bool empty = m_previous_empty;
+    if (empty == false) bounds = m_previous;
+    window_bounds current;
+    if (m_source && m_source->window(current)) add_bounds(bounds, empty, current);
+    return (empty == false);
+}
+
+void laser_obstacle_layer::clear_changes()
+{
+    m_previous_empty = (m_source == nullptr || m_source->window(m_previous) == false);
+}
+
+MapGrid2D::map_flags laser_obstacle_layer::flag_at(const XYCell& cell) const
+{
+    if (m_source == nullptr) return MapGrid2D::MAP_CELL_FREE;
+    return m_source->flag_at(cell);
+}
+
+/////////// layered_costmap
+layered_costmap::layered_costmap()
+{
+    m_master_valid = false;
+}
+
+void layered_costmap::add_layer(costmap_layer* layer)
+{
+    m_layers.push_back(layer);
+    m_master_valid = false;
+}
+
+void layered_costmap::reset(const MapGrid2D& map)
+{
+    m_master = map;
+    m_master_valid = false;
+}
+
+window_bounds layered_costmap::full_bounds() const
+{
+    return whole_map(m_master.width(), m_master.height());
+}
+
+bool layered_costmap::update(window_bounds* updated_bounds)
+{
+    if (m_master.width() == 0 || m_master.height() == 0) return false;
+
+    window_bounds bounds;
+    bool empty = true;
+    if (m_master_valid == false)
+    {
+        bounds = full_bounds();
+        empty = false;
+    }
+    for (auto it = m_layers.begin(); it != m_layers.end(); it++)
+    {
+        window_bounds b;
+        if ((*it)->changed_bounds(b)) add_bounds(bounds, empty, b);
+    }
+    if (empty) return false;
+
+    bounds.x_max = std::min(bounds.x_max, m_master.width() - 1);
+    bounds.y_max = std::min(bounds.y_max, m_master.height() - 1);
+    compose(m_master, bounds, m_layers.size(), nullptr);
+    for (auto it = m_layers.begin(); it != m_layers.end(); it++)
+    {
+        (*it)->clear_changes();
+    }
+    m_master_valid = true;
+    if (updated_bounds) *updated_bounds = bounds;
+    return true;
+}
+
+void layered_costmap::compose(MapGrid2D& target, const window_bounds& bounds, size_t layers_count, std::vector<XYCell>* changed_cells) const
+{
+    if (changed_cells) changed_cells->clear();
+    layers_count = std::min(layers_count, m_layers.size());
+    for (size_t y = bounds.y_min; y <= bounds.y_max && y < target.height(); y++)
+        for (size_t x = bounds.x_min; x <= bounds.x_max && x < target.width(); x++)
+        {
+            XYCell c(x, y);
+            MapGrid2D::map_flags flag = MapGrid2D::MAP_CELL_FREE;
+            for (size_t i = 0; i < layers_count && flag == MapGrid2D::MAP_CELL_FREE; i++)
+            {
+                flag = m_layers[i]->flag_at(c);
+            }
+            MapGrid2D::map_flags old_flag;
+            target.getMapFlag(c, old_flag);
+            if (old_flag != flag)
+            {
+                target.setMapFlag(c, flag);
+                if (changed_cells) changed_cells->push_back(c);
+            }
+        }
+}
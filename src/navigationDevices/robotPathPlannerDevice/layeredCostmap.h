@@ -0,0 +1,215 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef LAYERED_COSTMAP_H
+#define LAYERED_COSTMAP_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/dev/Map2DArea.h>
+
+#include <vector>
+#include <cstdint>
+#include "rollingWindowLayer.h"
+#include "distanceTransform.h"
+
+namespace obstacle_layers
+{
+    /**
+    * Extends a region so that it contains another one.
+    * @param bounds the region to be extended
+    * @param bounds_empty true if 'bounds' does not contain any cell yet. It is set to false.
+    * @param other the region to be added
+    */
+    void add_bounds(window_bounds& bounds, bool& bounds_empty, const window_bounds& other);
+
+    /**
+    * A layer of a layered_costmap. Each layer imposes a flag on a subset of the cells of the map, and keeps track of the
+    * region which changed since the last time the master grid was composed, so that only that region is recomposed.
+    */
+    class costmap_layer
+    {
+        public:
+        virtual ~costmap_layer() {}
+
+        /**
+        * @param bounds filled with the region changed since the last call to clear_changes()
+        * @return false if the layer did not change
+        */
+        virtual bool changed_bounds(window_bounds& bounds) const = 0;
+
+        /**
+        * Called by the layered_costmap once the changed region has been composed.
+        */
+        virtual void clear_changes() = 0;
+
+        /**
+        * @return the flag imposed by the layer on a cell, MAP_CELL_FREE if the layer does not affect it
+        */
+        virtual yarp::dev::Nav2D::MapGrid2D::map_flags flag_at(const yarp::dev::Nav2D::XYCell& cell) const = 0;
+    };
+
+    /**
+    * The map received from the map server, plus the obstacles which have been added to it permanently (see add_obstacles()).
+    */
+    class static_layer : public costmap_layer
+    {
+        std::vector<uint8_t> m_flags;
+        size_t               m_width;
+        size_t               m_height;
+        window_bounds        m_changed;
+        bool                 m_changed_empty;
+
+        public:
+        static_layer();
+        void set_map(const yarp::dev::Nav2D::MapGrid2D& map);
+
+        /**
+        * Marks the given cells with a flag, unless they are already occupied.
+        * @param cells the cells to be marked
+        * @param flag the flag of the new obstacles
+        */
+        void add_obstacles(const std::vector<yarp::dev::Nav2D::XYCell>& cells, yarp::dev::Nav2D::MapGrid2D::map_flags flag);
+
+        virtual bool changed_bounds(window_bounds& bounds) const override;
+        virtual void clear_changes() override;
+        virtual yarp::dev::Nav2D::MapGrid2D::map_flags flag_at(const yarp::dev::Nav2D::XYCell& cell) const override;
+    };
+
+    /**
+    * The areas of the map which the robot must not enter (MAP_CELL_KEEP_OUT).
+    */
+    class keep_out_layer : public costmap_layer
+    {
+        std::vector<uint8_t> m_mask;
+        size_t               m_width;
+        size_t               m_height;
+        window_bounds        m_changed;
+        bool                 m_changed_empty;
+        window_bounds        m_areas_bounds;
+        bool                 m_areas_empty;
+
+        public:
+        keep_out_layer();
+
+        /**
+        * Replaces the keep-out areas. Only the region covered by the old and the new areas is reported as changed.
+        * @param map the map the areas refer to
+        * @param areas the polygons (in world coordinates) of the keep-out areas
+        */
+        void set_areas(const yarp::dev::Nav2D::MapGrid2D& map, const std::vector<yarp::dev::Map2DArea>& areas);
+
+        virtual bool changed_bounds(window_bounds& bounds) const override;
+        virtual void clear_changes() override;
+        virtual yarp::dev::Nav2D::MapGrid2D::map_flags flag_at(const yarp::dev::Nav2D::XYCell& cell) const override;
+    };
+
+    /**
+    * The enlargement of the static obstacles by the robot radius (MAP_CELL_ENLARGED_OBSTACLE), read from a clearance field.
+    */
+    class inflation_layer : public costmap_layer
+    {
+        const distanceTransform_algorithm::clearance_map* m_field;
+        double               m_radius;
+        size_t               m_width;
+        size_t               m_height;
+        bool                 m_changed;
+
+        public:
+        inflation_layer();
+
+        /**
+        * @param field the clearance field of the static map. It is not copied, it must be kept alive by the caller.
+        * @param map the static map
+        * @param radius the enlargement radius (m)
+        */
+        void set_field(const distanceTransform_algorithm::clearance_map* field, const yarp::dev::Nav2D::MapGrid2D& map, double radius);
+
+        virtual bool changed_bounds(window_bounds& bounds) const override;
+        virtual void clear_changes() override;
+        virtual yarp::dev::Nav2D::MapGrid2D::map_flags flag_at(const yarp::dev::Nav2D::XYCell& cell) const override;
+    };
+
+    /**
+    * The obstacles detected by the last laser scan, as stored by a rolling_window_layer. The changed region is the union
+    * of the windows of the previous and of the current scan.
+    */
+    class laser_obstacle_layer : public costmap_layer
+    {
+        const rolling_window_layer* m_source;
+        window_bounds               m_previous;
+        bool                        m_previous_empty;
+
+        public:
+        laser_obstacle_layer();
+        void set_source(const rolling_window_layer* source) { m_source = source; }
+
+        virtual bool changed_bounds(window_bounds& bounds) const override;
+        virtual void clear_changes() override;
+        virtual yarp::dev::Nav2D::MapGrid2D::map_flags flag_at(const yarp::dev::Nav2D::XYCell& cell) const override;
+    };
+
+    /**
+    * A master grid composed by a stack of layers. The layers are composed in order: a cell takes the flag of the first
+    * layer which does not mark it as free. When the layers change, the master grid is recomposed only inside the union
+    * of the regions they report, so the cost of an update is proportional to the changed area and not to the map size.
+    * The layers are not owned by the costmap.
+    */
+    class layered_costmap
+    {
+        std::vector<costmap_layer*> m_layers;
+        yarp::dev::Nav2D::MapGrid2D m_master;
+        bool                        m_master_valid;
+
+        public:
+        layered_costmap();
+        void add_layer(costmap_layer* layer);
+        size_t number_of_layers() const { return m_layers.size(); }
+
+        /**
+        * Initializes the master grid from a map (size, resolution, origin, name). The whole grid is composed by the next update().
+        */
+        void reset(const yarp::dev::Nav2D::MapGrid2D& map);
+
+        /**
+        * Recomposes the master grid inside the region changed by the layers.
+        * @param updated_bounds if not null, filled with the recomposed region
+        * @return false if nothing changed
+        */
+        bool update(window_bounds* updated_bounds = nullptr);
+
+        /**
+        * Composes the first layers of the stack into another map, inside a region. This allows to keep a map which
+        * ignores the last layers (e.g. the planning map, which does not contain the obstacles detected by the sensors).
+        * @param target the map to be written, which must have the size of the master grid
+        * @param bounds the region to be composed
+        * @param layers_count the number of layers (from the bottom of the stack) to be composed
+        * @param changed_cells if not null, filled with the cells of target whose flag has been modified
+        */
+        void compose(yarp::dev::Nav2D::MapGrid2D& target, const window_bounds& bounds, size_t layers_count, std::vector<yarp::dev::Nav2D::XYCell>* changed_cells) const;
+
+        /**
+        * @return the whole map
+        */
+        window_bounds full_bounds() const;
+
+        yarp::dev::Nav2D::MapGrid2D&       master() { return m_master; }
+        const yarp::dev::Nav2D::MapGrid2D& master() const { return m_master; }
+    };
+};
+
+#endif
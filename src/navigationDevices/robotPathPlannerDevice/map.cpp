@@ -26,6 +26,12 @@
 
 #include "map.h"
 #include "aStar.h"
+#include "aStarIndexed.h"
+#include "jps.h"
+#include "dStarLite.h"
+#include "hpaStar.h"
+#include "thetaStar.h"
+#include "araStar.h"
 
 using namespace std;
 using namespace yarp::os;
@@ -87,7 +93,7 @@ bool map_utilites::simplifyPath(MapGrid2D& map, Map2DPath input_path, Map2DPath&
     return true;
 };
 
-void map_utilites::update_obstacles_map(MapGrid2D& map_to_be_updated, const MapGrid2D& obstacles_map)
+void map_utilites::update_obstacles_map(MapGrid2D& map_to_be_updated, const MapGrid2D& obstacles_map, std::vector<XYCell>* changed_cells)
 {
     //copies obstacles (and only them) from a source map to a destination map
     if (map_to_be_updated.width() != obstacles_map.width() ||
@@ -108,10 +114,12 @@ void map_utilites::update_obstacles_map(MapGrid2D& map_to_be_updated, const MapG
                 if      (flag_src==MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE)
                 { 
                     map_to_be_updated.setMapFlag(XYCell(x, y),MapGrid2D::MAP_CELL_KEEP_OUT);
+                    if (changed_cells) changed_cells->push_back(XYCell(x, y));
                 }
                 else if (flag_src==MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE)
                 {
                     map_to_be_updated.setMapFlag(XYCell(x, y), MapGrid2D::MAP_CELL_KEEP_OUT);
+                    if (changed_cells) changed_cells->push_back(XYCell(x, y));
                 }
             }
         }
@@ -149,11 +157,95 @@ bool map_utilites::checkStraightLine(MapGrid2D& map, XYCell src, XYCell dst)
     return true;
 }
 
-bool map_utilites::findPath(MapGrid2D& map, XYCell start, XYCell goal, Map2DPath& path)
+bool map_utilites::stringToPlannerAlgorithm(const std::string& name, planner_algorithm_type& algorithm)
 {
-    //computes path from start to goal using A* algorithm
+    if      (name == "astar_legacy")  { algorithm = PLANNER_ASTAR_LEGACY;  return true; }
+    else if (name == "astar")         { algorithm = PLANNER_ASTAR_INDEXED; return true; }
+    else if (name == "jps")           { algorithm = PLANNER_JPS;           return true; }
+    else if (name == "dstar_lite")    { algorithm = PLANNER_DSTAR_LITE;    return true; }
+    else if (name == "hpa_star")      { algorithm = PLANNER_HPA_STAR;      return true; }
+    else if (name == "theta_star")    { algorithm = PLANNER_THETA_STAR;    return true; }
+    else if (name == "ara_star")      { algorithm = PLANNER_ARA_STAR;      return true; }
+    return false;
+}
+
+std::string map_utilites::plannerAlgorithmToString(planner_algorithm_type algorithm)
+{
+    switch (algorithm)
+    {
+        case PLANNER_ASTAR_LEGACY:  return "astar_legacy";
+        case PLANNER_ASTAR_INDEXED: return "astar";
+        case PLANNER_JPS:           return "jps";
+        case PLANNER_DSTAR_LITE:    return "dstar_lite";
+        case PLANNER_HPA_STAR:      return "hpa_star";
+        case PLANNER_THETA_STAR:    return "theta_star";
+        case PLANNER_ARA_STAR:      return "ara_star";
+    }
+    return "unknown";
+}
+
+bool map_utilites::plannerAlgorithmSupportsCellCosts(planner_algorithm_type algorithm)
+{
+    return (algorithm == PLANNER_ASTAR_LEGACY || algorithm == PLANNER_ASTAR_INDEXED || algorithm == PLANNER_ARA_STAR);
+}
+
+bool map_utilites::plannerAlgorithmIsOptimalGridSearch(planner_algorithm_type algorithm)
+{
+    return (algorithm == PLANNER_ASTAR_LEGACY || algorithm == PLANNER_ASTAR_INDEXED || algorithm == PLANNER_JPS);
+}
+
+bool map_utilites::findPath(MapGrid2D& map, XYCell start, XYCell goal, Map2DPath& path, planner_algorithm_type algorithm, const std::vector<float>* cell_costs, const planner_search::planning_grid* grid)
+{
+    //a packed grid which does not belong to this map (e.g. built before a map update) is ignored
+    if (grid && grid->matches(map) == false) grid = nullptr;
+
+    //computes path from start to goal using the requested search algorithm
     std::deque<XYCell> cell_path;
-    bool b = aStar_algorithm::find_astar_path(map, start, goal, cell_path);
+    bool b = false;
+    switch (algorithm)
+    {
+        case PLANNER_ASTAR_LEGACY:
+            b = aStar_algorithm::find_astar_path(map, start, goal, cell_path, cell_costs);
+            break;
+        case PLANNER_JPS:
+            if (grid) b = jps_algorithm::find_jps_path(*grid, start, goal, cell_path, aStarIndexed_algorithm::default_workspace());
+            else      b = jps_algorithm::find_jps_path(map, start, goal, cell_path);
+            break;
+        case PLANNER_DSTAR_LITE:
+        {
+            //one-shot search. The incremental replanning is performed by PlannerThread, which keeps the planner alive between calls
+            dStarLite_algorithm::dstar_lite_planner planner;
+            b = planner.initialize(map, goal) && planner.compute_path(start, cell_path);
+        }
+            break;
+        case PLANNER_HPA_STAR:
+        {
+            //one-shot search. PlannerThread keeps a cache of the abstract graphs, which avoids to rebuild them for each query
+            hpaStar_algorithm::abstract_graph graph;
+            b = graph.build(map, hpaStar_algorithm::DEFAULT_CLUSTER_SIZE) && hpaStar_algorithm::find_hpa_path(graph, map, start, goal, cell_path);
+        }
+            break;
+        case PLANNER_THETA_STAR:
+        {
+            std::deque<XYCell> waypoints;
+            if (grid) b = thetaStar_algorithm::find_theta_path(*grid, start, goal, waypoints, aStarIndexed_algorithm::default_workspace());
+            else      b = thetaStar_algorithm::find_theta_path(map, start, goal, waypoints, aStarIndexed_algorithm::default_workspace());
+            if (b) thetaStar_algorithm::expand_waypoints(start, waypoints, cell_path);
+        }
+            break;
+        case PLANNER_ARA_STAR:
+        {
+            double epsilon = 0;
+            if (grid) b = araStar_algorithm::find_ara_path(*grid, start, goal, cell_path, aStarIndexed_algorithm::default_workspace(), cell_costs, araStar_algorithm::ara_parameters(), epsilon);
+            else      b = araStar_algorithm::find_ara_path(map, start, goal, cell_path, aStarIndexed_algorithm::default_workspace(), cell_costs, araStar_algorithm::ara_parameters(), epsilon);
+        }
+            break;
+        case PLANNER_ASTAR_INDEXED:
+        default:
+            if (grid) b = aStarIndexed_algorithm::find_astar_path(*grid, start, goal, cell_path, aStarIndexed_algorithm::default_workspace(), cell_costs);
+            else      b = aStarIndexed_algorithm::find_astar_path(map, start, goal, cell_path, aStarIndexed_algorithm::default_workspace(), cell_costs);
+            break;
+    }
     if (b)
     {
         for (auto it = cell_path.begin(); it != cell_path.end(); it++)
@@ -165,3 +257,58 @@ bool map_utilites::findPath(MapGrid2D& map, XYCell start, XYCell goal, Map2DPath
     }
     return false;
 }
+
+bool map_utilites::findAnyAnglePath(MapGrid2D& map, XYCell start, XYCell goal, Map2DPath& path, Map2DPath& waypoints, const planner_search::planning_grid* grid)
+{
+    std::deque<XYCell> cell_waypoints;
+    bool b = false;
+    if (grid && grid->matches(map)) b = thetaStar_algorithm::find_theta_path(*grid, start, goal, cell_waypoints, aStarIndexed_algorithm::default_workspace());
+    else                            b = thetaStar_algorithm::find_theta_path(map, start, goal, cell_waypoints, aStarIndexed_algorithm::default_workspace());
+    if (b == false) return false;
+
+    std::deque<XYCell> cell_path;
+    thetaStar_algorithm::expand_waypoints(start, cell_waypoints, cell_path);
+    for (auto it = cell_path.begin(); it != cell_path.end(); it++)
+    {
+        path.push_back(map.toLocation(*it));
+    }
+    for (auto it = cell_waypoints.begin(); it != cell_waypoints.end(); it++)
+    {
+        waypoints.push_back(map.toLocation(*it));
+    }
+    return true;
+}
+
+uint64_t map_utilites::computeMapHash(const MapGrid2D& map)
+{
+    //FNV-1a hash, as hpaStar_algorithm::compute_map_hash(), which instead considers only the traversability of the cells
+    uint64_t hash = 14695981039346656037ULL;
+    auto hash_bytes = [&hash](const void* data, size_t size)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        for (size_t i = 0; i < size; i++) { hash ^= bytes[i]; hash *= 1099511628211ULL; }
+    };
+    size_t width = map.width();
+    size_t height = map.height();
+    double resolution = 0;
+    double origin_x = 0;
+    double origin_y = 0;
+    double origin_theta = 0;
+    map.getResolution(resolution);
+    map.getOrigin(origin_x, origin_y, origin_theta);
+    hash_bytes(&width, sizeof(width));
+    hash_bytes(&height, sizeof(height));
+    hash_bytes(&resolution, sizeof(resolution));
+    hash_bytes(&origin_x, sizeof(origin_x));
+    hash_bytes(&origin_y, sizeof(origin_y));
+    hash_bytes(&origin_theta, sizeof(origin_theta));
+    for (size_t y = 0; y < height; y++)
+        for (size_t x = 0; x < width; x++)
+        {
+            MapGrid2D::map_flags flag = MapGrid2D::MAP_CELL_UNKNOWN;
+            map.getMapFlag(XYCell(x, y), flag);
+            uint8_t byte = (uint8_t)(flag);
+            hash_bytes(&byte, 1);
+        }
+    return hash;
+}
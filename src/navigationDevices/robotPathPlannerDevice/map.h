@@ -28,6 +28,8 @@
 #include <yarp/dev/MapGrid2D.h>
 #include <string>
 #include <queue>
+#include <vector>
+#include "planningGrid.h"
 
 using namespace std;
 using namespace yarp::os;
@@ -45,11 +47,46 @@ namespace map_utilites
     //simplify the path
     bool simplifyPath(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::Map2DPath input_path, yarp::dev::Nav2D::Map2DPath& output_path);
 
+    //the search algorithms which can be used by findPath(), selected through the `planner_algorithm` parameter
+    enum planner_algorithm_type
+    {
+        PLANNER_ASTAR_LEGACY  = 0,
+        PLANNER_ASTAR_INDEXED = 1,
+        PLANNER_JPS           = 2,
+        PLANNER_DSTAR_LITE    = 3,
+        PLANNER_HPA_STAR      = 4,
+        PLANNER_THETA_STAR    = 5,
+        PLANNER_ARA_STAR      = 6
+    };
+
+    //converts the value of the `planner_algorithm` parameter into a planner_algorithm_type. Returns false if the string is not recognized.
+    bool stringToPlannerAlgorithm(const std::string& name, planner_algorithm_type& algorithm);
+
+    //returns the name of a planner_algorithm_type, as used in the configuration file
+    std::string plannerAlgorithmToString(planner_algorithm_type algorithm);
+
     //compute a path, given a start cell, a goal cell and a map grid.
-    bool findPath(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, yarp::dev::Nav2D::Map2DPath& path);
+    //The optional per-cell costs (e.g. the clearance cost) are used only by the A* algorithms (astar_legacy, astar, ara_star).
+    //The optional packed copy of the map (built with planning_grid::build() from the same map) is used by astar, jps, theta_star and ara_star.
+    //ara_star runs all its passes, down to epsilon = 1 (unless the search is interrupted through the default workspace).
+    bool findPath(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, yarp::dev::Nav2D::Map2DPath& path, planner_algorithm_type algorithm = PLANNER_ASTAR_INDEXED, const std::vector<float>* cell_costs = nullptr, const planner_search::planning_grid* grid = nullptr);
+
+    //compute an any-angle path (planner_algorithm = theta_star). The search directly produces the waypoints of the path,
+    //so simplifyPath() is not needed: `path` receives all the traversed cells, `waypoints` only the cells where the direction changes.
+    bool findAnyAnglePath(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, yarp::dev::Nav2D::Map2DPath& path, yarp::dev::Nav2D::Map2DPath& waypoints, const planner_search::planning_grid* grid = nullptr);
+
+    //returns true if the algorithm supports additional per-cell costs
+    bool plannerAlgorithmSupportsCellCosts(planner_algorithm_type algorithm);
+
+    //returns true if the algorithm computes a minimum cost path on the 8-connected grid (astar_legacy, astar, jps),
+    //i.e. the same path can be extracted from a navigation function rooted at the goal
+    bool plannerAlgorithmIsOptimalGridSearch(planner_algorithm_type algorithm);
+
+    //hash of the geometry of a map (size, resolution, origin) and of the flags of all its cells. The name is not included
+    uint64_t computeMapHash(const yarp::dev::Nav2D::MapGrid2D& map);
 
-    // register new obstacles into a map
-    void update_obstacles_map(yarp::dev::Nav2D::MapGrid2D& map_to_be_updated, const yarp::dev::Nav2D::MapGrid2D& obstacles_map);
+    // register new obstacles into a map. If changed_cells is not null, the modified cells are appended to it
+    void update_obstacles_map(yarp::dev::Nav2D::MapGrid2D& map_to_be_updated, const yarp::dev::Nav2D::MapGrid2D& obstacles_map, std::vector<yarp::dev::Nav2D::XYCell>* changed_cells = nullptr);
 };
 
 #endif
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include "mapChangeTracker.h"
+
+using namespace std;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace map_versioning;
+
+tile_change_tracker::tile_change_tracker(size_t tile_size)
+{
+    m_tile_size = (tile_size > 0) ? tile_size : DEFAULT_TILE_SIZE;
+    m_width = 0;
+    m_height = 0;
+    m_tiles_x = 0;
+    m_tiles_y = 0;
+    m_version = 0;
+    m_reset_version = 0;
+
+    //the random device alone may be deterministic on some platforms. The epoch is positive (it is sent as an int64) and never 0
+    std::random_device rd;
+    uint64_t seed = ((uint64_t)(rd()) << 32) ^ rd() ^ (uint64_t)(std::chrono::system_clock::now().time_since_epoch().count());
+    m_epoch = (std::mt19937_64(seed)() >> 2) + 1;
+}
+
+void tile_change_tracker::reset(size_t width, size_t height)
+{
+    m_width = width;
+    m_height = height;
+    m_tiles_x = (width + m_tile_size - 1) / m_tile_size;
+    m_tiles_y = (height + m_tile_size - 1) / m_tile_size;
+    m_version++;
+    m_reset_version = m_version;
+    m_tile_version.assign(m_tiles_x * m_tiles_y, m_version);
+}
+
+void tile_change_tracker::mark_cells(const std::vector<XYCell>& cells)
+{
+    if (cells.empty()) return;
+    m_version++;
+    for (auto it = cells.begin(); it != cells.end(); it++)
+    {
+        if (it->x >= m_width || it->y >= m_height) continue;
+        m_tile_version[(it->y / m_tile_size) * m_tiles_x + it->x / m_tile_size] = m_version;
+    }
+}
+
+update_type tile_change_tracker::changes_since(uint64_t client_version, std::vector<tile_bounds>& tiles) const
+{
+    tiles.clear();
+    if (client_version == m_version) return UPDATE_NONE;
+    //a version newer than the current one belongs to a previous instance of the server
+    if (client_version < m_reset_version || client_version > m_version) return UPDATE_FULL;
+
+    size_t changed_cells = 0;
+    for (size_t ty = 0; ty < m_tiles_y; ty++)
+        for (size_t tx = 0; tx < m_tiles_x; tx++)
+        {
+            if (m_tile_version[ty * m_tiles_x + tx] <= client_version) continue;
+            tile_bounds t;
+            t.x = tx * m_tile_size;
+            t.y = ty * m_tile_size;
+            t.w = std::min(m_tile_size, m_width - t.x);
+            t.h = std::min(m_tile_size, m_height - t.y);
+            tiles.push_back(t);
+            changed_cells += t.w * t.h;
+        }
+    if (changed_cells * 2 > m_width * m_height)
+    {
+        tiles.clear();
+        return UPDATE_FULL;
+    }
+    return UPDATE_TILES;
+}
+
+update_type tile_change_tracker::changes_since(uint64_t client_epoch, uint64_t client_version, std::vector<tile_bounds>& tiles) const
+{
+    //the same version number of a previous instance of the server may refer to a different map
+    if (client_epoch != m_epoch)
+    {
+        tiles.clear();
+        return UPDATE_FULL;
+    }
+    return changes_since(client_version, tiles);
+}
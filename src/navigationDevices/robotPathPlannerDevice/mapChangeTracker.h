@@ -0,0 +1,109 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef MAP_CHANGE_TRACKER_H
+#define MAP_CHANGE_TRACKER_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//! namespace containing the bookkeeping required to send to the clients only the parts of a map which changed
+namespace map_versioning
+{
+    const size_t DEFAULT_TILE_SIZE = 32;
+
+    //a rectangular portion of the map (cells), x and y included, x+w and y+h excluded
+    struct tile_bounds
+    {
+        size_t x;
+        size_t y;
+        size_t w;
+        size_t h;
+    };
+
+    enum update_type
+    {
+        UPDATE_NONE  = 0,
+        UPDATE_TILES = 1,
+        UPDATE_FULL  = 2
+    };
+
+    /**
+    * Keeps track of the changes of a map at tile granularity. The map has a version number, which is incremented by each
+    * modification, and each tile stores the version of its last modification. A client which knows the version of its copy of
+    * the map can be sent nothing (its copy is up to date), the tiles modified after that version, or the whole map (its copy
+    * is too old, or the map has been replaced since then).
+    * The versions restart from zero in each instance of the tracker, so each instance has also a random epoch: a remote client
+    * stores it together with the version, and receives the whole map if the server has been restarted in the meantime.
+    */
+    class tile_change_tracker
+    {
+        std::vector<uint64_t> m_tile_version;
+        size_t                m_tile_size;
+        size_t                m_width;
+        size_t                m_height;
+        size_t                m_tiles_x;
+        size_t                m_tiles_y;
+        uint64_t              m_version;
+        uint64_t              m_reset_version;
+        uint64_t              m_epoch;
+
+        public:
+        tile_change_tracker(size_t tile_size = DEFAULT_TILE_SIZE);
+
+        /**
+        * Records that the whole map has been replaced: the clients will receive the full map.
+        * @param width the width of the new map (cells)
+        * @param height the height of the new map (cells)
+        */
+        void reset(size_t width, size_t height);
+
+        /**
+        * Records the modification of some cells. The version is incremented only if the list is not empty.
+        * @param cells the modified cells
+        */
+        void mark_cells(const std::vector<yarp::dev::Nav2D::XYCell>& cells);
+
+        uint64_t version() const { return m_version; }
+        uint64_t epoch() const { return m_epoch; }
+        size_t   tile_size() const { return m_tile_size; }
+
+        /**
+        * Computes what has to be sent to a client in order to update its copy of the map.
+        * The full map is required if the changed tiles cover more than half of the map.
+        * @param client_version the version of the copy owned by the client (0 if the client has no copy)
+        * @param tiles filled with the modified tiles, if the result is UPDATE_TILES
+        * @return the type of update
+        */
+        update_type changes_since(uint64_t client_version, std::vector<tile_bounds>& tiles) const;
+
+        /**
+        * As above, for a client which may have received its copy from a previous instance of the tracker.
+        * @param client_epoch the epoch of the tracker which provided the copy owned by the client (0 if the client has no copy)
+        * @param client_version the version of the copy owned by the client (0 if the client has no copy)
+        * @param tiles filled with the modified tiles, if the result is UPDATE_TILES
+        * @return the type of update, UPDATE_FULL if the epoch does not match
+        */
+        update_type changes_since(uint64_t client_epoch, uint64_t client_version, std::vector<tile_bounds>& tiles) const;
+    };
+};
+
+#endif
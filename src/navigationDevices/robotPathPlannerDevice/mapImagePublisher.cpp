@@ -0,0 +1,323 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Time.h>
+#include <algorithm>
+#include <math.h>
+#include "mapImagePublisher.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::sig;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+
+namespace
+{
+    //the most relevant flag of a block of cells is drawn when the image is downscaled
+    int flag_priority(MapGrid2D::map_flags flag)
+    {
+        switch (flag)
+        {
+            case MapGrid2D::MAP_CELL_WALL:               return 5;
+            case MapGrid2D::MAP_CELL_KEEP_OUT:           return 4;
+            case MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE: return 3;
+            case MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE:  return 2;
+            case MapGrid2D::MAP_CELL_UNKNOWN:            return 1;
+            default:                                     return 0;
+        }
+    }
+
+    PixelRgb flag_color(MapGrid2D::map_flags flag)
+    {
+        switch (flag)
+        {
+            case MapGrid2D::MAP_CELL_WALL:               return PixelRgb(0, 0, 0);
+            case MapGrid2D::MAP_CELL_KEEP_OUT:           return PixelRgb(255, 180, 180);
+            case MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE: return PixelRgb(100, 100, 200);
+            case MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE:  return PixelRgb(200, 200, 255);
+            case MapGrid2D::MAP_CELL_UNKNOWN:            return PixelRgb(205, 205, 205);
+            default:                                     return PixelRgb(255, 255, 255);
+        }
+    }
+
+    const PixelRgb OBSTACLE_COLOR(255, 120, 0);
+    const PixelRgb PATH_COLOR(0, 200, 0);
+    const PixelRgb WAYPOINT_COLOR(0, 100, 0);
+    const PixelRgb GOAL_COLOR(200, 0, 0);
+    const PixelRgb ROBOT_COLOR(0, 128, 255);
+
+    uint64_t fnv_add(uint64_t h, uint64_t v)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            h ^= (v >> (i * 8)) & 0xFF;
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    //the region of the map (cells) drawn in the frame and its scale
+    struct frame_window
+    {
+        int x0;
+        int y0;
+        int scale;
+        int width;   //pixels
+        int height;  //pixels
+
+        bool to_pixel(const XYCell& c, int& px, int& py) const
+        {
+            px = ((int)c.x - x0) / scale;
+            py = ((int)c.y - y0) / scale;
+            return (int)c.x >= x0 && (int)c.y >= y0 && px < width && py < height;
+        }
+    };
+
+    void set_pixel(ImageOf<PixelRgb>& image, int x, int y, const PixelRgb& color)
+    {
+        if (x < 0 || y < 0 || x >= (int)image.width() || y >= (int)image.height()) return;
+        image.pixel(x, y) = color;
+    }
+
+    void draw_line(ImageOf<PixelRgb>& image, int x0, int y0, int x1, int y1, const PixelRgb& color)
+    {
+        int dx = abs(x1 - x0);
+        int dy = abs(y1 - y0);
+        int sx = (x0 < x1) ? 1 : -1;
+        int sy = (y0 < y1) ? 1 : -1;
+        int err = dx - dy;
+        while (true)
+        {
+            set_pixel(image, x0, y0, color);
+            if (x0 == x1 && y0 == y1) break;
+            int e2 = err * 2;
+            if (e2 > -dy) { err -= dy; x0 += sx; }
+            if (e2 < dx)  { err += dx; y0 += sy; }
+        }
+    }
+
+    //the points are converted to pixels without clipping, so that the lines which cross the border of a cropped frame are still drawn
+    void cell_to_pixel(const frame_window& w, const XYCell& c, int& px, int& py)
+    {
+        px = (int)floor(((double)c.x - w.x0) / w.scale);
+        py = (int)floor(((double)c.y - w.y0) / w.scale);
+    }
+}
+
+MapImagePublisher::MapImagePublisher()
+{
+    m_port = nullptr;
+    m_period = 0;
+    m_crop_size = 0;
+    m_downscale = 1;
+    m_last_publish_time = 0;
+    m_background_version = 0;
+    m_last_frame_key = 0;
+    m_last_frame_valid = false;
+    m_last_output_count = 0;
+}
+
+void MapImagePublisher::configure(BufferedPort<ImageOf<PixelRgb> >* port, double frequency, double crop_size, size_t downscale)
+{
+    m_port = port;
+    m_period = (frequency > 0) ? 1.0 / frequency : 0;
+    m_crop_size = std::max(crop_size, 0.0);
+    m_downscale = std::max(downscale, (size_t)1);
+    m_background_map_name.clear();
+    m_last_frame_valid = false;
+}
+
+bool MapImagePublisher::publish(const MapGrid2D& map, const map_versioning::tile_change_tracker& map_changes,
+                                const std::vector<XYCell>& obstacle_cells, const Map2DLocation& robot,
+                                const std::deque<Map2DLocation>& path, const Map2DLocation* goal)
+{
+    if (m_port == nullptr || m_period <= 0) return false;
+
+    //nothing is rendered if nobody is reading
+    int output_count = m_port->getOutputCount();
+    if (output_count == 0)
+    {
+        m_last_output_count = 0;
+        return false;
+    }
+    double now = yarp::os::Time::now();
+    if (now - m_last_publish_time < m_period) return false;
+    if (map.width() == 0 || map.height() == 0) return false;
+
+    //nothing is rendered if the content of the frame did not change, unless a new reader connected
+    XYCell robot_cell = map.world2Cell(XYWorld(robot.x, robot.y));
+    uint64_t key = 14695981039346656037ULL;
+    for (auto c = map.getMapName().begin(); c != map.getMapName().end(); c++) key = fnv_add(key, (uint64_t)*c);
+    key = fnv_add(key, map_changes.version());
+    key = fnv_add(key, ((uint64_t)robot_cell.x << 32) | robot_cell.y);
+    key = fnv_add(key, (uint64_t)(int64_t)floor(robot.theta / 5.0));
+    for (auto it = obstacle_cells.begin(); it != obstacle_cells.end(); it++) key = fnv_add(key, ((uint64_t)it->x << 32) | it->y);
+    for (auto it = path.begin(); it != path.end(); it++)
+    {
+        XYCell c = map.world2Cell(XYWorld(it->x, it->y));
+        key = fnv_add(key, ((uint64_t)c.x << 32) | c.y);
+    }
+    if (goal)
+    {
+        XYCell c = map.world2Cell(XYWorld(goal->x, goal->y));
+        key = fnv_add(key, ((uint64_t)c.x << 32) | c.y);
+    }
+    if (m_last_frame_valid && key == m_last_frame_key && output_count <= m_last_output_count) return false;
+
+    ImageOf<PixelRgb>& image = m_port->prepare();
+    render(map, map_changes, obstacle_cells, robot, path, goal, image);
+    m_port->write();
+    m_last_publish_time = now;
+    m_last_frame_key = key;
+    m_last_frame_valid = true;
+    m_last_output_count = output_count;
+    return true;
+}
+
+void MapImagePublisher::render_background_region(const MapGrid2D& map, size_t x0, size_t y0, size_t x1, size_t y1)
+{
+    size_t s = m_downscale;
+    for (size_t py = y0; py < y1; py++)
+        for (size_t px = x0; px < x1; px++)
+        {
+            MapGrid2D::map_flags best = MapGrid2D::MAP_CELL_FREE;
+            int best_priority = -1;
+            for (size_t y = py * s; y < (py + 1) * s && y < map.height(); y++)
+                for (size_t x = px * s; x < (px + 1) * s && x < map.width(); x++)
+                {
+                    MapGrid2D::map_flags flag;
+                    map.getMapFlag(XYCell(x, y), flag);
+                    int p = flag_priority(flag);
+                    if (p > best_priority) { best_priority = p; best = flag; }
+                }
+            m_background.pixel(px, py) = flag_color(best);
+        }
+}
+
+void MapImagePublisher::update_background(const MapGrid2D& map, const map_versioning::tile_change_tracker& map_changes)
+{
+    size_t s = m_downscale;
+    size_t w = (map.width() + s - 1) / s;
+    size_t h = (map.height() + s - 1) / s;
+    std::vector<map_versioning::tile_bounds> tiles;
+    map_versioning::update_type update = map_versioning::UPDATE_FULL;
+    if (m_background_map_name == map.getMapName() &&
+        (size_t)m_background.width() == w && (size_t)m_background.height() == h)
+    {
+        if (m_background_version == map_changes.version()) return;
+        update = map_changes.changes_since(m_background_version, tiles);
+    }
+
+    if (update == map_versioning::UPDATE_FULL)
+    {
+        m_background.resize(w, h);
+        render_background_region(map, 0, 0, w, h);
+    }
+    else if (update == map_versioning::UPDATE_TILES)
+    {
+        //only the pixels covering the modified tiles are redrawn
+        for (auto it = tiles.begin(); it != tiles.end(); it++)
+        {
+            render_background_region(map, it->x / s, it->y / s, std::min((it->x + it->w + s - 1) / s, w), std::min((it->y + it->h + s - 1) / s, h));
+        }
+    }
+    m_background_map_name = map.getMapName();
+    m_background_version = map_changes.version();
+}
+
+void MapImagePublisher::render(const MapGrid2D& map, const map_versioning::tile_change_tracker& map_changes,
+                               const std::vector<XYCell>& obstacle_cells, const Map2DLocation& robot,
+                               const std::deque<Map2DLocation>& path, const Map2DLocation* goal,
+                               ImageOf<PixelRgb>& image)
+{
+    update_background(map, map_changes);
+
+    //the window (cells) is aligned to the pixels of the background
+    int s = (int)m_downscale;
+    XYCell robot_cell = map.world2Cell(XYWorld(robot.x, robot.y));
+    int x0 = 0;
+    int y0 = 0;
+    int x1 = (int)map.width();
+    int y1 = (int)map.height();
+    double resolution = 0;
+    map.getResolution(resolution);
+    if (m_crop_size > 0 && resolution > 0)
+    {
+        int half = (int)ceil(m_crop_size / resolution / 2);
+        x0 = std::max((int)robot_cell.x - half, 0);
+        y0 = std::max((int)robot_cell.y - half, 0);
+        x1 = std::min((int)robot_cell.x + half + 1, x1);
+        y1 = std::min((int)robot_cell.y + half + 1, y1);
+        if (x1 <= x0 || y1 <= y0) { x0 = 0; y0 = 0; x1 = (int)map.width(); y1 = (int)map.height(); }
+    }
+    frame_window w;
+    w.scale = s;
+    w.x0 = (x0 / s) * s;
+    w.y0 = (y0 / s) * s;
+    w.width = std::min((x1 - w.x0 + s - 1) / s, (int)m_background.width() - w.x0 / s);
+    w.height = std::min((y1 - w.y0 + s - 1) / s, (int)m_background.height() - w.y0 / s);
+
+    image.resize(w.width, w.height);
+    for (int y = 0; y < w.height; y++)
+        for (int x = 0; x < w.width; x++)
+        {
+            image.pixel(x, y) = m_background.pixel(x + w.x0 / s, y + w.y0 / s);
+        }
+
+    //laser obstacles
+    int px, py;
+    for (auto it = obstacle_cells.begin(); it != obstacle_cells.end(); it++)
+    {
+        if (w.to_pixel(*it, px, py)) set_pixel(image, px, py, OBSTACLE_COLOR);
+    }
+
+    //remaining path, from the robot to the goal
+    int rx, ry;
+    cell_to_pixel(w, robot_cell, rx, ry);
+    int lx = rx, ly = ry;
+    for (auto it = path.begin(); it != path.end(); it++)
+    {
+        cell_to_pixel(w, map.world2Cell(XYWorld(it->x, it->y)), px, py);
+        draw_line(image, lx, ly, px, py, PATH_COLOR);
+        lx = px;
+        ly = py;
+    }
+    for (auto it = path.begin(); it != path.end(); it++)
+    {
+        cell_to_pixel(w, map.world2Cell(XYWorld(it->x, it->y)), px, py);
+        set_pixel(image, px, py, WAYPOINT_COLOR);
+    }
+
+    //goal
+    if (goal)
+    {
+        cell_to_pixel(w, map.world2Cell(XYWorld(goal->x, goal->y)), px, py);
+        draw_line(image, px - 2, py - 2, px + 2, py + 2, GOAL_COLOR);
+        draw_line(image, px - 2, py + 2, px + 2, py - 2, GOAL_COLOR);
+    }
+
+    //robot: a small disc and its heading (theta is in degrees, the rows of the image grow towards -y)
+    for (int dy = -2; dy <= 2; dy++)
+        for (int dx = -2; dx <= 2; dx++)
+        {
+            if (dx * dx + dy * dy <= 4) set_pixel(image, rx + dx, ry + dy, ROBOT_COLOR);
+        }
+    double t = robot.theta * M_PI / 180.0;
+    draw_line(image, rx, ry, rx + (int)lround(5 * cos(t)), ry - (int)lround(5 * sin(t)), ROBOT_COLOR);
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef MAP_IMAGE_PUBLISHER_H
+#define MAP_IMAGE_PUBLISHER_H
+
+#include <yarp/os/BufferedPort.h>
+#include <yarp/sig/Image.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/dev/Map2DLocation.h>
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include "mapChangeTracker.h"
+
+/**
+* Renders the state of the planner (map, laser obstacles, remaining path, robot pose and goal) in an image and publishes it.
+* A frame is rendered only if a reader is connected to the port, at most once per period, and only if something changed
+* since the previous frame. The map is rendered once in a cached background image, whose changed tiles only are redrawn
+* when the map is modified (see map_versioning::tile_change_tracker). The image can be cropped around the robot and downscaled.
+*/
+class MapImagePublisher
+{
+    yarp::os::BufferedPort<yarp::sig::ImageOf<yarp::sig::PixelRgb> >* m_port;
+    double                                  m_period;      //s, 0 disables the publisher
+    double                                  m_crop_size;   //m, the side of the robot-centred window, 0 means the whole map
+    size_t                                  m_downscale;   //each pixel represents downscale x downscale cells
+    double                                  m_last_publish_time;
+
+    //the map rendered at the output scale
+    yarp::sig::ImageOf<yarp::sig::PixelRgb> m_background;
+    std::string                             m_background_map_name;
+    uint64_t                                m_background_version;
+
+    //a digest of the content of the last published frame
+    uint64_t                                m_last_frame_key;
+    bool                                    m_last_frame_valid;
+    int                                     m_last_output_count;  //a new reader always receives a frame
+
+    public:
+    MapImagePublisher();
+
+    /**
+    * @param port the output port (not owned)
+    * @param frequency the maximum publishing rate (Hz). A value <= 0 disables the publisher.
+    * @param crop_size the side (m) of the window centred on the robot, 0 to publish the whole map
+    * @param downscale the reduction factor of the image (1 = one pixel per cell)
+    */
+    void configure(yarp::os::BufferedPort<yarp::sig::ImageOf<yarp::sig::PixelRgb> >* port, double frequency, double crop_size, size_t downscale);
+
+    /**
+    * Publishes a new frame, if required (see the class description).
+    * @param map the map, whose changes are tracked by map_changes
+    * @param map_changes the version of the map
+    * @param obstacle_cells the cells hit by the last laser scan
+    * @param robot the current position of the robot
+    * @param path the remaining waypoints
+    * @param goal the current goal, nullptr if the robot is not navigating
+    * @return true if a frame has been published
+    */
+    bool publish(const yarp::dev::Nav2D::MapGrid2D& map, const map_versioning::tile_change_tracker& map_changes,
+                 const std::vector<yarp::dev::Nav2D::XYCell>& obstacle_cells, const yarp::dev::Nav2D::Map2DLocation& robot,
+                 const std::deque<yarp::dev::Nav2D::Map2DLocation>& path, const yarp::dev::Nav2D::Map2DLocation* goal);
+
+    /**
+    * Renders a frame, regardless of the readers and of the period. The background is updated if needed.
+    * The parameters are the same of publish().
+    */
+    void render(const yarp::dev::Nav2D::MapGrid2D& map, const map_versioning::tile_change_tracker& map_changes,
+                const std::vector<yarp::dev::Nav2D::XYCell>& obstacle_cells, const yarp::dev::Nav2D::Map2DLocation& robot,
+                const std::deque<yarp::dev::Nav2D::Map2DLocation>& path, const yarp::dev::Nav2D::Map2DLocation* goal,
+                yarp::sig::ImageOf<yarp::sig::PixelRgb>& image);
+
+    private:
+    void update_background(const yarp::dev::Nav2D::MapGrid2D& map, const map_versioning::tile_change_tracker& map_changes);
+    void render_background_region(const yarp::dev::Nav2D::MapGrid2D& map, size_t x0, size_t y0, size_t x1, size_t y1);
+};
+
+#endif
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <algorithm>
+#include "multiResolution.h"
+#include "aStarIndexed.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+using namespace multiResolution_algorithm;
+
+YARP_LOG_COMPONENT(PATHPLAN_MULTIRES, "navigation.devices.robotPathPlanner.multiResolution")
+
+namespace
+{
+    //the workspaces of the coarse searches, one for each level, so that their memory is not reallocated when the level changes
+    search_workspace& coarse_workspace(size_t level)
+    {
+        static thread_local std::vector<std::unique_ptr<search_workspace> > workspaces;
+        if (workspaces.size() <= level) workspaces.resize(level + 1);
+        if (!workspaces[level]) workspaces[level].reset(new search_workspace);
+        return *workspaces[level];
+    }
+
+    //copies the cells x0..x1 (both included) of a row
+    void copy_row_range(const uint64_t* src, uint64_t* dst, size_t x0, size_t x1)
+    {
+        size_t x = x0;
+        while (x <= x1)
+        {
+            size_t word = x >> 6;
+            size_t last = std::min(x1, word * 64 + 63);
+            size_t count = last - x + 1;
+            uint64_t mask = (count >= 64) ? ~uint64_t(0) : (((uint64_t(1) << count) - 1) << (x & 63));
+            dst[word] |= src[word] & mask;
+            x = last + 1;
+        }
+    }
+
+    //builds a copy of the full resolution grid where only the cells inside the corridor around the coarse path are free
+    void build_corridor(const planning_grid& fine, size_t level, XYCell coarse_start, const std::deque<XYCell>& coarse_path, size_t corridor_radius, planning_grid& corridor)
+    {
+        size_t block = size_t(1) << level;
+        size_t cw = (fine.width() + block - 1) / block;
+        size_t ch = (fine.height() + block - 1) / block;
+        int r = (int)((corridor_radius + block - 1) / block);
+
+        //the coarse cells inside the corridor
+        std::vector<uint8_t> mask(cw * ch, 0);
+        auto mark = [&](const XYCell& c)
+        {
+            int x0 = std::max(0, (int)c.x - r);
+            int x1 = std::min((int)cw - 1, (int)c.x + r);
+            int y0 = std::max(0, (int)c.y - r);
+            int y1 = std::min((int)ch - 1, (int)c.y + r);
+            for (int y = y0; y <= y1; y++)
+                std::fill(mask.begin() + y * cw + x0, mask.begin() + y * cw + x1 + 1, 1);
+        };
+        mark(coarse_start);
+        for (auto it = coarse_path.begin(); it != coarse_path.end(); it++) mark(*it);
+
+        corridor.reset(fine.width(), fine.height());
+        for (size_t cy = 0; cy < ch; cy++)
+        {
+            size_t fy1 = std::min(fine.height(), (cy + 1) * block);
+            for (size_t cx = 0; cx < cw; cx++)
+            {
+                if (mask[cy * cw + cx] == 0) continue;
+                //the consecutive coarse cells of the corridor are copied together
+                size_t run_end = cx;
+                while (run_end + 1 < cw && mask[cy * cw + run_end + 1]) run_end++;
+                size_t fx0 = cx * block;
+                size_t fx1 = std::min(fine.width(), (run_end + 1) * block) - 1;
+                for (size_t fy = cy * block; fy < fy1; fy++)
+                {
+                    copy_row_range(fine.row(fy), corridor.row(fy), fx0, fx1);
+                }
+                cx = run_end;
+            }
+        }
+    }
+}
+
+void planning_pyramid::build(std::shared_ptr<const planning_grid> grid, size_t levels)
+{
+    m_full_resolution = grid;
+    m_levels.clear();
+    if (!grid) return;
+    m_levels.reserve(levels);
+    const planning_grid* finer = grid.get();
+    for (size_t k = 1; k <= levels; k++)
+    {
+        if (finer->width() < 4 || finer->height() < 4) break;
+        m_levels.push_back(planning_grid());
+        m_levels.back().build_coarser(*finer);
+        finer = &m_levels.back();
+    }
+}
+
+bool multiResolution_algorithm::find_multiresolution_path(const planning_pyramid& pyramid, XYCell start, XYCell goal, std::deque<XYCell>& path, search_workspace& ws, const std::vector<float>* cell_costs, size_t corridor_radius)
+{
+    const planning_grid& fine = pyramid.level(0);
+    if (start.x >= fine.width() || goal.x >= fine.width()) return false;
+    if (start.y >= fine.height() || goal.y >= fine.height()) return false;
+
+    size_t coarse_expanded_nodes = 0;
+    for (size_t k = pyramid.levels(); k >= 1; k--)
+    {
+        XYCell coarse_start(start.x >> k, start.y >> k);
+        XYCell coarse_goal(goal.x >> k, goal.y >> k);
+        search_workspace& cws = coarse_workspace(k);
+        cws.control = ws.control;
+
+        //the start cell is not required to be free, but the block containing the goal must be free at the coarse level
+        std::deque<XYCell> coarse_path;
+        bool found = aStarIndexed_algorithm::find_astar_path(pyramid.level(k), coarse_start, coarse_goal, coarse_path, cws, nullptr);
+        coarse_expanded_nodes += cws.stats.expanded_nodes;
+        if (ws.control && ws.control->should_stop()) return false;
+        if (found == false) continue;
+
+        planning_grid corridor;
+        build_corridor(fine, k, coarse_start, coarse_path, corridor_radius, corridor);
+        std::deque<XYCell> fine_path;
+        bool refined = aStarIndexed_algorithm::find_astar_path(corridor, start, goal, fine_path, ws, cell_costs);
+        ws.stats.expanded_nodes += coarse_expanded_nodes;
+        if (refined)
+        {
+            path.insert(path.end(), fine_path.begin(), fine_path.end());
+            return true;
+        }
+        yCDebug(PATHPLAN_MULTIRES) << "the refinement of the path found at level" << k << "failed, searching at full resolution";
+        coarse_expanded_nodes = ws.stats.expanded_nodes;
+        break;
+    }
+
+    //fallback: the whole grid at full resolution
+    bool found = aStarIndexed_algorithm::find_astar_path(fine, start, goal, path, ws, cell_costs);
+    ws.stats.expanded_nodes += coarse_expanded_nodes;
+    return found;
+}
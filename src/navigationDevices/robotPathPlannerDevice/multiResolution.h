@@ -0,0 +1,78 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef MULTI_RESOLUTION_H
+#define MULTI_RESOLUTION_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include "searchWorkspace.h"
+#include "planningGrid.h"
+
+//! namespace containing a coarse-to-fine grid search, performed on a pyramid of downsampled copies of the map
+namespace multiResolution_algorithm
+{
+    /**
+    * A pyramid of planning grids. Level 0 is the full resolution grid, each cell of level k covers 2^k x 2^k cells of level 0.
+    * A cell of a coarse level is free only if all the cells it covers are free (min-pooling), so a path found at a coarse level
+    * is always traversable at full resolution. Narrow passages may instead disappear at the coarse levels.
+    */
+    class planning_pyramid
+    {
+        std::shared_ptr<const planner_search::planning_grid> m_full_resolution;
+        std::vector<planner_search::planning_grid>           m_levels;
+
+        public:
+        /**
+        * Builds the coarse levels. The construction stops earlier if a level becomes smaller than 2x2 cells.
+        * @param grid the full resolution grid
+        * @param levels the number of coarse levels
+        */
+        void build(std::shared_ptr<const planner_search::planning_grid> grid, size_t levels);
+
+        //the number of coarse levels (level 0 excluded)
+        size_t levels() const { return m_levels.size(); }
+
+        //the grid of level k (0 <= k <= levels())
+        const planner_search::planning_grid& level(size_t k) const { return (k == 0) ? *m_full_resolution : m_levels[k - 1]; }
+
+        bool matches(const yarp::dev::Nav2D::MapGrid2D& map) const { return m_full_resolution && m_full_resolution->matches(map); }
+    };
+
+    /**
+    * This method computes (if exists) the path required to go from a start cell to a goal cell, with a coarse-to-fine search.
+    * The path is first searched at the coarsest level of the pyramid (moving to a finer level if the coarse search fails), then
+    * it is refined at full resolution, by an A* search restricted to a corridor around the coarse path.
+    * If the refinement fails, a full resolution A* search on the whole grid is performed.
+    * The returned path is not guaranteed to be optimal, but its cost is usually very close to the optimal one.
+    * @param pyramid the multi-resolution copy of the map
+    * @param start the start cell(x,y)
+    * @param goal the arrival cell(x,y)
+    * @param path the computed sequence of cells required to go from start cell to goal cell
+    * @param workspace the search memory used at full resolution. After the call, workspace.stats contains the statistics of all the searches.
+    * @param cell_costs the additional cost of each cell (row-major, w*h elements), or nullptr. It is used only at full resolution.
+    * @param corridor_radius the half width of the corridor (cells of level 0)
+    * @return true if the path exists, false if no valid path has been found
+    */
+    bool find_multiresolution_path(const planning_pyramid& pyramid, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& path, planner_search::search_workspace& workspace, const std::vector<float>* cell_costs, size_t corridor_radius);
+};
+
+#endif
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <limits>
+#include "navigationFunction.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+using namespace navigationFunction_algorithm;
+
+YARP_LOG_COMPONENT(PATHPLAN_NAVIGATION_FUNCTION, "navigation.devices.robotPathPlanner.navigationFunction")
+
+namespace
+{
+    //the eight moves of a 8-connected grid, with their associated costs
+    const int    neighbor_dx[8]   = { 0,  0, 1, -1,  1,  1, -1, -1 };
+    const int    neighbor_dy[8]   = { 1, -1, 0,  0,  1, -1,  1, -1 };
+    const float  neighbor_cost[8] = { 10, 10, 10, 10, 14, 14, 14, 14 };
+}
+
+/////////// cost_to_go_field
+cost_to_go_field::cost_to_go_field()
+{
+    width = 0;
+    height = 0;
+    inflation_radius = 0;
+}
+
+bool cost_to_go_field::compute(const MapGrid2D& map, XYCell goal_cell, double radius, std::shared_ptr<const std::vector<float> > costs, search_workspace& ws)
+{
+    size_t w = map.width();
+    size_t h = map.height();
+    if (costs && costs->size() != w * h)
+    {
+        yCError(PATHPLAN_NAVIGATION_FUNCTION) << "the size of the cell costs does not match the size of the map";
+        return false;
+    }
+    if (goal_cell.x >= w || goal_cell.y >= h) return false;
+    if (map.isFree(goal_cell) == false) return false;
+
+    map_name = map.getMapName();
+    width = w;
+    height = h;
+    goal = goal_cell;
+    inflation_radius = radius;
+    cell_costs = costs;
+
+    //Dijkstra search from the goal. A move from a to b costs the move cost plus the cost of a (as in A*),
+    //so the cost of the reversed move b->a, explored here, includes the cost of its destination.
+    ws.prepare(w, h);
+    cell_index_type goal_index = ws.to_index(goal_cell);
+    ws.set_node(goal_index, 0, INVALID_CELL_INDEX);
+    ws.open_set.push(goal_index, 0);
+    while (!ws.open_set.empty())
+    {
+        cell_index_type curr = ws.open_set.pop();
+        ws.set_closed(curr);
+        ws.stats.expanded_nodes++;
+        if (ws.must_stop())
+        {
+            yCDebug(PATHPLAN_NAVIGATION_FUNCTION) << "search interrupted after" << ws.stats.expanded_nodes << "expansions";
+            return false;
+        }
+
+        int cx = (int)(curr % w);
+        int cy = (int)(curr / w);
+        double curr_g = ws.g_score(curr);
+        for (size_t i = 0; i < 8; i++)
+        {
+            int nx = cx + neighbor_dx[i];
+            int ny = cy + neighbor_dy[i];
+            if (nx < 0 || ny < 0 || nx >= (int)w || ny >= (int)h) continue;
+
+            cell_index_type neighbor = ws.to_index(nx, ny);
+            if (ws.is_closed(neighbor)) continue;
+            if (map.isFree(XYCell(nx, ny)) == false) continue;
+
+            double tentative_g_score = curr_g + neighbor_cost[i];
+            if (costs) tentative_g_score += (*costs)[neighbor];
+            if (tentative_g_score < ws.g_score(neighbor))
+            {
+                ws.set_node(neighbor, tentative_g_score, curr);
+                if (ws.open_set.contains(neighbor)) ws.open_set.decrease_key(neighbor, tentative_g_score);
+                else                                ws.open_set.push(neighbor, tentative_g_score);
+            }
+        }
+    }
+
+    cost.resize(w * h);
+    for (size_t i = 0; i < w * h; i++)
+    {
+        cost[i] = (float)ws.g_score((cell_index_type)i);
+    }
+    yCDebug(PATHPLAN_NAVIGATION_FUNCTION) << "navigation function of map" << map_name << "computed," << ws.stats.expanded_nodes << "reachable cells";
+    return true;
+}
+
+bool cost_to_go_field::extract_path(const MapGrid2D& map, XYCell start, std::deque<XYCell>& path) const
+{
+    if (start.x >= width || start.y >= height) return false;
+    if (map.width() != width || map.height() != height) return false;
+
+    //steepest descent: the cost of the next cell, plus the cost of the move, is minimum.
+    //The start cell may be an occupied cell (e.g. the robot is inside an enlarged obstacle), so its own cost is not used.
+    int x = (int)start.x;
+    int y = (int)start.y;
+    int gx = (int)goal.x;
+    int gy = (int)goal.y;
+    float curr_cost = std::numeric_limits<float>::infinity();
+    std::deque<XYCell> cells;
+    while (x != gx || y != gy)
+    {
+        int best_x = -1;
+        int best_y = -1;
+        float best_cost = std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < 8; i++)
+        {
+            int nx = x + neighbor_dx[i];
+            int ny = y + neighbor_dy[i];
+            if (nx < 0 || ny < 0 || nx >= (int)width || ny >= (int)height) continue;
+            float c = cost[ny * width + nx] + neighbor_cost[i];
+            if (c < best_cost) { best_cost = c; best_x = nx; best_y = ny; }
+        }
+        //the cost must strictly decrease at each step, otherwise the goal cannot be reached from the start cell
+        if (best_x < 0 || cost[best_y * width + best_x] >= curr_cost) return false;
+        XYCell next(best_x, best_y);
+        if (map.isFree(next) == false)
+        {
+            yCDebug(PATHPLAN_NAVIGATION_FUNCTION) << "the navigation function is outdated, cell" << best_x << best_y << "is not free";
+            return false;
+        }
+        cells.push_back(next);
+        x = best_x;
+        y = best_y;
+        curr_cost = cost[y * width + x];
+    }
+    path.insert(path.end(), cells.begin(), cells.end());
+    return true;
+}
+
+bool cost_to_go_field::matches(const MapGrid2D& map, XYCell goal_cell, double radius, const std::shared_ptr<const std::vector<float> >& costs) const
+{
+    return (map_name == map.getMapName() &&
+            width == map.width() &&
+            height == map.height() &&
+            goal.x == goal_cell.x &&
+            goal.y == goal_cell.y &&
+            inflation_radius == radius &&
+            cell_costs == costs);
+}
+
+/////////// navigation_function_cache
+navigation_function_cache::navigation_function_cache()
+{
+    m_max_memory = 0;
+    m_memory = 0;
+    m_generation = 0;
+}
+
+void navigation_function_cache::set_max_memory(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_max_memory = bytes;
+    while (m_memory > m_max_memory && !m_fields.empty())
+    {
+        m_memory -= m_fields.back()->memory_size();
+        m_fields.pop_back();
+    }
+}
+
+std::shared_ptr<const cost_to_go_field> navigation_function_cache::get(const MapGrid2D& map, XYCell goal, double inflation_radius, std::shared_ptr<const std::vector<float> > cell_costs, search_workspace& workspace)
+{
+    size_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto it = m_fields.begin(); it != m_fields.end(); it++)
+        {
+            if ((*it)->matches(map, goal, inflation_radius, cell_costs))
+            {
+                //moves the field to the front of the list
+                std::shared_ptr<const cost_to_go_field> field = *it;
+                m_fields.erase(it);
+                m_fields.push_front(field);
+                return field;
+            }
+        }
+        generation = m_generation;
+    }
+
+    //the field is computed without holding the lock, so that clear() never waits for a search
+    std::shared_ptr<cost_to_go_field> field = std::make_shared<cost_to_go_field>();
+    if (field->compute(map, goal, inflation_radius, cell_costs, workspace) == false) return nullptr;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (generation != m_generation || field->memory_size() > m_max_memory)
+    {
+        //the cache has been cleared in the meantime (the field may be outdated), or the field is too big: it is used only once
+        return field;
+    }
+    m_fields.push_front(field);
+    m_memory += field->memory_size();
+    while (m_memory > m_max_memory)
+    {
+        m_memory -= m_fields.back()->memory_size();
+        m_fields.pop_back();
+    }
+    return field;
+}
+
+void navigation_function_cache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_fields.clear();
+    m_memory = 0;
+    m_generation++;
+}
+
+size_t navigation_function_cache::size()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fields.size();
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef NAVIGATION_FUNCTION_H
+#define NAVIGATION_FUNCTION_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <vector>
+#include <deque>
+#include <list>
+#include <string>
+#include <memory>
+#include <mutex>
+#include "searchWorkspace.h"
+
+//! namespace containing the navigation functions (cost-to-go fields rooted at a goal) and their cache
+namespace navigationFunction_algorithm
+{
+    /**
+    * The cost required to reach a given goal cell from every cell of the map, computed with a Dijkstra search rooted at the goal.
+    * The costs are the same of aStarIndexed_algorithm::find_astar_path() (10 for straight moves, 14 for diagonal moves, plus the optional cell costs),
+    * so the path extracted from the field has the same cost of the path computed by A*.
+    */
+    class cost_to_go_field
+    {
+        public:
+        std::string                                 map_name;
+        size_t                                      width;
+        size_t                                      height;
+        yarp::dev::Nav2D::XYCell                    goal;
+        double                                      inflation_radius;
+        std::shared_ptr<const std::vector<float> >  cell_costs;
+        std::vector<float>                          cost;   //row-major, infinity if the goal cannot be reached from the cell
+
+        cost_to_go_field();
+
+        /**
+        * Computes the field. The field stores the given key (map name, goal, inflation radius, cell costs).
+        * @param map the gridmap containing the obstacles
+        * @param goal the cell where the field is rooted
+        * @param inflation_radius the radius (m) used to enlarge the obstacles of the map (used only as a key)
+        * @param cell_costs the additional cost of each cell (row-major, w*h elements), or nullptr
+        * @param workspace the search memory. The search can be interrupted through workspace.control.
+        * @return false if the goal is not a free cell or if the search has been interrupted
+        */
+        bool compute(const yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell goal, double inflation_radius, std::shared_ptr<const std::vector<float> > cell_costs, planner_search::search_workspace& workspace);
+
+        /**
+        * Extracts the path from a start cell to the goal following the steepest descent of the field, in O(path length).
+        * @param map the gridmap containing the obstacles. The path is rejected if it traverses a cell which is no longer free.
+        * @param start the start cell(x,y)
+        * @param path the computed sequence of cells required to go from start cell to goal cell (start excluded, goal included)
+        * @return true if the path exists, false if the goal cannot be reached from the start cell
+        */
+        bool extract_path(const yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, std::deque<yarp::dev::Nav2D::XYCell>& path) const;
+
+        bool matches(const yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell goal, double inflation_radius, const std::shared_ptr<const std::vector<float> >& cell_costs) const;
+
+        size_t memory_size() const { return cost.size() * sizeof(float); }
+    };
+
+    /**
+    * A least-recently-used cache of the cost-to-go fields rooted at the most recent goals, keyed by map name, goal cell,
+    * inflation radius and cell costs. The memory used by the fields is bounded: the least recently used fields are discarded first.
+    * The methods can be called from different threads.
+    */
+    class navigation_function_cache
+    {
+        std::list<std::shared_ptr<const cost_to_go_field> > m_fields;  //the most recently used first
+        size_t                                             m_max_memory;
+        size_t                                             m_memory;
+        size_t                                             m_generation;
+        std::mutex                                         m_mutex;
+
+        public:
+        navigation_function_cache();
+
+        /**
+        * Sets the maximum amount of memory used by the cached fields. 0 disables the cache.
+        * @param bytes the memory limit (bytes)
+        */
+        void   set_max_memory(size_t bytes);
+        bool   enabled() const { return m_max_memory > 0; }
+
+        /**
+        * Returns the field rooted at the given goal, computing it if it is not cached.
+        * @return the field, or nullptr if the field cannot be computed (see cost_to_go_field::compute())
+        */
+        std::shared_ptr<const cost_to_go_field> get(const yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell goal, double inflation_radius, std::shared_ptr<const std::vector<float> > cell_costs, planner_search::search_workspace& workspace);
+
+        /**
+        * Discards all the cached fields, e.g. because the map has been reloaded.
+        * A field whose computation is in progress is not inserted in the cache.
+        */
+        void   clear();
+        size_t size();
+    };
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/dev/MapGrid2D.h>
+#include <algorithm>
+#include <math.h>
+#include <stdlib.h>
+#include "pathMonitor.h"
+
+using namespace std;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace path_monitoring;
+
+path_validity_monitor::path_validity_monitor()
+{
+    m_footprint_cells = -1;
+    m_width = 0;
+    m_height = 0;
+    m_segments = 0;
+    m_first_segment = 0;
+}
+
+void path_validity_monitor::clear()
+{
+    for (auto it = m_swept_cells.begin(); it != m_swept_cells.end(); it++)
+    {
+        m_segment[it->y * m_width + it->x] = NO_SEGMENT;
+    }
+    m_swept_cells.clear();
+    m_segments = 0;
+    m_first_segment = 0;
+}
+
+void path_validity_monitor::advance()
+{
+    if (m_first_segment < m_segments) m_first_segment++;
+}
+
+uint32_t path_validity_monitor::blocked_segment(const XYCell& cell) const
+{
+    if (cell.x >= m_width || cell.y >= m_height) return NO_SEGMENT;
+    uint32_t s = m_segment[cell.y * m_width + cell.x];
+    if (s == NO_SEGMENT || s < m_first_segment) return NO_SEGMENT;
+    return static_cast<uint32_t>(s - m_first_segment);
+}
+
+void path_validity_monitor::set_path(const MapGrid2D& map, const Map2DLocation& robot, const std::deque<Map2DLocation>& remaining_path, double robot_radius)
+{
+    if (map.width() != m_width || map.height() != m_height)
+    {
+        m_width = map.width();
+        m_height = map.height();
+        m_segment.assign(m_width * m_height, NO_SEGMENT);
+        m_swept_cells.clear();
+    }
+    clear();
+
+    //the footprint is a disc of cells, the same used by obstacle_layers::rolling_window_layer to enlarge the laser cells
+    double resolution = 0;
+    map.getResolution(resolution);
+    int footprint_cells = (resolution > 0 && robot_radius > 0) ? (int)ceil(robot_radius / resolution) : 0;
+    if (footprint_cells != m_footprint_cells)
+    {
+        m_footprint_cells = footprint_cells;
+        m_footprint_offsets.clear();
+        for (int dy = -footprint_cells; dy <= footprint_cells; dy++)
+            for (int dx = -footprint_cells; dx <= footprint_cells; dx++)
+            {
+                if (dx * dx + dy * dy <= footprint_cells * footprint_cells)
+                {
+                    m_footprint_offsets.push_back(std::make_pair(dx, dy));
+                }
+            }
+    }
+
+    XYCell prev = map.toXYCell(robot);
+    for (size_t i = 0; i < remaining_path.size(); i++)
+    {
+        XYCell next = map.toXYCell(remaining_path[i]);
+        uint32_t segment = static_cast<uint32_t>(i);
+
+        //Bresenham's line from prev to next, each cell of the line is enlarged by the footprint.
+        //The segments are swept in order, so each cell ends up storing the last segment which covers it.
+        int x0 = (int)prev.x;
+        int y0 = (int)prev.y;
+        int x1 = (int)next.x;
+        int y1 = (int)next.y;
+        int dx = abs(x1 - x0);
+        int dy = -abs(y1 - y0);
+        int sx = (x0 < x1) ? 1 : -1;
+        int sy = (y0 < y1) ? 1 : -1;
+        int err = dx + dy;
+        while (true)
+        {
+            for (auto o = m_footprint_offsets.begin(); o != m_footprint_offsets.end(); o++)
+            {
+                int x = x0 + o->first;
+                int y = y0 + o->second;
+                if (x < 0 || y < 0 || x >= (int)m_width || y >= (int)m_height) continue;
+                uint32_t& s = m_segment[y * m_width + x];
+                if (s == segment) continue;
+                if (s == NO_SEGMENT) m_swept_cells.push_back(XYCell(x, y));
+                s = segment;
+            }
+            if (x0 == x1 && y0 == y1) break;
+            int e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x0 += sx; }
+            if (e2 <= dx) { err += dx; y0 += sy; }
+        }
+        prev = next;
+    }
+    m_segments = remaining_path.size();
+    m_first_segment = 0;
+}
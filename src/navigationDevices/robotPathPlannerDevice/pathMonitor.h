@@ -0,0 +1,89 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef PATH_MONITOR_H
+#define PATH_MONITOR_H
+
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/dev/Map2DLocation.h>
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+
+//! namespace containing the checks performed on the path while the robot is following it
+namespace path_monitoring
+{
+    const uint32_t NO_SEGMENT = 0xFFFFFFFF;
+
+    /**
+    * An index of the cells swept by the robot along the remaining part of a path. The path is a polyline, made of segments:
+    * segment 0 goes from the robot position to the first waypoint, segment i from waypoint i-1 to waypoint i.
+    * Every cell within the robot radius from a segment stores the index of the last segment which covers it, so that
+    * checking a newly occupied cell costs O(1) and the segments already travelled can be skipped without rebuilding the index.
+    * The index is built once per path, with a cost proportional to the length of the path times the area of the robot footprint.
+    */
+    class path_validity_monitor
+    {
+        std::vector<uint32_t>                 m_segment;        //w*h elements, NO_SEGMENT for the cells which are not swept
+        std::vector<yarp::dev::Nav2D::XYCell> m_swept_cells;
+        std::vector<std::pair<int, int> >     m_footprint_offsets;
+        int                                   m_footprint_cells;
+        size_t                                m_width;
+        size_t                                m_height;
+        size_t                                m_segments;
+        size_t                                m_first_segment;
+
+        public:
+        path_validity_monitor();
+
+        /**
+        * Builds the index for a new path.
+        * @param map the map to which the path refers (only its size and resolution are used)
+        * @param robot the current position of the robot
+        * @param remaining_path the waypoints still to be reached
+        * @param robot_radius the radius (m) used to sweep the segments of the path
+        */
+        void set_path(const yarp::dev::Nav2D::MapGrid2D& map, const yarp::dev::Nav2D::Map2DLocation& robot, const std::deque<yarp::dev::Nav2D::Map2DLocation>& remaining_path, double robot_radius);
+
+        /**
+        * Removes the path. The cost is proportional to the number of swept cells.
+        */
+        void clear();
+
+        /**
+        * Marks the first not yet travelled segment as travelled. To be called each time a waypoint is reached.
+        */
+        void advance();
+
+        bool empty() const { return m_first_segment >= m_segments; }
+
+        //the cells covered by the remaining part of the path (and by the travelled segments, until the next call to set_path())
+        const std::vector<yarp::dev::Nav2D::XYCell>& swept_cells() const { return m_swept_cells; }
+
+        /**
+        * Checks if an occupied cell blocks the remaining part of the path.
+        * @return the index of the last segment which is blocked by the cell, relative to the next waypoint (0 = the segment
+        * which leads to the next waypoint), or NO_SEGMENT if the cell does not block the path.
+        */
+        uint32_t blocked_segment(const yarp::dev::Nav2D::XYCell& cell) const;
+    };
+};
+
+#endif
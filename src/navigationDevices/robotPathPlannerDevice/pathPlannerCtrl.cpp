@@ -30,14 +30,14 @@
 #include <yarp/dev/IRangefinder2D.h>
 #include <yarp/dev/INavigation2D.h>
 #include <string>
+#include <algorithm>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
 
-#include <opencv2/imgproc/imgproc_c.h>
-
 #include "pathPlannerCtrl.h"
 #include "pathPlannerCtrlHelpers.h"
+#include "aStarIndexed.h"
 
 using namespace std;
 using namespace yarp::os;
@@ -74,7 +74,7 @@ bool  PlannerThread::readLocalizationData()
         m_force_map_reload = false;
         yCWarning(PATHPLAN_CTRL) << "Current map name ("<<m_current_map.getMapName()<<") != m_localization_data.map_id ("<< m_localization_data.map_id <<")";
         yCInfo(PATHPLAN_CTRL) << "Asking the map '"<< m_localization_data.map_id << "' to the MAP server";
-        bool b = reloadCurrentMap();
+        bool b = reloadCurrentMap(true);
     
         yarp::os::Time::delay(1.0);
         if (b){return true;}
@@ -150,51 +150,39 @@ void  PlannerThread::readLaserData()
         m_laser_timeout_counter++;
     }
 
-    //transform the laser measurement in a temporary map
-    //the purpose of the following copy of m_temporary_obstacles_map in temp_map is to minimize the duration of the critical section
-    //protected by the mutex. Indeed enlargeObstacles() can take some time and should be outside the mutex.
+    //transform the laser measurement in a temporary map.
+    //The layer is computed outside the critical section protected by the mutex, then only the cells which changed
+    //since the previous scan are written into m_temporary_obstacles_map.
+    m_laser_layer.prepare(m_current_map, m_laser_map_cells, m_robot_radius);
     m_temporary_obstacles_map_mutex.lock();
-    MapGrid2D temp_map = m_temporary_obstacles_map;
-    m_temporary_obstacles_map_mutex.unlock();
-    //here I am cleaning temp map from everything.
-    for (size_t y=0; y< temp_map.height(); y++)
-       for (size_t x=0; x< temp_map.width(); x++)
-            temp_map.setMapFlag(XYCell(x,y),MapGrid2D::MAP_CELL_FREE);
-    //Fill the temp map with laser scans
-    for (size_t i=0; i< m_laser_map_cells.size(); i++)
+    m_laser_layer.apply(m_temporary_obstacles_map, m_laser_changed_cells);
+    m_local_map_changes.mark_cells(m_laser_changed_cells);
+    //m_temporary_obstacles_map is now filled only with MAP_CELL_FREE,MAP_CELL_TEMPORARY_OBSTACLE and MAP_CELL_ENLARGED_OBSTACLE
+    //the cells which changed since the previous scan are recorded for the incremental planner, which collects them at its next search.
+    //If no search collects them for a long time, the planner is reinitialized instead of repairing an unbounded list of cells.
+    if (m_planner_algorithm == map_utilites::PLANNER_DSTAR_LITE && m_incremental_planner_reset == false)
     {
-        temp_map.setMapFlag(m_laser_map_cells[i],MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE);
+        m_incremental_changed_cells.insert(m_incremental_changed_cells.end(), m_laser_changed_cells.begin(), m_laser_changed_cells.end());
+        if (m_incremental_changed_cells.size() > m_temporary_obstacles_map.width() * m_temporary_obstacles_map.height())
+        {
+            m_incremental_changed_cells.clear();
+            m_incremental_planner_reset = true;
+        }
     }
-    //enlarge the laser scans
-    temp_map.enlargeObstacles(m_robot_radius);
-    //m_temporary_obstacles_map is now filled only with MAP_CELL_FREE,MAP_CELL_TEMPORARY_OBSTACLE and MAP_CELL_ENLARGED_OBSTACLE
-    m_temporary_obstacles_map_mutex.lock();
-    m_temporary_obstacles_map = temp_map;
     m_temporary_obstacles_map_mutex.unlock();
-}
 
-bool prepare_image(IplImage* & image_to_be_prepared, const IplImage* template_image)
-{
-    if (template_image == 0)
+    //only the cells which became occupied since the previous scan are checked against the path being followed
+    if (m_enable_path_monitoring && m_planner_status == navigation_status_moving && m_path_monitor.empty() == false)
     {
-        yCError(PATHPLAN_CTRL) << "PlannerThread::draw_map cannot copy an empty image!";
-        return false;
-    }
-    if (image_to_be_prepared == 0) 
-    {
-        image_to_be_prepared = cvCloneImage(template_image);
-    }
-    else if (image_to_be_prepared->width != template_image->width ||
-             image_to_be_prepared->height != template_image->height)
-    {
-        cvResize(template_image, image_to_be_prepared);
-        cvCopy(template_image, image_to_be_prepared);
-    }
-    else
-    {
-        cvCopy(template_image, image_to_be_prepared);
+        for (auto it = m_laser_changed_cells.begin(); it != m_laser_changed_cells.end(); it++)
+        {
+            if (m_laser_layer.flag_at(*it) != MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE) continue;
+            m_path_blocked_segment = std::min(m_path_blocked_segment, m_path_monitor.blocked_segment(*it));
+        }
     }
-    return true;
+
+    //the master grid of the costmap (the static map plus the temporary obstacles) is recomposed inside the windows of the previous and of the current scan only
+    m_costmap.update();
 }
 
 void PlannerThread::run()
@@ -244,12 +232,22 @@ void PlannerThread::run()
     {
         case navigation_status_moving:
         {
+            //the anytime planner may still be improving the path being followed
+            checkPlanningResult();
+
+            if (m_path_blocked_segment != path_monitoring::NO_SEGMENT)
+            {
+                repairBlockedPath();
+                break;
+            }
+
             if (m_inner_status == navigation_status_goal_reached)
             {
                 if (m_current_path_iterator == m_current_path->end())
                 {
                     //navigation is complete
                     yCInfo(PATHPLAN_CTRL, "goal reached, navigation complete");
+                    m_planning_worker.cancel();
                     m_planner_status = navigation_status_goal_reached;
                     m_final_goal_reached_at_timeX = yarp::os::Time::now();
                 }
@@ -259,66 +257,11 @@ void PlannerThread::run()
                     //remove the current waypoint, just reached
                     m_current_path_iterator++;
                     m_remaining_path.pop_front();
+                    m_path_monitor.advance();
 
                     //send the final waypoint
                     yCInfo(PATHPLAN_CTRL, "sending the last waypoint (final goal)");
-                    {
-                        //send the tolerance to the inner controller
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("linear_tol");
-                        cmd.addDouble(m_goal_tolerance_lin);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd2, ans2;
-                        cmd2.addString("set");
-                        cmd2.addString("angular_tol");
-                        cmd2.addDouble(m_goal_tolerance_ang);
-                        m_port_commands_output.write(cmd2, ans2);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("min_lin_speed");
-                        cmd.addDouble(m_goal_min_lin_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("max_lin_speed");
-                        cmd.addDouble(m_goal_max_lin_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("min_ang_speed");
-                        cmd.addDouble(m_goal_min_ang_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("max_ang_speed");
-                        cmd.addDouble(m_goal_max_ang_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("ang_speed_gain");
-                        cmd.addDouble(m_goal_ang_gain);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("lin_speed_gain");
-                        cmd.addDouble(m_goal_lin_gain);
-                        m_port_commands_output.write(cmd, ans);
-                    }
+                    useControllerProfile(m_goal_profile);
                     sendFinalGoal();
                 }
                 else
@@ -327,51 +270,11 @@ void PlannerThread::run()
                     //remove the current waypoint, just reached
                     m_current_path_iterator++;
                     m_remaining_path.pop_front();
+                    m_path_monitor.advance();
 
                     //send the next waypoint
                     yCInfo(PATHPLAN_CTRL, "sending the next waypoint");
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("min_lin_speed");
-                        cmd.addDouble(m_waypoint_min_lin_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("max_lin_speed");
-                        cmd.addDouble(m_waypoint_max_lin_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("min_ang_speed");
-                        cmd.addDouble(m_waypoint_min_ang_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("max_ang_speed");
-                        cmd.addDouble(m_waypoint_max_ang_speed);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("ang_speed_gain");
-                        cmd.addDouble(m_waypoint_ang_gain);
-                        m_port_commands_output.write(cmd, ans);
-                    }
-                    {
-                        Bottle cmd, ans;
-                        cmd.addString("set");
-                        cmd.addString("lin_speed_gain");
-                        cmd.addDouble(m_waypoint_lin_gain);
-                        m_port_commands_output.write(cmd, ans);
-                    }
+                    useControllerProfile(m_waypoint_profile);
                     sendWaypoint();
                 }
             }
@@ -403,15 +306,18 @@ void PlannerThread::run()
                         m_port_commands_output.write(cmd, ans);
 
                         //update the map with the new obstacles
-                        map_utilites::update_obstacles_map(m_current_map, m_temporary_obstacles_map);
-                        //the following enlargement is done in order to take away the robot from the obstacles where it is stuck
+                        addTemporaryObstaclesToMap();
+                        //the following enlargement is done in order to take away the robot from the obstacles where it is stuck.
+                        //The enlarged cells are not tracked one by one, so the incremental planner is reinitialized.
+                        m_temporary_obstacles_map_mutex.lock();
                         m_temporary_obstacles_map.enlargeObstacles(0.1);
-                        //search for a new path
-                        if (!recomputePath())
-                        {
-                            yCInfo(PATHPLAN_CTRL, "Unable to recompute the path, aborting navigation");
-                            abortNavigation();
-                        }
+                        m_local_map_changes.reset(m_temporary_obstacles_map.width(), m_temporary_obstacles_map.height());
+                        m_laser_layer.invalidate();
+                        m_incremental_changed_cells.clear();
+                        m_incremental_planner_reset = true;
+                        m_temporary_obstacles_map_mutex.unlock();
+                        //search for a new path. The navigation is aborted if the search cannot be started
+                        recomputePath();
                     }
                     else
                     {
@@ -444,63 +350,8 @@ void PlannerThread::run()
                 m_current_path_iterator = m_current_path->begin();
                 yCInfo(PATHPLAN_CTRL, "sending the first waypoint");
 
-                //send the tolerance to the inner controller
-                {
-                    Bottle cmd1, ans1;
-                    cmd1.addString("set");
-                    cmd1.addString("linear_tol");
-                    cmd1.addDouble(m_waypoint_tolerance_lin);
-                    m_port_commands_output.write(cmd1, ans1);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("angular_tol");
-                    cmd.addDouble(m_waypoint_tolerance_ang);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("max_lin_speed");
-                    cmd.addDouble(m_waypoint_max_lin_speed);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("max_ang_speed");
-                    cmd.addDouble(m_waypoint_max_ang_speed);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("min_lin_speed");
-                    cmd.addDouble(m_waypoint_min_lin_speed);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("min_ang_speed");
-                    cmd.addDouble(m_waypoint_min_ang_speed);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("ang_speed_gain");
-                    cmd.addDouble(m_waypoint_ang_gain);
-                    m_port_commands_output.write(cmd, ans);
-                }
-                {
-                    Bottle cmd, ans;
-                    cmd.addString("set");
-                    cmd.addString("lin_speed_gain");
-                    cmd.addDouble(m_waypoint_lin_gain);
-                    m_port_commands_output.write(cmd, ans);
-                }
+                //send the tolerances, the speed limits and the gains to the inner controller
+                useControllerProfile(m_waypoint_profile);
                 sendWaypoint();
             }
             else
@@ -537,7 +388,8 @@ void PlannerThread::run()
         break;
         case  navigation_status_thinking:
         {
-            //do nothing, just wait
+            //the path is computed by the planning worker, just wait for the result
+            checkPlanningResult();
         }
         break;
         case  navigation_status_paused:
@@ -582,7 +434,12 @@ void PlannerThread::run()
         b.addString(s.c_str());
         m_port_status_output.write();
     }
-    
+
+    //the map image is rendered only if it has readers and its content changed
+    bool navigating = (m_planner_status != navigation_status_idle && m_planner_status != navigation_status_goal_reached && m_sequence_of_goals.empty() == false);
+    m_map_image_publisher.publish(m_current_map, m_global_map_changes, m_laser_map_cells, m_localization_data, m_remaining_path, navigating ? &m_sequence_of_goals.front() : nullptr);
+
+    publishSnapshot();
     m_mutex.post();
 }
 
@@ -617,19 +474,62 @@ bool PlannerThread::getCurrentMap(MapGrid2D& map) const
     return true;
 }
 
-bool PlannerThread::reloadCurrentMap()
+bool PlannerThread::reloadCurrentMap(bool force)
 {
-    yCDebug(PATHPLAN_CTRL, "Reloading map %f from server", m_current_map);
-    bool map_get_succesfull = this->m_iMap->get_map(m_localization_data.map_id, m_current_map);
+    yCDebug(PATHPLAN_CTRL, "Reloading map %s from server", m_localization_data.map_id.c_str());
+    MapGrid2D server_map;
+    bool map_get_succesfull = this->m_iMap->get_map(m_localization_data.map_id, server_map);
     if (map_get_succesfull)
     {
+        //the map is reloaded at each new goal, usually without changes: in this case the planning structures (and the roadmap,
+        //which requires the locations from the server) are still valid
+        uint64_t server_map_hash = map_utilites::computeMapHash(server_map);
+        if (force == false && m_force_map_reload == false &&
+            server_map.getMapName() == m_current_map.getMapName() && server_map_hash == m_server_map_hash)
+        {
+            yCDebug(PATHPLAN_CTRL) << "Map '" << m_localization_data.map_id << "' not changed since the last reload";
+            return true;
+        }
+        m_current_map = server_map;
+        m_server_map_hash = server_map_hash;
         m_temporary_obstacles_map_mutex.lock();
         m_temporary_obstacles_map = m_current_map;
+        m_local_map_changes.reset(m_temporary_obstacles_map.width(), m_temporary_obstacles_map.height());
+        m_laser_layer.invalidate();
+        m_incremental_changed_cells.clear();
+        m_incremental_planner_reset = true;
         m_temporary_obstacles_map_mutex.unlock();
         yCInfo(PATHPLAN_CTRL) << "Map '" << m_localization_data.map_id << "' successfully obtained from server";
-        m_current_map.enlargeObstacles(m_robot_radius);
-        m_augmented_map = m_current_map;
+        //the clearance field is recomputed only if the obstacles of the map changed, then the enlargement is a threshold test
+        m_clearance_map.update(m_current_map);
+        m_static_layer.set_map(m_current_map);
+        m_inflation_layer.set_field(&m_clearance_map, m_current_map, m_robot_radius);
+        updateKeepOutAreas();
+        m_costmap.reset(m_current_map);
+        m_costmap.update();
+        //the planning map contains the static layers only: the laser obstacles are added to it on recovery (see addTemporaryObstaclesToMap())
+        m_costmap.compose(m_current_map, m_costmap.full_bounds(), PLANNING_LAYERS, nullptr);
+        m_global_map_changes.reset(m_current_map.width(), m_current_map.height());
+        m_clearance_cost = m_clearance_map.cost_layer(m_clearance_cost_distance, m_clearance_cost_weight);
+        //the cached fields are discarded only if the planning map changed (e.g. the map is forced to reload with the same content)
+        uint64_t map_hash = hpaStar_algorithm::compute_map_hash(m_current_map);
+        if (map_hash != m_navigation_function_map_hash)
+        {
+            m_navigation_function_cache.clear();
+            m_navigation_function_map_hash = map_hash;
+        }
+        rebuildPlanningGrid();
         yCDebug(PATHPLAN_CTRL, ) << "Obstacles enlargement performed (" << m_robot_radius << "m)";
+        if (m_planner_algorithm == map_utilites::PLANNER_HPA_STAR)
+        {
+            //the abstract graph is rebuilt only if the content of the map changed since the last time it was loaded
+            m_hpa_graph = m_hpa_cache.get(m_current_map, m_hpa_cluster_size);
+        }
+        if (m_enable_roadmap)
+        {
+            updateRoadmap();
+        }
+        return true;
     }
     else
     {
@@ -678,6 +578,62 @@ bool PlannerThread::getOstaclesMap(MapGrid2D& obstacles_map)
     return true;
 }
 
+bool PlannerThread::uploadControllerProfiles()
+{
+    for (auto it = m_controller_profiles.begin(); it != m_controller_profiles.end(); it++)
+    {
+        Bottle cmd, ans;
+        cmd.addString("set_profile");
+        cmd.addString(it->first);
+        cmd.append(it->second);
+        if (m_port_commands_output.write(cmd, ans) == false)
+        {
+            yCWarning(PATHPLAN_CTRL) << "Unable to upload the controller profiles";
+            return false;
+        }
+        if (ans.get(0).asString() != "ok")
+        {
+            //the inner navigator does not support the profiles (or it rejected one of them)
+            yCWarning(PATHPLAN_CTRL) << "Profile" << it->first << "rejected by the inner navigator (" << ans.toString() << "), the controller parameters will be sent one by one";
+            m_use_controller_profiles = false;
+            return false;
+        }
+    }
+    yCInfo(PATHPLAN_CTRL) << m_controller_profiles.size() << "controller profiles uploaded to the inner navigator";
+    return true;
+}
+
+void PlannerThread::useControllerProfile(const std::string& name)
+{
+    if (m_use_controller_profiles)
+    {
+        if (m_controller_profiles_uploaded == false) m_controller_profiles_uploaded = uploadControllerProfiles();
+        if (m_controller_profiles_uploaded)
+        {
+            Bottle cmd, ans;
+            cmd.addString("use_profile");
+            cmd.addString(name);
+            m_port_commands_output.write(cmd, ans);
+            if (ans.get(0).asString() == "ok") return;
+            //the inner navigator may have been restarted, losing the profiles: they will be uploaded again at the next transition
+            yCWarning(PATHPLAN_CTRL) << "Unable to use controller profile" << name << ":" << ans.toString();
+            m_controller_profiles_uploaded = false;
+        }
+    }
+
+    //fallback: one 'set' command for each parameter
+    const Bottle& profile = m_controller_profiles[name];
+    for (size_t i = 0; i < profile.size(); i++)
+    {
+        Bottle* param = profile.get(i).asList();
+        if (param == nullptr) continue;
+        Bottle cmd, ans;
+        cmd.addString("set");
+        cmd.append(*param);
+        m_port_commands_output.write(cmd, ans);
+    }
+}
+
 void PlannerThread::sendWaypoint()
 {
     size_t path_size = m_current_path->size();
@@ -732,7 +688,7 @@ void PlannerThread::sendFinalGoal()
     m_inner_status = inner_status;
 }
 
-bool PlannerThread::startPath()
+bool PlannerThread::startPath(bool with_laser_obstacles)
 {
     yarp::math::Vec2D<double> start_vec;
     yarp::math::Vec2D<double> goal_vec;
@@ -756,25 +712,88 @@ bool PlannerThread::startPath()
     start.x = 150;//&&&&&
     start.y = 150;//&&&&&
 #endif
-    double t1 = yarp::os::Time::now();
     //clear the memory 
     m_computed_path.clear();
     m_computed_simplified_path.clear();
+    m_current_path_iterator = m_current_path->begin();
+    m_remaining_path.clear();
+    m_completed_request_id = 0;
+
+    //a precomputed route, if available, makes the search unnecessary. The routes do not know the laser obstacles
+    if (m_enable_roadmap && with_laser_obstacles == false && findRoadmapPath(start, goal))
+    {
+        return true;
+    }
+
+    //the search is performed by the planning worker, on a copy of the current map.
+    //The result is collected by checkPlanningResult(), called by run()
+    planning_request request;
+    if (with_laser_obstacles)
+    {
+        //the structures precomputed on the planning map (and validated only by its size) would ignore the laser obstacles.
+        //The incremental planner already knows them, but the path is simplified on the map of the request
+        request.map = m_costmap.master();
+        request.transient_obstacles = true;
+    }
+    else
+    {
+        request.map = m_current_map;
+        request.transient_obstacles = false;
+        request.abstract_graph = m_hpa_graph;
+        request.planning_grid = m_planning_grid;
+        request.pyramid = m_planning_pyramid;
+    }
+    request.cell_costs = m_clearance_cost;
+    double resolution = 0;
+    m_current_map.getResolution(resolution);
+    request.pyramid_corridor_radius = (resolution > 0) ? (size_t)(ceil(m_pyramid_corridor_width / 2 / resolution)) : 0;
+    request.inflation_radius = m_robot_radius;
+    request.algorithm = m_planner_algorithm;
+    request.start = start;
+    request.goal = goal;
+    request.time_budget = m_planning_time_budget;
+    m_planning_request_id = m_planning_worker.submit(request);
     m_planner_status = navigation_status_thinking;
+    yCDebug(PATHPLAN_CTRL) << "Planning request" << m_planning_request_id << "submitted";
+    return true;
+}
+
+void PlannerThread::checkPlanningResult()
+{
+    planning_result result;
+    if (m_planning_worker.getResult(result) == false) return;
+    if (result.id != m_planning_request_id) return;
+
+    if (result.id == m_completed_request_id)
+    {
+        //the robot is already following a path found by the anytime planner, which is still improving it
+        if (result.outcome == PLANNING_SUCCEEDED) { improvePath(result); }
+        else                                      { yCDebug(PATHPLAN_CTRL) << "The anytime search terminated without improving the current path"; }
+        return;
+    }
 
-    //search for a path
-    bool b = map_utilites::findPath(m_current_map, start, goal, m_computed_path);
-    if (!b)
+    if (result.outcome != PLANNING_SUCCEEDED)
     {
-        yCError (PATHPLAN_CTRL, "path not found");
+        if      (result.outcome == PLANNING_TIMEOUT)   { yCError(PATHPLAN_CTRL, "path not found: the time budget (%.2fs) expired", m_planning_time_budget); }
+        else if (result.outcome == PLANNING_CANCELLED) { yCError(PATHPLAN_CTRL, "path not found: the search was cancelled"); }
+        else                                           { yCError(PATHPLAN_CTRL, "path not found"); }
         m_planner_status = navigation_status_aborted;
-        return false;
+        return;
     }
-    double t2 = yarp::os::Time::now();
+    completePath(result);
+}
 
-    //search for an simpler path (waypoint optimization)
-    map_utilites::simplifyPath(m_current_map, m_computed_path, m_computed_simplified_path);
-    yCInfo(PATHPLAN_CTRL, "path size:%d simplified path size:%d time: %.2f", (int)m_computed_path.size(), (int)m_computed_simplified_path.size(), t2 - t1);
+void PlannerThread::completePath(const planning_result& result)
+{
+    m_completed_request_id = result.id;
+    m_computed_path = result.path;
+    m_computed_simplified_path = result.simplified_path;
+    m_current_path_epsilon = result.epsilon;
+    yCInfo(PATHPLAN_CTRL, "path size:%d simplified path size:%d time: %.2f", (int)m_computed_path.size(), (int)m_computed_simplified_path.size(), result.elapsed_time);
+    if (result.final_result == false)
+    {
+        yCInfo(PATHPLAN_CTRL, "the path is suboptimal (epsilon: %.2f), it will be improved while the robot is moving", result.epsilon);
+    }
 
     //choose the path to use
     if (m_use_optimized_path)
@@ -799,28 +818,224 @@ bool PlannerThread::startPath()
         {
             yCWarning(PATHPLAN_CTRL) << "Requested path has zero length. Aborting;";
             m_planner_status = navigation_status_goal_reached;
-            return true;
+            return;
         }
     }
 
     m_current_path_iterator = m_current_path->begin();
+    m_remaining_path.clear();
     std::copy(m_current_path->begin(), m_current_path->end(), std::back_inserter(m_remaining_path));
+    resetPathMonitor();
 
     //debug print
     if (1)
     {
-        yCDebug(PATHPLAN_CTRL) << "Current pos" << " x:" << start_vec.x << " y:" << start_vec.y;
+        yCDebug(PATHPLAN_CTRL) << "Current pos" << " x:" << m_localization_data.x << " y:" << m_localization_data.y;
         yCDebug(PATHPLAN_CTRL) << m_current_path->toString();
-        yCDebug(PATHPLAN_CTRL) << "Final goal" << " x:" << goal_vec.x << " y:" << goal_vec.y << " t:" << m_sequence_of_goals.front().theta;
+        yCDebug(PATHPLAN_CTRL) << "Final goal" << " x:" << m_sequence_of_goals.front().x << " y:" << m_sequence_of_goals.front().y << " t:" << m_sequence_of_goals.front().theta;
     }
 
     //just set the status to moving, do not set position commands.
     //The waypoint is set in the main 'run' loop.
     m_planner_status = navigation_status_moving;
     m_navigation_started_at_timeX = yarp::os::Time::now();
+}
+
+void PlannerThread::improvePath(const planning_result& result)
+{
+    if (result.epsilon >= m_current_path_epsilon) return;
+    if (m_current_path_iterator == m_current_path->end())
+    {
+        //the robot is already approaching the final goal
+        return;
+    }
+
+    bool same_path = (result.path.size() == m_computed_path.size());
+    for (size_t i = 0; same_path && i < result.path.size(); i++)
+    {
+        same_path = (result.path[i].x == m_computed_path[i].x && result.path[i].y == m_computed_path[i].y);
+    }
+    if (same_path)
+    {
+        //the search only proved that the current path has a tighter bound
+        m_current_path_epsilon = result.epsilon;
+        return;
+    }
+
+    //the new path starts where the search started, while the robot moved along the previous path. The next waypoint is the
+    //farthest one which can be reached with a straight line from the current robot position, as done by simplifyPath()
+    const Map2DPath& new_path = m_use_optimized_path ? result.simplified_path : result.path;
+    yarp::math::Vec2D<double> robot_vec;
+    robot_vec.x = m_localization_data.x;
+    robot_vec.y = m_localization_data.y;
+    XYCell robot_cell = m_current_map.world2Cell(robot_vec);
+    size_t next_waypoint = new_path.size();
+    for (size_t i = new_path.size(); i > 0; i--)
+    {
+        if (map_utilites::checkStraightLine(m_current_map, robot_cell, m_current_map.toXYCell(new_path[i - 1])))
+        {
+            next_waypoint = i - 1;
+            break;
+        }
+    }
+    if (next_waypoint == new_path.size())
+    {
+        yCDebug(PATHPLAN_CTRL) << "The improved path (epsilon:" << result.epsilon << ") cannot be reached from the current position, it is ignored";
+        return;
+    }
+
+    m_computed_path = result.path;
+    m_computed_simplified_path = result.simplified_path;
+    m_current_path_epsilon = result.epsilon;
+    m_current_path_iterator = m_current_path->begin() + next_waypoint;
+    m_remaining_path.clear();
+    std::copy(m_current_path_iterator, m_current_path->end(), std::back_inserter(m_remaining_path));
+    yCInfo(PATHPLAN_CTRL, "path improved (epsilon: %.2f, time: %.2f), %d waypoints left", result.epsilon, result.elapsed_time, (int)m_remaining_path.size());
+    resetPathMonitor();
+
+    useControllerProfile(m_waypoint_profile);
+    sendWaypoint();
+}
+
+void PlannerThread::addTemporaryObstaclesToMap()
+{
+    //the cells marked by the last scan become part of the static layer, then only the region they cover is recomposed
+    std::vector<XYCell> changed_cells;
+    m_static_layer.add_obstacles(m_laser_layer.marked_cells(), MapGrid2D::MAP_CELL_KEEP_OUT);
+    obstacle_layers::window_bounds bounds;
+    if (m_costmap.update(&bounds) == false) return;
+    m_costmap.compose(m_current_map, bounds, PLANNING_LAYERS, &changed_cells);
+    if (changed_cells.empty()) return;
+    m_global_map_changes.mark_cells(changed_cells);
+    m_navigation_function_cache.clear();
+    m_navigation_function_map_hash = 0;
+    //the next reload restores the map of the server
+    m_server_map_hash = 0;
+    rebuildPlanningGrid();
+    if (m_planner_algorithm == map_utilites::PLANNER_HPA_STAR)
+    {
+        //the entrances of the abstract graph may be blocked by the new obstacles
+        m_hpa_graph = m_hpa_cache.get(m_current_map, m_hpa_cluster_size);
+    }
+}
+
+void PlannerThread::updateRoadmap()
+{
+    //the nodes are the named locations of the current map, followed by the hubs
+    std::vector<roadmap_algorithm::roadmap_node> nodes;
+    std::vector<std::string> all_locations;
+    m_iMap->getLocationsList(all_locations);
+    std::sort(all_locations.begin(), all_locations.end());
+    Map2DLocation tmp_loc;
+    for (size_t i = 0; i < all_locations.size(); i++)
+    {
+        if (m_iMap->getLocation(all_locations[i], tmp_loc) == false) continue;
+        if (tmp_loc.map_id != m_current_map.getMapName()) continue;
+        yarp::math::Vec2D<double> v(tmp_loc.x, tmp_loc.y);
+        if (m_current_map.isInsideMap(v) == false) continue;
+        roadmap_algorithm::roadmap_node node;
+        node.name = all_locations[i];
+        node.cell = m_current_map.world2Cell(v);
+        nodes.push_back(node);
+    }
+    for (size_t i = 0; i < m_roadmap_hubs.size(); i++)
+    {
+        if (m_current_map.isInsideMap(m_roadmap_hubs[i]) == false) continue;
+        roadmap_algorithm::roadmap_node node;
+        node.name = "hub_" + std::to_string(i);
+        node.cell = m_current_map.world2Cell(m_roadmap_hubs[i]);
+        nodes.push_back(node);
+    }
+    m_current_map_hash = hpaStar_algorithm::compute_map_hash(m_current_map);
+    m_roadmap_builder.update(m_current_map, m_current_map_hash, nodes);
+    yCDebug(PATHPLAN_CTRL) << "Roadmap requested for map" << m_current_map.getMapName() << "with" << nodes.size() << "nodes";
+}
+
+void PlannerThread::updateKeepOutAreas()
+{
+    std::vector<Map2DArea> areas;
+    for (auto it = m_keep_out_areas.begin(); it != m_keep_out_areas.end(); it++)
+    {
+        Map2DArea area;
+        if (m_iMap->getArea(*it, area) == false)
+        {
+            yCWarning(PATHPLAN_CTRL) << "Unable to get the keep-out area" << *it << "from the map server";
+            continue;
+        }
+        if (area.map_id == m_current_map.getMapName()) areas.push_back(area);
+    }
+    m_keep_out_layer.set_areas(m_current_map, areas);
+}
+
+bool PlannerThread::findRoadmapPath(XYCell start, XYCell goal)
+{
+    std::shared_ptr<const roadmap_algorithm::roadmap> rmap = m_roadmap_builder.get(m_current_map_hash);
+    if (!rmap) return false;
+
+    //the route is validated against the master grid of the costmap, which contains the temporary obstacles detected so far
+    double t1 = yarp::os::Time::now();
+    double resolution = 0;
+    m_current_map.getResolution(resolution);
+    if (resolution <= 0) return false;
+    std::vector<XYCell> route;
+    if (rmap->find_route(m_costmap.master(), start, goal, m_roadmap_attach_distance / resolution, route) == false)
+    {
+        yCDebug(PATHPLAN_CTRL) << "No valid route in the roadmap, a search is required";
+        return false;
+    }
+
+    //the route replaces the search in progress, if any
+    m_planning_worker.cancel();
+    planning_result result;
+    result.outcome = PLANNING_SUCCEEDED;
+    for (auto it = route.begin(); it != route.end(); it++)
+    {
+        result.path.push_back(m_current_map.toLocation(*it));
+    }
+    result.simplified_path = result.path;
+    result.elapsed_time = yarp::os::Time::now() - t1;
+    yCInfo(PATHPLAN_CTRL) << "Path obtained from the roadmap";
+    completePath(result);
     return true;
 }
 
+void PlannerThread::resetPathMonitor()
+{
+    m_path_blocked_segment = path_monitoring::NO_SEGMENT;
+    if (m_enable_path_monitoring == false || m_remaining_path.empty())
+    {
+        m_path_monitor.clear();
+        return;
+    }
+    m_path_monitor.set_path(m_current_map, m_localization_data, m_remaining_path, m_robot_radius);
+
+    //the obstacles detected before the path was computed are checked once. After that, only the cells changed by a new scan are checked
+    const std::vector<XYCell>& swept_cells = m_path_monitor.swept_cells();
+    for (auto it = swept_cells.begin(); it != swept_cells.end(); it++)
+    {
+        if (m_laser_layer.flag_at(*it) != MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE) continue;
+        m_path_blocked_segment = std::min(m_path_blocked_segment, m_path_monitor.blocked_segment(*it));
+    }
+}
+
+void PlannerThread::repairBlockedPath()
+{
+    yCWarning(PATHPLAN_CTRL, "a new obstacle blocks the path %d waypoint(s) ahead, computing a new path", (int)m_path_blocked_segment + 1);
+    m_path_blocked_segment = path_monitoring::NO_SEGMENT;
+    m_path_monitor.clear();
+
+    //the new path avoids the obstacles currently detected by the laser, without adding them to the planning map.
+    //This method is called by run(), so it does not wait for the inner navigator to stop: the first waypoint
+    //of the new path is sent by run() when the inner navigator reports that it is idle.
+    m_planning_worker.cancel();
+    m_iInnerNav_ctrl->stopNavigation();
+    if (!startPath(true))
+    {
+        yCInfo(PATHPLAN_CTRL, "Unable to recompute the path, aborting navigation");
+        abortNavigation();
+    }
+}
+
 bool PlannerThread::recomputePath()
 {
     if (getNavigationStatusAsInt() == navigation_status_idle)
@@ -844,17 +1059,241 @@ bool PlannerThread::recomputePath()
         return false;
     }
 
-    Map2DLocation loc;
-    bool b = true;
-    b &= getCurrentAbsTarget(loc);
-    //@@@ check timing here
-    yarp::os::Time::delay(0.2);
-    b &= stopMovement();
-    //@@@ check timing here
-    yarp::os::Time::delay(0.2);
-    b &= setNewAbsTarget(loc);
-
-    return b;
+    //a new search towards the current goal is started without waiting for the inner navigator to stop:
+    //the first waypoint of the new path is sent by run() when the inner navigator reports that it is idle.
+    yCInfo(PATHPLAN_CTRL) << "Recomputing the path towards:" << m_final_goal.toString() << ", attempt:" << m_recovery_attempt;
+    m_planning_worker.cancel();
+    m_iInnerNav_ctrl->stopNavigation();
+    bool ret = startPath();
+    if (ret == false)
+    {
+        yCInfo(PATHPLAN_CTRL, "Unable to recompute the path, aborting navigation");
+        abortNavigation();
+    }
+    //the clients see the thinking status without waiting for the next cycle of run()
+    publishSnapshot();
+    return ret;
+}
+
+bool PlannerThread::solvePlanningRequest(planning_request& request, const planner_search::search_control& control, planning_result& result)
+{
+    //this method is executed by the planning worker thread
+    Map2DPath& path = result.path;
+    if (request.algorithm == map_utilites::PLANNER_THETA_STAR)
+    {
+        //the any-angle search directly produces the simplified path
+        return map_utilites::findAnyAnglePath(request.map, request.start, request.goal, path, result.simplified_path, request.planning_grid.get());
+    }
+    else if (request.algorithm == map_utilites::PLANNER_ARA_STAR)
+    {
+        return findAnytimePath(request, result);
+    }
+    else if (request.algorithm == map_utilites::PLANNER_DSTAR_LITE)
+    {
+        return findIncrementalPath(request.map, request.start, request.goal, path, control);
+    }
+    else if (request.algorithm == map_utilites::PLANNER_HPA_STAR)
+    {
+        return findHierarchicalPath(request.abstract_graph, request.map, request.start, request.goal, path);
+    }
+    else if (m_navigation_function_cache.enabled() && request.transient_obstacles == false && map_utilites::plannerAlgorithmIsOptimalGridSearch(request.algorithm))
+    {
+        return findPathFromNavigationFunction(request, path);
+    }
+    else if (request.pyramid && request.pyramid->matches(request.map) && request.algorithm == map_utilites::PLANNER_ASTAR_INDEXED)
+    {
+        return findMultiResolutionPath(request, path);
+    }
+    return map_utilites::findPath(request.map, request.start, request.goal, path, request.algorithm, request.cell_costs.get(), request.planning_grid.get());
+}
+
+bool PlannerThread::findAnytimePath(planning_request& request, planning_result& result)
+{
+    //each pass of the search publishes its path, so that the robot can start moving while the path is being improved.
+    //The search is interrupted by the time budget of the request: in this case the best path found so far is the final result.
+    auto publish = [this, &request](const std::deque<XYCell>& cell_path, double epsilon)
+    {
+        planning_result intermediate;
+        for (auto it = cell_path.begin(); it != cell_path.end(); it++)
+        {
+            intermediate.path.push_back(request.map.toLocation(*it));
+        }
+        intermediate.epsilon = epsilon;
+        m_planning_worker.publishIntermediateResult(request, intermediate);
+    };
+
+    std::deque<XYCell> cell_path;
+    bool b = false;
+    if (request.planning_grid && request.planning_grid->matches(request.map))
+    {
+        b = araStar_algorithm::find_ara_path(*request.planning_grid, request.start, request.goal, cell_path, aStarIndexed_algorithm::default_workspace(),
+                                             request.cell_costs.get(), m_ara_parameters, result.epsilon, publish);
+    }
+    else
+    {
+        b = araStar_algorithm::find_ara_path(request.map, request.start, request.goal, cell_path, aStarIndexed_algorithm::default_workspace(),
+                                             request.cell_costs.get(), m_ara_parameters, result.epsilon, publish);
+    }
+    if (b == false) return false;
+    for (auto it = cell_path.begin(); it != cell_path.end(); it++)
+    {
+        result.path.push_back(request.map.toLocation(*it));
+    }
+    return true;
+}
+
+void PlannerThread::rebuildPlanningGrid()
+{
+    //a new grid is allocated, since the previous one may still be in use by the planning worker
+    std::shared_ptr<planner_search::planning_grid> grid = std::make_shared<planner_search::planning_grid>();
+    grid->build(m_current_map);
+    m_planning_grid = grid;
+
+    m_planning_pyramid.reset();
+    if (m_pyramid_levels > 0)
+    {
+        std::shared_ptr<multiResolution_algorithm::planning_pyramid> pyramid = std::make_shared<multiResolution_algorithm::planning_pyramid>();
+        pyramid->build(m_planning_grid, m_pyramid_levels);
+        m_planning_pyramid = pyramid;
+    }
+}
+
+bool PlannerThread::findMultiResolutionPath(planning_request& request, Map2DPath& path)
+{
+    double t1 = yarp::os::Time::now();
+    std::deque<XYCell> cell_path;
+    planner_search::search_workspace& workspace = aStarIndexed_algorithm::default_workspace();
+    if (multiResolution_algorithm::find_multiresolution_path(*request.pyramid, request.start, request.goal, cell_path, workspace,
+                                                             request.cell_costs.get(), request.pyramid_corridor_radius) == false)
+    {
+        return false;
+    }
+    for (auto it = cell_path.begin(); it != cell_path.end(); it++)
+    {
+        path.push_back(request.map.toLocation(*it));
+    }
+    double t2 = yarp::os::Time::now();
+    yCDebug(PATHPLAN_CTRL) << "Coarse-to-fine search over" << request.pyramid->levels() << "levels, expanded nodes:" << workspace.stats.expanded_nodes << ", time:" << t2 - t1;
+    return true;
+}
+
+bool PlannerThread::findIncrementalPath(MapGrid2D& map, XYCell start, XYCell goal, Map2DPath& path, const planner_search::search_control& control)
+{
+    //the incremental planner takes into account both the static map and the temporary obstacles detected by the laser.
+    //Only the temporary obstacles are copied inside the critical section, the planner is initialized (or repaired) on the copy,
+    //so that the control thread, which updates the temporary obstacles at each cycle, is never blocked by a search.
+    double t1 = yarp::os::Time::now();
+    bool reinitialize = (m_incremental_planner.is_initialized_for(map.getMapName(), goal) == false);
+    std::vector<XYCell> blocked_cells;
+    std::vector<std::pair<XYCell, bool> > changed_cells;
+    {
+        std::lock_guard<std::mutex> lock(m_temporary_obstacles_map_mutex);
+        if (m_incremental_planner_reset) reinitialize = true;
+        m_incremental_planner_reset = false;
+        if (reinitialize)
+        {
+            //the temporary obstacles are the cells marked by the last scan which has been applied to m_temporary_obstacles_map.
+            //The flags are checked anyway, since the map may have been reloaded after the last scan.
+            const std::vector<XYCell>& marked_cells = m_laser_layer.marked_cells();
+            for (auto it = marked_cells.begin(); it != marked_cells.end(); it++)
+            {
+                MapGrid2D::map_flags flag = MapGrid2D::MAP_CELL_FREE;
+                m_temporary_obstacles_map.getMapFlag(*it, flag);
+                if (flag == MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE || flag == MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE) blocked_cells.push_back(*it);
+            }
+        }
+        else
+        {
+            changed_cells.reserve(m_incremental_changed_cells.size());
+            for (auto it = m_incremental_changed_cells.begin(); it != m_incremental_changed_cells.end(); it++)
+            {
+                MapGrid2D::map_flags flag = MapGrid2D::MAP_CELL_FREE;
+                m_temporary_obstacles_map.getMapFlag(*it, flag);
+                changed_cells.push_back(std::make_pair(*it, flag != MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE && flag != MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE));
+            }
+        }
+        m_incremental_changed_cells.clear();
+    }
+
+    if (reinitialize)
+    {
+        yCDebug(PATHPLAN_CTRL) << "Initializing the incremental planner";
+        if (m_incremental_planner.initialize(map, goal) == false) return false;
+        //the search has not started yet, so the cells are only marked as blocked
+        for (auto it = blocked_cells.begin(); it != blocked_cells.end(); it++)
+        {
+            m_incremental_planner.set_cell_free(*it, false);
+        }
+    }
+    else
+    {
+        //a cell may appear more than once: the flags have been read at the same time, so the last occurrence is as good as the first one
+        size_t changed = 0;
+        for (auto it = changed_cells.begin(); it != changed_cells.end(); it++)
+        {
+            bool free = it->second && map.isFree(it->first);
+            if (free != m_incremental_planner.is_cell_free(it->first))
+            {
+                m_incremental_planner.set_cell_free(it->first, free);
+                changed++;
+            }
+        }
+        yCDebug(PATHPLAN_CTRL) << "Incremental planner: repairing" << changed << "changed cells";
+    }
+
+    std::deque<XYCell> cell_path;
+    m_incremental_planner.control = &control;
+    bool b = m_incremental_planner.compute_path(start, cell_path);
+    m_incremental_planner.control = nullptr;
+    if (b == false) return false;
+    for (auto it = cell_path.begin(); it != cell_path.end(); it++)
+    {
+        path.push_back(map.toLocation(*it));
+    }
+    yCDebug(PATHPLAN_CTRL) << "Incremental planner: path computed in" << yarp::os::Time::now() - t1 << "s";
+    return true;
+}
+
+bool PlannerThread::findPathFromNavigationFunction(planning_request& request, Map2DPath& path)
+{
+    //the field rooted at the goal is computed only the first time the goal is requested, then each path is extracted in O(path length)
+    std::shared_ptr<const std::vector<float> > cell_costs;
+    if (map_utilites::plannerAlgorithmSupportsCellCosts(request.algorithm)) cell_costs = request.cell_costs;
+    std::shared_ptr<const navigationFunction_algorithm::cost_to_go_field> field =
+        m_navigation_function_cache.get(request.map, request.goal, request.inflation_radius, cell_costs, aStarIndexed_algorithm::default_workspace());
+    if (!field) return false;
+
+    std::deque<XYCell> cell_path;
+    if (field->extract_path(request.map, request.start, cell_path) == false) return false;
+    for (auto it = cell_path.begin(); it != cell_path.end(); it++)
+    {
+        path.push_back(request.map.toLocation(*it));
+    }
+    return true;
+}
+
+bool PlannerThread::findHierarchicalPath(std::shared_ptr<const hpaStar_algorithm::abstract_graph> graph, MapGrid2D& map, XYCell start, XYCell goal, Map2DPath& path)
+{
+    std::deque<XYCell> cell_path;
+    bool b = false;
+    if (graph &&
+        graph->width == map.width() &&
+        graph->height == map.height())
+    {
+        b = hpaStar_algorithm::find_hpa_path(*graph, map, start, goal, cell_path);
+    }
+    if (b)
+    {
+        for (auto it = cell_path.begin(); it != cell_path.end(); it++)
+        {
+            path.push_back(map.toLocation(*it));
+        }
+        return true;
+    }
+
+    //the abstract graph may be outdated (e.g. obstacles added by the recovery procedure): fallback to a full resolution search
+    yCDebug(PATHPLAN_CTRL) << "Hierarchical search failed, falling back to A*";
+    return map_utilites::findPath(map, start, goal, path, map_utilites::PLANNER_ASTAR_INDEXED);
 }
 
 void PlannerThread::abortNavigation()
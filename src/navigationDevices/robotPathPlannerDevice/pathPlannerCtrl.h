@@ -43,10 +43,26 @@
 #include <yarp/dev/ILocalization2D.h>
 #include <yarp/dev/INavigation2D.h>
 #include <string>
+#include <mutex>
+#include <map>
+#include <memory>
 #include <yarp/rosmsg/visualization_msgs/MarkerArray.h>
 #include <yarp/dev/Map2DPath.h>
 #include <yarp/dev/Map2DLocation.h>
 #include "map.h"
+#include "dStarLite.h"
+#include "hpaStar.h"
+#include "planningWorker.h"
+#include "rollingWindowLayer.h"
+#include "layeredCostmap.h"
+#include "mapImagePublisher.h"
+#include "distanceTransform.h"
+#include "navigationFunction.h"
+#include "araStar.h"
+#include "multiResolution.h"
+#include "pathMonitor.h"
+#include "mapChangeTracker.h"
+#include "roadmap.h"
 
 using namespace std;
 
@@ -59,6 +75,22 @@ const double DEG2RAD = M_PI / 180.0;
 
 #define TIMEOUT_MAX 100
 
+//the state of the planner exposed to the clients (see PlannerThread::getSnapshot()). A new snapshot is published by run()
+//once per cycle, and by the commands which change the navigation status or the target. It is never modified afterwards,
+//so it can be read without locking the control loop.
+struct planner_snapshot
+{
+    yarp::dev::Nav2D::NavigationStatusEnum             status;
+    yarp::dev::Nav2D::Map2DLocation                    robot;             //the localization data
+    bool                                               target_valid;
+    yarp::dev::Nav2D::Map2DLocation                    current_target;    //absolute
+    bool                                               waypoint_valid;
+    yarp::dev::Nav2D::Map2DLocation                    current_waypoint;
+    yarp::dev::Nav2D::Map2DPath                        remaining_path;    //from the current waypoint to the final goal
+    std::shared_ptr<const yarp::dev::Nav2D::MapGrid2D> map;               //shared among the snapshots, until the map changes
+    size_t                                             map_version;
+};
+
 class PlannerThread: public yarp::os::PeriodicThread
 {
     protected:
@@ -81,6 +113,14 @@ class PlannerThread: public yarp::os::PeriodicThread
     double m_waypoint_lin_gain;        //m/s
     int    m_min_waypoint_distance;    //cells
 
+    //named sets of controller parameters, uploaded to the inner navigator (robotGoto) so that each waypoint transition
+    //requires a single 'use_profile' command. Each profile is a list of (param value) pairs.
+    std::map<std::string, Bottle> m_controller_profiles;
+    std::string m_waypoint_profile;
+    std::string m_goal_profile;
+    bool        m_use_controller_profiles;
+    bool        m_controller_profiles_uploaded;
+
     //semaphore
     public:
     Semaphore m_mutex;
@@ -92,6 +132,7 @@ class PlannerThread: public yarp::os::PeriodicThread
     double    m_robot_laser_y;       //m
     double    m_robot_laser_t;       //deg
     bool      m_use_optimized_path;
+    map_utilites::planner_algorithm_type m_planner_algorithm;
     double    m_min_laser_angle;
     double    m_max_laser_angle;
     double    m_laser_angle_of_view;
@@ -103,12 +144,80 @@ class PlannerThread: public yarp::os::PeriodicThread
     size_t    m_recovery_attempt=0;
     size_t    m_max_recovery_attempts=5;
 
+    //path monitoring: the cells hit by the laser are checked against the remaining path, which is replanned as soon as it is blocked
+    bool      m_enable_path_monitoring;
+    path_monitoring::path_validity_monitor m_path_monitor;
+    uint32_t  m_path_blocked_segment;
+
     //storage for the environment map
     yarp::dev::Nav2D::MapGrid2D m_current_map;
     yarp::dev::Nav2D::MapGrid2D m_temporary_obstacles_map;
     std::mutex m_temporary_obstacles_map_mutex;
-    yarp::dev::Nav2D::MapGrid2D m_augmented_map;
     bool      m_force_map_reload;
+    uint64_t  m_server_map_hash;  //the hash (see map_utilites::computeMapHash()) of the map received from the server at the last reload, 0 if m_current_map has been modified since then
+
+    //layered costmap: static map, keep-out areas, enlargement and laser obstacles. Its master grid is the static map plus the
+    //temporary obstacles, recomposed only inside the regions changed by the layers. The first PLANNING_LAYERS layers compose m_current_map
+    static const size_t PLANNING_LAYERS = 3;
+    obstacle_layers::layered_costmap        m_costmap;
+    obstacle_layers::static_layer           m_static_layer;
+    obstacle_layers::keep_out_layer         m_keep_out_layer;
+    obstacle_layers::inflation_layer        m_inflation_layer;
+    obstacle_layers::laser_obstacle_layer   m_laser_obstacle_layer;
+    std::vector<std::string>                m_keep_out_areas;
+
+    //clearance field of the current map, used to enlarge the obstacles and (optionally) to keep the path away from them
+    distanceTransform_algorithm::clearance_map m_clearance_map;
+    std::shared_ptr<const std::vector<float> > m_clearance_cost;
+    double    m_clearance_cost_weight;
+    double    m_clearance_cost_distance; //m
+
+    //incremental planner (planner_algorithm = dstar_lite). Its search state is kept between two calls to startPath() and it is used by the planning worker only.
+    //The control thread records the cells changed by the laser, which are collected by the worker at the beginning of each search.
+    dStarLite_algorithm::dstar_lite_planner m_incremental_planner;
+    std::vector<yarp::dev::Nav2D::XYCell>   m_incremental_changed_cells; //protected by m_temporary_obstacles_map_mutex
+    bool                                    m_incremental_planner_reset; //protected by m_temporary_obstacles_map_mutex
+
+    //hierarchical planner (planner_algorithm = hpa_star). The abstract graphs are built when a map is loaded and cached by map name
+    hpaStar_algorithm::abstract_graph_cache               m_hpa_cache;
+    std::shared_ptr<const hpaStar_algorithm::abstract_graph> m_hpa_graph;
+    size_t                                                m_hpa_cluster_size;
+
+    //traversability of m_current_map packed in 1 bit per cell, rebuilt each time the obstacles of m_current_map change (astar, jps, theta_star, ara_star)
+    std::shared_ptr<const planner_search::planning_grid> m_planning_grid;
+
+    //coarse-to-fine search (planner_algorithm = astar). The pyramid is rebuilt together with m_planning_grid. Disabled if pyramid_levels is 0
+    std::shared_ptr<const multiResolution_algorithm::planning_pyramid> m_planning_pyramid;
+    size_t                                                            m_pyramid_levels;
+    double                                                            m_pyramid_corridor_width; //m
+
+    //cost-to-go fields rooted at the recent goals (planner_algorithm = astar_legacy, astar, jps). Disabled if navigation_function_cache_size is 0
+    navigationFunction_algorithm::navigation_function_cache m_navigation_function_cache;
+    uint64_t                                                m_navigation_function_map_hash; //the hash of the planning map of the cached fields, 0 if unknown
+
+    //asynchronous planning: the searches are performed by m_planning_worker, their results are collected by run()
+    PlanningWorker m_planning_worker;
+    size_t         m_planning_request_id;
+    size_t         m_completed_request_id;  //the request which produced the path being followed, 0 if the path was not found by the worker
+    double         m_planning_time_budget;  //s. For ara_star, the deadline after which the best path found so far is kept
+
+    //anytime planner (planner_algorithm = ara_star). The improved paths replace the current one while the robot is moving
+    araStar_algorithm::ara_parameters m_ara_parameters;
+    double                            m_current_path_epsilon;
+
+    //the snapshot read by the getters of robotPathPlannerDev. It is replaced (std::atomic_store) at the end of each cycle of run() and by the navigation commands
+    std::shared_ptr<const planner_snapshot> m_snapshot;
+
+    //the versions of m_current_map (global map) and m_temporary_obstacles_map (local map), tracked at tile granularity (see getMapUpdate())
+    map_versioning::tile_change_tracker     m_global_map_changes;
+    map_versioning::tile_change_tracker     m_local_map_changes;     //protected by m_temporary_obstacles_map_mutex
+
+    //precomputed paths between the named locations of the current map (and the hubs), built in background. Disabled if enable_roadmap is 0
+    bool                                        m_enable_roadmap;
+    double                                      m_roadmap_attach_distance; //m
+    std::vector<yarp::math::Vec2D<double> >     m_roadmap_hubs;
+    roadmap_algorithm::roadmap_builder          m_roadmap_builder;
+    uint64_t                                    m_current_map_hash;
 
     //yarp device drivers and interfaces
     yarp::dev::PolyDriver                                  m_ptf;
@@ -121,6 +230,7 @@ class PlannerThread: public yarp::os::PeriodicThread
 
     //yarp ports
     BufferedPort<yarp::sig::ImageOf<yarp::sig::PixelRgb> > m_port_map_output;
+    MapImagePublisher                                      m_map_image_publisher;
     BufferedPort<yarp::os::Bottle>                         m_port_status_output;
     RpcClient                                              m_port_commands_output;
     yarp::dev::PolyDriver                                  m_pInnerNav;
@@ -137,6 +247,8 @@ class PlannerThread: public yarp::os::PeriodicThread
     std::queue<yarp::dev::Nav2D::Map2DLocation>   m_sequence_of_goals;
     std::string                            m_last_target;
     std::vector<yarp::dev::Nav2D::XYCell>   m_laser_map_cells;
+    std::vector<yarp::dev::Nav2D::XYCell>   m_laser_changed_cells;
+    obstacle_layers::rolling_window_layer   m_laser_layer;
 
     //the path computed by the planner, stored a sequence of waypoints to be reached
     yarp::dev::Nav2D::Map2DPath                   m_computed_path;
@@ -148,6 +260,7 @@ class PlannerThread: public yarp::os::PeriodicThread
     //statuses of the internal finite-state machine
     yarp::dev::Nav2D::NavigationStatusEnum   m_planner_status;
     yarp::dev::Nav2D::NavigationStatusEnum   m_inner_status;
+    yarp::dev::Nav2D::NavigationStatusEnum   m_status_before_pause;  //restored by resumeMovement()
 
     //timeout counters (watchdog on the communication with external modules)
     protected:
@@ -225,7 +338,7 @@ class PlannerThread: public yarp::os::PeriodicThread
 
     /**
     * Recomputes the path to current goal.
-    * @return true if the a path was found, false otherwise
+    * @return true if the search of the new path has been started, false otherwise
     */
     bool          recomputePath();
 
@@ -272,7 +385,33 @@ class PlannerThread: public yarp::os::PeriodicThread
     */
     void          getTimeouts(int& localiz, int& laser, int& inner_status);
 
-    bool          reloadCurrentMap();
+    /**
+    * Returns the last snapshot of the planner state published by the control thread. The call does not wait for the control loop.
+    * @return the snapshot, nullptr if the thread has not been initialized yet
+    */
+    std::shared_ptr<const planner_snapshot> getSnapshot() const { return std::atomic_load(&m_snapshot); }
+
+    /**
+    * Prepares the data required by a client to update its copy of the global or of the local map.
+    * The reply contains the epoch and the current version of the map, followed by 'none' (the copy of the client is up to date),
+    * by 'tiles <tile_size> (x y w h {flags})...' (the flags of the modified tiles, one byte per cell, row-major),
+    * or by 'full (map)' (the serialized map). The epoch changes at each restart of the planner, which resets the versions.
+    * @param map_type global_map or local_map
+    * @param client_epoch the epoch received together with the copy owned by the client, 0 if the client has no copy
+    * @param client_version the version of the copy owned by the client, 0 if the client has no copy
+    * @param reply the bottle which is filled with the update
+    * @return true if the command is executed successfully, false otherwise
+    */
+    bool          getMapUpdate(yarp::dev::Nav2D::NavigationMapTypeEnum map_type, uint64_t client_epoch, uint64_t client_version, yarp::os::Bottle& reply);
+
+    /**
+    * Gets the map of the current location from the map server and rebuilds the planning structures. The rebuild is skipped if the
+    * received map is the same (name and content) as the one used by the previous reload, and m_current_map has not been modified since then.
+    * The caller must hold m_mutex, since the rebuild replaces the structures used by run().
+    * @param force if true, the structures are rebuilt also if the map did not change
+    * @return false if the map cannot be obtained from the server
+    */
+    bool          reloadCurrentMap(bool force = false);
     bool          getCurrentWaypoint(yarp::dev::Nav2D::Map2DLocation &loc) const;
     bool          getCurrentMap(yarp::dev::Nav2D::MapGrid2D& current_map) const;
     bool          getCurrentPath(yarp::dev::Nav2D::Map2DPath& current_path) const;
@@ -282,8 +421,33 @@ class PlannerThread: public yarp::os::PeriodicThread
     void          resetAttemptCounter();
 
     private:
-    bool          startPath();
+    /**
+    * Submits the search of a path to the first goal of m_sequence_of_goals to the planning worker.
+    * @param with_laser_obstacles if true, the search is performed on the master grid of the costmap, which contains also the obstacles
+    * currently detected by the laser. They are not added to the planning map, so they are forgotten as soon as they disappear.
+    * @return false if the robot or the goal are outside the map
+    */
+    bool          startPath(bool with_laser_obstacles = false);
+    void          checkPlanningResult();
+    void          completePath(const planning_result& result);
+    void          improvePath(const planning_result& result);
+    bool          solvePlanningRequest(planning_request& request, const planner_search::search_control& control, planning_result& result);
+    bool          findAnytimePath(planning_request& request, planning_result& result);
+    bool          findIncrementalPath(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, yarp::dev::Nav2D::Map2DPath& path, const planner_search::search_control& control);
+    bool          findPathFromNavigationFunction(planning_request& request, yarp::dev::Nav2D::Map2DPath& path);
+    bool          findMultiResolutionPath(planning_request& request, yarp::dev::Nav2D::Map2DPath& path);
+    void          rebuildPlanningGrid();
+    void          resetPathMonitor();
+    void          publishSnapshot();
+    void          addTemporaryObstaclesToMap();
+    void          repairBlockedPath();
+    void          updateRoadmap();
+    void          updateKeepOutAreas();
+    bool          findRoadmapPath(yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal);
+    bool          findHierarchicalPath(std::shared_ptr<const hpaStar_algorithm::abstract_graph> graph, yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, yarp::dev::Nav2D::Map2DPath& path);
     void          sendWaypoint();
+    bool          uploadControllerProfiles();
+    void          useControllerProfile(const std::string& name);
     void          sendFinalGoal();
     bool          readLocalizationData();
     void          readLaserData();
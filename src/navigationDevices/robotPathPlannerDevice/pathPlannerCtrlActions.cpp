@@ -51,15 +51,14 @@ bool PlannerThread::setNewAbsTarget(Map2DLocation target)
         std::swap(m_sequence_of_goals, empty);
 
         m_sequence_of_goals.push(m_final_goal);
-        if (startPath())
-        {
-            return true;
-        }
-        else
+        bool ret = startPath();
+        if (ret == false)
         {
             yCError(PATHPLAN_ACTIONS) << "PlannerThread::setNewAbsTarget() Unable to start path";
-            return false;
         }
+        //the clients see the new target (and the thinking status) without waiting for the next cycle of run()
+        publishSnapshot();
+        return ret;
     }
     else
     {
@@ -71,6 +70,7 @@ bool PlannerThread::setNewAbsTarget(Map2DLocation target)
         std::queue<Map2DLocation> empty;
         std::swap(m_sequence_of_goals, empty);
         m_sequence_of_goals.push(m_final_goal);
+        publishSnapshot();
         return false;
     }
     return true;
@@ -113,20 +113,21 @@ bool PlannerThread::setNewRelTarget(yarp::sig::Vector target)
     std::queue<Map2DLocation> empty;
     std::swap(m_sequence_of_goals, empty);
     m_sequence_of_goals.push(m_final_goal);
-    if (startPath())
-    {
-        return true;
-    }
-    else
+    bool ret = startPath();
+    if (ret == false)
     {
         yCError(PATHPLAN_ACTIONS) << "PlannerThread::setNewRelTarget() Unable to start path";
-        return false;
     }
+    publishSnapshot();
+    return ret;
 }
 
 bool PlannerThread::stopMovement()
 {
     bool ret = true;
+    //cancel the search in progress, if any
+    m_planning_worker.cancel();
+
     //stop the inner navigation loop
     m_iInnerNav_ctrl->stopNavigation();
 
@@ -141,6 +142,7 @@ bool PlannerThread::stopMovement()
         yCWarning (PATHPLAN_ACTIONS, "Already not moving");
         ret = false;
     }
+    publishSnapshot();
     return ret;
 }
 
@@ -150,8 +152,13 @@ bool PlannerThread::resumeMovement()
     //resuming the inner navigation loop
     m_iInnerNav_ctrl->resumeNavigation();
 
-    //resume the outer navigation loop
-    if (m_planner_status != navigation_status_moving)
+    //resume the outer navigation loop. If the pause interrupted a search, the planner waits again for its result
+    if (m_planner_status == navigation_status_paused)
+    {
+        m_planner_status = m_status_before_pause;
+        yCInfo (PATHPLAN_ACTIONS, "Navigation resumed");
+    }
+    else if (m_planner_status != navigation_status_moving)
     {
         m_planner_status = navigation_status_moving;
         yCInfo (PATHPLAN_ACTIONS, "Navigation resumed");
@@ -161,6 +168,7 @@ bool PlannerThread::resumeMovement()
         yCWarning (PATHPLAN_ACTIONS, "Already moving!");
         ret = false;
     }
+    publishSnapshot();
    return ret;
 }
 
@@ -173,6 +181,7 @@ bool PlannerThread::pauseMovement(double d)
     //pausing the outer navigation loop
     if (m_planner_status != navigation_status_paused)
     {
+        m_status_before_pause = (m_planner_status == navigation_status_thinking) ? navigation_status_thinking : navigation_status_moving;
         m_planner_status = navigation_status_paused;
         yCInfo (PATHPLAN_ACTIONS, "Navigation stopped");
     }
@@ -181,6 +190,7 @@ bool PlannerThread::pauseMovement(double d)
         yCWarning (PATHPLAN_ACTIONS, "Already paused");
         ret = false;
     }
+    publishSnapshot();
     return ret;
 }
 
@@ -16,6 +16,7 @@
  * Public License for more details
 */
 
+#include <yarp/os/Portable.h>
 #include "pathPlannerCtrl.h"
 #include "pathPlannerCtrlHelpers.h"
 
@@ -25,6 +26,54 @@ using namespace yarp::dev::Nav2D;
 
 YARP_LOG_COMPONENT(PATHPLAN_GETS, "navigation.devices.robotPathPlanner.gets")
 
+namespace
+{
+    //appends the flags of the cells of a tile, one byte per cell (row-major), to the reply
+    void add_tile(Bottle& reply, const MapGrid2D& map, const map_versioning::tile_bounds& tile)
+    {
+        std::vector<unsigned char> flags(tile.w * tile.h);
+        for (size_t y = 0; y < tile.h; y++)
+            for (size_t x = 0; x < tile.w; x++)
+            {
+                MapGrid2D::map_flags flag = MapGrid2D::MAP_CELL_UNKNOWN;
+                map.getMapFlag(XYCell(tile.x + x, tile.y + y), flag);
+                flags[y * tile.w + x] = (unsigned char)(flag);
+            }
+        Bottle& b = reply.addList();
+        b.addInt32((int)tile.x);
+        b.addInt32((int)tile.y);
+        b.addInt32((int)tile.w);
+        b.addInt32((int)tile.h);
+        b.add(yarp::os::Value(flags.data(), (int)flags.size()));
+    }
+
+    void add_map_update(Bottle& reply, const MapGrid2D& map, const map_versioning::tile_change_tracker& changes, uint64_t client_epoch, uint64_t client_version)
+    {
+        std::vector<map_versioning::tile_bounds> tiles;
+        map_versioning::update_type type = changes.changes_since(client_epoch, client_version, tiles);
+        reply.addInt64((int64_t)changes.epoch());
+        reply.addInt64((int64_t)changes.version());
+        if (type == map_versioning::UPDATE_NONE)
+        {
+            reply.addString("none");
+        }
+        else if (type == map_versioning::UPDATE_TILES)
+        {
+            reply.addString("tiles");
+            reply.addInt32((int)changes.tile_size());
+            for (auto it = tiles.begin(); it != tiles.end(); it++)
+            {
+                add_tile(reply, map, *it);
+            }
+        }
+        else
+        {
+            reply.addString("full");
+            yarp::os::Portable::copyPortable(map, reply.addList());
+        }
+    }
+}
+
 bool PlannerThread::getFinalAbsTarget(Map2DLocation& target)
 {
     Map2DLocation m;
@@ -108,3 +157,46 @@ void  PlannerThread::getTimeouts(int& localiz, int& laser, int& inner_status)
     laser = m_laser_timeout_counter;
     inner_status = m_inner_status_timeout_counter;
 }
+
+void PlannerThread::publishSnapshot()
+{
+    std::shared_ptr<const planner_snapshot> previous = std::atomic_load(&m_snapshot);
+    std::shared_ptr<planner_snapshot> snapshot = std::make_shared<planner_snapshot>();
+    snapshot->status = m_planner_status;
+    snapshot->robot = m_localization_data;
+    snapshot->target_valid = (m_sequence_of_goals.empty() == false);
+    if (snapshot->target_valid)
+    {
+        snapshot->current_target = m_sequence_of_goals.front();
+    }
+    snapshot->waypoint_valid = getCurrentWaypoint(snapshot->current_waypoint);
+    getCurrentPath(snapshot->remaining_path);
+
+    //the map is copied only if it changed since the previous snapshot, otherwise the copy is shared
+    if (previous && previous->map && previous->map_version == m_global_map_changes.version())
+    {
+        snapshot->map = previous->map;
+    }
+    else
+    {
+        snapshot->map = std::make_shared<MapGrid2D>(m_current_map);
+    }
+    snapshot->map_version = m_global_map_changes.version();
+    std::atomic_store(&m_snapshot, std::shared_ptr<const planner_snapshot>(snapshot));
+}
+
+bool PlannerThread::getMapUpdate(NavigationMapTypeEnum map_type, uint64_t client_epoch, uint64_t client_version, Bottle& reply)
+{
+    if (map_type == NavigationMapTypeEnum::global_map)
+    {
+        add_map_update(reply, m_current_map, m_global_map_changes, client_epoch, client_version);
+        return true;
+    }
+    else if (map_type == NavigationMapTypeEnum::local_map)
+    {
+        std::lock_guard<std::mutex> lock(m_temporary_obstacles_map_mutex);
+        add_map_update(reply, m_temporary_obstacles_map, m_local_map_changes, client_epoch, client_version);
+        return true;
+    }
+    return false;
+}
@@ -30,6 +30,7 @@ PlannerThread::PlannerThread(double _period, Searchable &_cfg) :
 {
     m_planner_status = navigation_status_idle;
     m_inner_status = navigation_status_idle;
+    m_status_before_pause = navigation_status_moving;
     m_loc_timeout_counter = 0;
     m_laser_timeout_counter = 0;
     m_inner_status_timeout_counter = 0;
@@ -46,7 +47,22 @@ PlannerThread::PlannerThread(double _period, Searchable &_cfg) :
     m_waypoint_min_lin_speed = 0.0;
     m_waypoint_min_ang_speed = 0.0;
     m_use_optimized_path = true;
+    m_waypoint_profile = "waypoint";
+    m_goal_profile = "goal";
+    m_use_controller_profiles = true;
+    m_controller_profiles_uploaded = false;
+    m_planner_algorithm = map_utilites::PLANNER_ASTAR_INDEXED;
+    m_hpa_cluster_size = hpaStar_algorithm::DEFAULT_CLUSTER_SIZE;
+    m_planning_request_id = 0;
+    m_completed_request_id = 0;
+    m_planning_time_budget = 0;
+    m_current_path_epsilon = 1.0;
+    m_pyramid_levels = 0;
+    m_pyramid_corridor_width = 1.0;
+    m_clearance_cost_weight = 0;
+    m_clearance_cost_distance = 0.5;
     m_current_path = &m_computed_simplified_path;
+    m_current_path_iterator = m_current_path->begin();
     m_min_waypoint_distance = 0;
     m_iLaser = 0;
     m_iLoc = 0;
@@ -57,13 +73,26 @@ PlannerThread::PlannerThread(double _period, Searchable &_cfg) :
     m_robot_laser_y = 0;
     m_robot_laser_t = 0;
     m_enable_try_recovery=false;
+    m_enable_path_monitoring = false;
+    m_enable_roadmap = false;
+    m_roadmap_attach_distance = 1.0;
+    m_current_map_hash = 0;
+    m_navigation_function_map_hash = 0;
+    m_path_blocked_segment = path_monitoring::NO_SEGMENT;
     m_stats_time_curr = yarp::os::Time::now();
     m_stats_time_last = yarp::os::Time::now();
     m_iInnerNav_ctrl = 0;
     m_iInnerNav_target = 0;
     m_force_map_reload = false;
+    m_server_map_hash = 0;
+    m_incremental_planner_reset = true;
     m_navigation_started_at_timeX = 0;
     m_final_goal_reached_at_timeX = 0;
+    m_laser_obstacle_layer.set_source(&m_laser_layer);
+    m_costmap.add_layer(&m_static_layer);
+    m_costmap.add_layer(&m_keep_out_layer);
+    m_costmap.add_layer(&m_inflation_layer);
+    m_costmap.add_layer(&m_laser_obstacle_layer);
 }
 
 bool PlannerThread::threadInit()
@@ -91,6 +120,67 @@ bool PlannerThread::threadInit()
     else { yCError(PATHPLAN_INIT) << "Missing goal_tolerance_ang parameter"; return false; }
     if (navigation_group.check("use_optimized_path")) { int p = navigation_group.find("use_optimized_path").asInt(); m_use_optimized_path = (p == 1); }
     else { yCError(PATHPLAN_INIT) << "Missing use_optimized_path parameter"; return false; }
+    if (navigation_group.check("planner_algorithm"))
+    {
+        string algo_name = navigation_group.find("planner_algorithm").asString();
+        if (map_utilites::stringToPlannerAlgorithm(algo_name, m_planner_algorithm) == false)
+        {
+            yCError(PATHPLAN_INIT) << "Invalid planner_algorithm parameter:" << algo_name; return false;
+        }
+    }
+    yCInfo(PATHPLAN_INIT) << "Using planner_algorithm:" << map_utilites::plannerAlgorithmToString(m_planner_algorithm);
+    if (navigation_group.check("hpa_cluster_size"))
+    {
+        int p = navigation_group.find("hpa_cluster_size").asInt();
+        if (p < 2) { yCError(PATHPLAN_INIT) << "Invalid hpa_cluster_size parameter:" << p; return false; }
+        m_hpa_cluster_size = (size_t)p;
+    }
+    if (navigation_group.check("navigation_function_cache_size"))
+    {
+        double p = navigation_group.find("navigation_function_cache_size").asDouble();
+        if (p < 0) { yCError(PATHPLAN_INIT) << "Invalid navigation_function_cache_size parameter:" << p; return false; }
+        //the parameter is expressed in MB
+        m_navigation_function_cache.set_max_memory((size_t)(p * 1024 * 1024));
+        if (p > 0 && map_utilites::plannerAlgorithmIsOptimalGridSearch(m_planner_algorithm) == false)
+        {
+            yCWarning(PATHPLAN_INIT) << "navigation_function_cache_size is ignored by planner_algorithm" << map_utilites::plannerAlgorithmToString(m_planner_algorithm);
+        }
+    }
+    if (navigation_group.check("planning_time_budget")) { m_planning_time_budget = navigation_group.find("planning_time_budget").asDouble(); }
+    if (navigation_group.check("ara_initial_epsilon"))
+    {
+        double p = navigation_group.find("ara_initial_epsilon").asDouble();
+        if (p < 1) { yCError(PATHPLAN_INIT) << "Invalid ara_initial_epsilon parameter:" << p; return false; }
+        m_ara_parameters.initial_epsilon = p;
+    }
+    if (navigation_group.check("ara_epsilon_step"))
+    {
+        double p = navigation_group.find("ara_epsilon_step").asDouble();
+        if (p <= 0) { yCError(PATHPLAN_INIT) << "Invalid ara_epsilon_step parameter:" << p; return false; }
+        m_ara_parameters.epsilon_step = p;
+    }
+    if (navigation_group.check("pyramid_levels"))
+    {
+        int p = navigation_group.find("pyramid_levels").asInt();
+        if (p < 0) { yCError(PATHPLAN_INIT) << "Invalid pyramid_levels parameter:" << p; return false; }
+        m_pyramid_levels = (size_t)(p);
+        if (p > 0 && m_planner_algorithm != map_utilites::PLANNER_ASTAR_INDEXED)
+        {
+            yCWarning(PATHPLAN_INIT) << "pyramid_levels is ignored by planner_algorithm" << map_utilites::plannerAlgorithmToString(m_planner_algorithm);
+        }
+    }
+    if (navigation_group.check("pyramid_corridor_width"))
+    {
+        double p = navigation_group.find("pyramid_corridor_width").asDouble();
+        if (p <= 0) { yCError(PATHPLAN_INIT) << "Invalid pyramid_corridor_width parameter:" << p; return false; }
+        m_pyramid_corridor_width = p;
+    }
+    if (navigation_group.check("clearance_cost_weight")) { m_clearance_cost_weight = navigation_group.find("clearance_cost_weight").asDouble(); }
+    if (navigation_group.check("clearance_cost_distance")) { m_clearance_cost_distance = navigation_group.find("clearance_cost_distance").asDouble(); }
+    if (m_clearance_cost_weight > 0 && map_utilites::plannerAlgorithmSupportsCellCosts(m_planner_algorithm) == false)
+    {
+        yCWarning(PATHPLAN_INIT) << "clearance_cost_weight is ignored by planner_algorithm" << map_utilites::plannerAlgorithmToString(m_planner_algorithm);
+    }
     if (navigation_group.check("waypoint_max_lin_speed")) { m_waypoint_max_lin_speed = navigation_group.find("waypoint_max_lin_speed").asDouble(); }
     else { yCError(PATHPLAN_INIT) << "Missing waypoint_max_lin_speed parameter"; return false; }
     if (navigation_group.check("waypoint_max_ang_speed")) { m_waypoint_max_ang_speed = navigation_group.find("waypoint_max_ang_speed").asDouble(); }
@@ -119,6 +209,83 @@ bool PlannerThread::threadInit()
     else { yCError(PATHPLAN_INIT) << "Missing min_waypoint_distance parameter"; return false; }
     if (navigation_group.check("enable_try_recovery")) { m_enable_try_recovery = (navigation_group.find("enable_try_recovery").asInt() == 1); }
     else { yCError(PATHPLAN_INIT) << "Missing enable_try_recovery parameter"; return false; }
+    if (navigation_group.check("enable_path_monitoring")) { m_enable_path_monitoring = (navigation_group.find("enable_path_monitoring").asInt() == 1); }
+    if (navigation_group.check("enable_roadmap")) { m_enable_roadmap = (navigation_group.find("enable_roadmap").asInt() == 1); }
+    if (navigation_group.check("roadmap_directory")) { m_roadmap_builder.set_directory(navigation_group.find("roadmap_directory").asString()); }
+    if (navigation_group.check("roadmap_attach_distance"))
+    {
+        double p = navigation_group.find("roadmap_attach_distance").asDouble();
+        if (p <= 0) { yCError(PATHPLAN_INIT) << "Invalid roadmap_attach_distance parameter:" << p; return false; }
+        m_roadmap_attach_distance = p;
+    }
+    if (navigation_group.check("keep_out_areas"))
+    {
+        //the names of the areas of the map server which the robot must not enter
+        Bottle* areas = navigation_group.find("keep_out_areas").asList();
+        if (areas == nullptr) { yCError(PATHPLAN_INIT) << "Invalid keep_out_areas parameter"; return false; }
+        for (size_t i = 0; i < areas->size(); i++)
+        {
+            m_keep_out_areas.push_back(areas->get(i).asString());
+        }
+    }
+    if (navigation_group.check("roadmap_hubs"))
+    {
+        //a list of (x y) points, in the reference frame of the map
+        Bottle* hubs = navigation_group.find("roadmap_hubs").asList();
+        if (hubs == nullptr) { yCError(PATHPLAN_INIT) << "Invalid roadmap_hubs parameter"; return false; }
+        for (size_t i = 0; i < hubs->size(); i++)
+        {
+            Bottle* hub = hubs->get(i).asList();
+            if (hub == nullptr || hub->size() != 2) { yCError(PATHPLAN_INIT) << "Invalid roadmap_hubs parameter:" << hubs->get(i).toString(); return false; }
+            m_roadmap_hubs.push_back(yarp::math::Vec2D<double>(hub->get(0).asDouble(), hub->get(1).asDouble()));
+        }
+    }
+
+    //the default profiles, built from the parameters above
+    {
+        auto add_param = [](Bottle& profile, const std::string& name, double value) { Bottle& b = profile.addList(); b.addString(name); b.addDouble(value); };
+        Bottle& waypoint = m_controller_profiles["waypoint"];
+        add_param(waypoint, "linear_tol", m_waypoint_tolerance_lin);
+        add_param(waypoint, "angular_tol", m_waypoint_tolerance_ang);
+        add_param(waypoint, "max_lin_speed", m_waypoint_max_lin_speed);
+        add_param(waypoint, "max_ang_speed", m_waypoint_max_ang_speed);
+        add_param(waypoint, "min_lin_speed", m_waypoint_min_lin_speed);
+        add_param(waypoint, "min_ang_speed", m_waypoint_min_ang_speed);
+        add_param(waypoint, "ang_speed_gain", m_waypoint_ang_gain);
+        add_param(waypoint, "lin_speed_gain", m_waypoint_lin_gain);
+        Bottle& goal = m_controller_profiles["goal"];
+        add_param(goal, "linear_tol", m_goal_tolerance_lin);
+        add_param(goal, "angular_tol", m_goal_tolerance_ang);
+        add_param(goal, "max_lin_speed", m_goal_max_lin_speed);
+        add_param(goal, "max_ang_speed", m_goal_max_ang_speed);
+        add_param(goal, "min_lin_speed", m_goal_min_lin_speed);
+        add_param(goal, "min_ang_speed", m_goal_min_ang_speed);
+        add_param(goal, "ang_speed_gain", m_goal_ang_gain);
+        add_param(goal, "lin_speed_gain", m_goal_lin_gain);
+    }
+    //user-defined profiles, one per line: name ((param value) (param value) ...)
+    Bottle profiles_group = m_cfg.findGroup("CONTROLLER_PROFILES");
+    for (size_t i = 1; i < profiles_group.size(); i++)
+    {
+        Bottle* entry = profiles_group.get(i).asList();
+        if (entry == nullptr || entry->size() != 2 || entry->get(1).asList() == nullptr)
+        {
+            yCError(PATHPLAN_INIT) << "Invalid entry in CONTROLLER_PROFILES group:" << profiles_group.get(i).toString(); return false;
+        }
+        std::string name = entry->get(0).asString();
+        if (m_controller_profiles.count(name) > 0)
+        {
+            yCError(PATHPLAN_INIT) << "Controller profile" << name << "is already defined"; return false;
+        }
+        m_controller_profiles[name] = *(entry->get(1).asList());
+    }
+    if (navigation_group.check("waypoint_profile")) { m_waypoint_profile = navigation_group.find("waypoint_profile").asString(); }
+    if (navigation_group.check("goal_profile")) { m_goal_profile = navigation_group.find("goal_profile").asString(); }
+    if (m_controller_profiles.count(m_waypoint_profile) == 0 || m_controller_profiles.count(m_goal_profile) == 0)
+    {
+        yCError(PATHPLAN_INIT) << "Unknown controller profile:" << m_waypoint_profile << m_goal_profile; return false;
+    }
+    if (navigation_group.check("use_controller_profiles")) { m_use_controller_profiles = (navigation_group.find("use_controller_profiles").asInt() == 1); }
 
     Bottle general_group = m_cfg.findGroup("PATHPLANNER_GENERAL");
     if (general_group.isNull())
@@ -145,6 +312,14 @@ bool PlannerThread::threadInit()
     if (localization_group.check("localizationServer_name")) localizationServer_name = localization_group.find("localizationServer_name").asString();
     if (localization_group.check("mapServer_name")) mapServer_name = localization_group.find("mapServer_name").asString();
     if (general_group.check("name")) localName = general_group.find("name").asString();
+    double map_image_frequency = 0;
+    double map_image_crop = 0;
+    int    map_image_downscale = 1;
+    if (general_group.check("publish_map_image_Hz")) { map_image_frequency = general_group.find("publish_map_image_Hz").asDouble(); }
+    if (general_group.check("publish_map_image_crop")) { map_image_crop = general_group.find("publish_map_image_crop").asDouble(); }
+    if (general_group.check("publish_map_image_downscale")) { map_image_downscale = general_group.find("publish_map_image_downscale").asInt(); }
+    if (map_image_crop < 0) { yCError(PATHPLAN_INIT) << "Invalid publish_map_image_crop parameter:" << map_image_crop; return false; }
+    if (map_image_downscale < 1) { yCError(PATHPLAN_INIT) << "Invalid publish_map_image_downscale parameter:" << map_image_downscale; return false; }
     
     bool ff = geometry_group.check("robot_radius");
     ff &= geometry_group.check("laser_pos_x");
@@ -168,6 +343,7 @@ bool PlannerThread::threadInit()
     ret &= m_port_status_output.open((localName + "/plannerStatus:o").c_str());
     ret &= m_port_commands_output.open((localName + "/commands:o").c_str());
     ret &= m_port_map_output.open((localName + "/map:o").c_str());
+    m_map_image_publisher.configure(&m_port_map_output, map_image_frequency, map_image_crop, (size_t)map_image_downscale);
     if (ret == false)
     {
         yCError(PATHPLAN_INIT) << "Unable to open module ports";
@@ -301,11 +477,23 @@ bool PlannerThread::threadInit()
             return false;
         }
     }
+
+    //starts the thread which performs the path searches
+    m_planning_worker.setSolver([this](planning_request& request, const planner_search::search_control& control, planning_result& result)
+                                { return solvePlanningRequest(request, control, result); });
+    if (m_planning_worker.start() == false)
+    {
+        yCError(PATHPLAN_INIT) << "Unable to start the planning worker thread";
+        return false;
+    }
+    publishSnapshot();
     return true;
 }
 
 void PlannerThread :: threadRelease()
 {
+    m_planning_worker.stop();
+    m_roadmap_builder.stop();
     if (m_pLoc.isValid()) m_pLoc.close();
     if (m_ptf.isValid()) m_ptf.close();
     if (m_pLas.isValid()) m_pLas.close();
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <stdlib.h>
+#include <algorithm>
+#include "planningGrid.h"
+
+using namespace std;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+
+namespace
+{
+    //index of the lowest set bit of a non-zero word
+    inline int lowest_bit(uint64_t v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll(v);
+#else
+        int i = 0;
+        while ((v & 1) == 0) { v >>= 1; i++; }
+        return i;
+#endif
+    }
+
+    //index of the highest set bit of a non-zero word
+    inline int highest_bit(uint64_t v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(v);
+#else
+        int i = 63;
+        while ((v & (uint64_t(1) << 63)) == 0) { v <<= 1; i--; }
+        return i;
+#endif
+    }
+
+    //packs the even bits of a word (bits 0, 2, 4...) into the lower 32 bits
+    inline uint64_t compact_even_bits(uint64_t v)
+    {
+        v &= 0x5555555555555555ULL;
+        v = (v | (v >> 1))  & 0x3333333333333333ULL;
+        v = (v | (v >> 2))  & 0x0F0F0F0F0F0F0F0FULL;
+        v = (v | (v >> 4))  & 0x00FF00FF00FF00FFULL;
+        v = (v | (v >> 8))  & 0x0000FFFF0000FFFFULL;
+        v = (v | (v >> 16)) & 0x00000000FFFFFFFFULL;
+        return v;
+    }
+}
+
+planning_grid::planning_grid()
+{
+    m_width = 0;
+    m_height = 0;
+    m_words_per_row = 0;
+}
+
+void planning_grid::build(const MapGrid2D& map)
+{
+    m_width = map.width();
+    m_height = map.height();
+    m_words_per_row = (m_width + 63) / 64;
+    m_bits.assign(m_words_per_row * m_height, 0);
+    for (size_t y = 0; y < m_height; y++)
+    {
+        uint64_t* r = &m_bits[y * m_words_per_row];
+        for (size_t x = 0; x < m_width; x++)
+        {
+            if (map.isFree(XYCell(x, y))) r[x >> 6] |= (uint64_t(1) << (x & 63));
+        }
+    }
+}
+
+void planning_grid::reset(size_t width, size_t height)
+{
+    m_width = width;
+    m_height = height;
+    m_words_per_row = (m_width + 63) / 64;
+    m_bits.assign(m_words_per_row * m_height, 0);
+}
+
+void planning_grid::build_coarser(const planning_grid& finer)
+{
+    reset((finer.m_width + 1) / 2, (finer.m_height + 1) / 2);
+    for (size_t y = 0; y < m_height; y++)
+    {
+        //a missing second row (odd height) leaves the whole coarse row occupied
+        if (2 * y + 1 >= finer.m_height) continue;
+        const uint64_t* a = finer.row(2 * y);
+        const uint64_t* b = finer.row(2 * y + 1);
+        uint64_t* r = row(y);
+        for (size_t i = 0; i < finer.m_words_per_row; i++)
+        {
+            //bit 2j of v is set if the 2x2 block starting at the fine cell 2j is free. Each fine word produces 32 coarse cells.
+            uint64_t v = a[i] & b[i];
+            v &= (v >> 1);
+            r[i >> 1] |= compact_even_bits(v) << ((i & 1) * 32);
+        }
+    }
+}
+
+uint64_t planning_grid::bits_at(int x0, int y) const
+{
+    if (y < 0 || y >= (int)m_height) return 0;
+    if (x0 >= (int)m_width || x0 <= -64) return 0;
+    const uint64_t* r = row(y);
+
+    //the bits beyond the width of the map are always zero, so only the words before the row start need a check
+    uint64_t result;
+    if (x0 >= 0)
+    {
+        size_t word = (size_t)x0 >> 6;
+        int shift = x0 & 63;
+        result = r[word] >> shift;
+        if (shift != 0 && word + 1 < m_words_per_row) result |= r[word + 1] << (64 - shift);
+    }
+    else
+    {
+        result = r[0] << (-x0);
+    }
+    return result;
+}
+
+bool planning_grid::jump_horizontal(int x, int y, int dx, int gx, int gy, int& jx) const
+{
+    //a cell p is a jump point if, in the row above (or below), p is occupied and the next cell along the direction is free
+    if (dx > 0)
+    {
+        for (int p0 = x + 1; p0 < (int)m_width; p0 += 64)
+        {
+            uint64_t blocked = ~bits_at(p0, y);
+            uint64_t above = bits_at(p0, y - 1);
+            uint64_t below = bits_at(p0, y + 1);
+            uint64_t forced = (~above & bits_at(p0 + 1, y - 1)) | (~below & bits_at(p0 + 1, y + 1));
+            if (y == gy && gx >= p0 && gx < p0 + 64) forced |= uint64_t(1) << (gx - p0);
+            uint64_t stop = blocked | forced;
+            if (stop)
+            {
+                int i = lowest_bit(stop);
+                if ((blocked >> i) & 1) return false;
+                jx = p0 + i;
+                return true;
+            }
+        }
+        return false;
+    }
+    else
+    {
+        //the same scan, right to left: the word covers the cells p0-63 .. p0
+        for (int p0 = x - 1; p0 >= 0; p0 -= 64)
+        {
+            int base = p0 - 63;
+            uint64_t valid = (base >= 0) ? ~uint64_t(0) : (~uint64_t(0) << (-base));
+            uint64_t blocked = ~bits_at(base, y) & valid;
+            uint64_t above = bits_at(base, y - 1);
+            uint64_t below = bits_at(base, y + 1);
+            uint64_t forced = ((~above & bits_at(base - 1, y - 1)) | (~below & bits_at(base - 1, y + 1))) & valid;
+            if (y == gy && gx <= p0 && gx >= base) forced |= uint64_t(1) << (gx - base);
+            uint64_t stop = blocked | forced;
+            if (stop)
+            {
+                int i = highest_bit(stop);
+                if ((blocked >> i) & 1) return false;
+                jx = base + i;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+bool planning_grid::row_free(int x0, int x1, int y) const
+{
+    if (x0 > x1) std::swap(x0, x1);
+    if (x0 >= 0 && x1 < (int)m_width && y >= 0 && y < (int)m_height && (x0 >> 6) == (x1 >> 6))
+    {
+        //the most common case: the run lies inside a single word
+        uint64_t mask = ((~uint64_t(0)) >> (63 - (x1 - x0))) << (x0 & 63);
+        return (row(y)[x0 >> 6] & mask) == mask;
+    }
+    for (int x = x0; x <= x1; x += 64)
+    {
+        int count = x1 - x + 1;
+        uint64_t mask = (count >= 64) ? ~uint64_t(0) : ((uint64_t(1) << count) - 1);
+        if ((bits_at(x, y) & mask) != mask) return false;
+    }
+    return true;
+}
+
+bool planning_grid::line_of_sight(XYCell src, XYCell dst) const
+{
+    int x = (int)src.x;
+    int y = (int)src.y;
+    int tx = (int)dst.x;
+    int ty = (int)dst.y;
+    int dx = abs(tx - x);
+    int dy = abs(ty - y);
+    int sx = (x < tx) ? 1 : -1;
+    int sy = (y < ty) ? 1 : -1;
+    int err = dx - dy;
+
+    if (dy >= dx)
+    {
+        //steep line: each row contains one or two cells, they are tested one by one
+        while (x != tx || y != ty)
+        {
+            int e2 = err * 2;
+            if (e2 > -dy) { err -= dy; x += sx; }
+            if (e2 < dx)  { err += dx; y += sy; }
+            if (is_free(x, y) == false) return false;
+        }
+        return true;
+    }
+
+    //shallow line: the consecutive cells which lie on the same row are tested together
+    bool run_open = false;
+    int run_x0 = 0;
+    int run_x1 = 0;
+    int run_y = 0;
+    while (x != tx || y != ty)
+    {
+        int e2 = err * 2;
+        if (e2 > -dy) { err -= dy; x += sx; }
+        if (e2 < dx)  { err += dx; y += sy; }
+        if (run_open && y == run_y)
+        {
+            run_x1 = x;
+            continue;
+        }
+        if (run_open && row_free(run_x0, run_x1, run_y) == false) return false;
+        run_open = true;
+        run_x0 = x;
+        run_x1 = x;
+        run_y = y;
+    }
+    return (run_open == false || row_free(run_x0, run_x1, run_y));
+}
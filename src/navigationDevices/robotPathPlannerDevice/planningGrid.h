@@ -0,0 +1,156 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef PLANNING_GRID_H
+#define PLANNING_GRID_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace planner_search
+{
+    /**
+    * The traversability of a map, packed in 1 bit per cell (1 = free) in 64-bit words, row by row.
+    * Each row starts at a word boundary, so that a row can be scanned word by word: neighbor masks, line-of-sight checks
+    * and the horizontal jumps of JPS are computed with bit operations, reading 8 times less memory than the map itself.
+    * Cells outside the map are considered occupied.
+    */
+    class planning_grid
+    {
+        std::vector<uint64_t> m_bits;
+        size_t                m_width;
+        size_t                m_height;
+        size_t                m_words_per_row;
+
+        public:
+        planning_grid();
+
+        /**
+        * Packs the traversability (MapGrid2D::isFree()) of all the cells of a map.
+        * @param map the gridmap containing the obstacles
+        */
+        void build(const yarp::dev::Nav2D::MapGrid2D& map);
+
+        /**
+        * Builds a grid at half the resolution of another grid: a cell is free only if the 2x2 block of cells it covers is free
+        * (the cells beyond the border of the finer grid are considered occupied). The pooling is performed with word operations.
+        * @param finer the grid to be downsampled
+        */
+        void build_coarser(const planning_grid& finer);
+
+        /**
+        * Resizes the grid, marking all the cells as occupied. The cells can then be set through row().
+        */
+        void reset(size_t width, size_t height);
+
+        /**
+        * @return true if the grid has the same size of the given map
+        */
+        bool matches(const yarp::dev::Nav2D::MapGrid2D& map) const { return m_width == map.width() && m_height == map.height(); }
+
+        size_t width() const { return m_width; }
+        size_t height() const { return m_height; }
+        size_t words_per_row() const { return m_words_per_row; }
+
+        //the words of a row: cell x is the bit (x & 63) of the word (x >> 6)
+        const uint64_t* row(size_t y) const { return &m_bits[y * m_words_per_row]; }
+        uint64_t*       row(size_t y) { return &m_bits[y * m_words_per_row]; }
+
+        bool is_free(int x, int y) const
+        {
+            if (x < 0 || y < 0 || x >= (int)m_width || y >= (int)m_height) return false;
+            return (m_bits[y * m_words_per_row + (x >> 6)] >> (x & 63)) & 1;
+        }
+
+        /**
+        * Returns the traversability of 64 consecutive cells of a row.
+        * @return a word whose bit i is set if the cell (x0 + i, y) is free
+        */
+        uint64_t bits_at(int x0, int y) const;
+
+        /**
+        * @return true if all the cells of the row y between x0 and x1 (both included) are free
+        */
+        bool row_free(int x0, int x1, int y) const;
+
+        /**
+        * Returns the traversability of the 3x3 block centered on a cell.
+        * @return a mask whose bit (dy + 1) * 3 + (dx + 1) is set if the cell (x + dx, y + dy) is free
+        */
+        unsigned int neighbor_mask(int x, int y) const
+        {
+            return  (unsigned int)(bits_at(x - 1, y - 1) & 7)       |
+                   ((unsigned int)(bits_at(x - 1, y)     & 7) << 3) |
+                   ((unsigned int)(bits_at(x - 1, y + 1) & 7) << 6);
+        }
+
+        /**
+        * Moves from (x,y) along the row, in the direction dx (+1 or -1), until a jump point of the Jump Point Search is found,
+        * i.e. a cell with a forced neighbor or the goal cell. 64 cells are tested with each group of word operations.
+        * @param gx the x coordinate of the goal cell
+        * @param gy the y coordinate of the goal cell
+        * @param jx the x coordinate of the jump point (the y coordinate does not change)
+        * @return false if the row is blocked by an obstacle (or by the border of the map) before a jump point is found
+        */
+        bool jump_horizontal(int x, int y, int dx, int gx, int gy, int& jx) const;
+
+        /**
+        * Returns true if the straight line which connects src with dst does not contain any obstacle.
+        * The cells are traversed with the Bresenham algorithm (as thetaStar_algorithm::line_of_sight()), the src cell is not checked.
+        * The consecutive cells of the line which lie on the same row are tested together, with row_free().
+        */
+        bool line_of_sight(yarp::dev::Nav2D::XYCell src, yarp::dev::Nav2D::XYCell dst) const;
+    };
+
+    /**
+    * Exposes a MapGrid2D with the same interface of planning_grid used by the search algorithms (width(), height(), is_free(), neighbor_mask()),
+    * so that the searches can run on the map when the packed grid is not available.
+    */
+    class map_grid_view
+    {
+        const yarp::dev::Nav2D::MapGrid2D& m_map;
+        int                                m_width;
+        int                                m_height;
+
+        public:
+        map_grid_view(const yarp::dev::Nav2D::MapGrid2D& map) : m_map(map), m_width((int)map.width()), m_height((int)map.height()) {}
+
+        size_t width() const { return (size_t)m_width; }
+        size_t height() const { return (size_t)m_height; }
+
+        bool is_free(int x, int y) const
+        {
+            if (x < 0 || y < 0 || x >= m_width || y >= m_height) return false;
+            return m_map.isFree(yarp::dev::Nav2D::XYCell(x, y));
+        }
+
+        unsigned int neighbor_mask(int x, int y) const
+        {
+            unsigned int mask = 0;
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if (is_free(x + dx, y + dy)) mask |= 1u << ((dy + 1) * 3 + (dx + 1));
+            return mask;
+        }
+    };
+};
+
+#endif
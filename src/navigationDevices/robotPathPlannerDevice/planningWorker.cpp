@@ -0,0 +1,157 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include "planningWorker.h"
+#include "aStarIndexed.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+
+YARP_LOG_COMPONENT(PATHPLAN_WORKER, "navigation.devices.robotPathPlanner.worker")
+
+PlanningWorker::PlanningWorker()
+{
+    m_result_available = false;
+    m_last_id = 0;
+    m_busy = false;
+    m_request_start_time = 0;
+}
+
+void PlanningWorker::setSolver(solver_type solver)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_solver = solver;
+}
+
+size_t PlanningWorker::submit(planning_request& request)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    request.id = ++m_last_id;
+    m_pending_request.reset(new planning_request(request));
+    m_result_available = false;
+    m_control.cancel();
+    m_cond.notify_one();
+    return request.id;
+}
+
+void PlanningWorker::cancel()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    //the id is incremented so that the result of the request in progress is discarded
+    m_last_id++;
+    m_pending_request.reset();
+    m_result_available = false;
+    m_control.cancel();
+}
+
+void PlanningWorker::publishIntermediateResult(planning_request& request, planning_result& result)
+{
+    if (result.simplified_path.size() == 0)
+    {
+        map_utilites::simplifyPath(request.map, result.path, result.simplified_path);
+    }
+    result.id = request.id;
+    result.outcome = PLANNING_SUCCEEDED;
+    result.final_result = false;
+    result.elapsed_time = yarp::os::Time::now() - m_request_start_time;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (result.id != m_last_id) return;
+    m_result = result;
+    m_result_available = true;
+}
+
+bool PlanningWorker::getResult(planning_result& result)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_result_available == false) return false;
+    result = m_result;
+    m_result_available = false;
+    return true;
+}
+
+bool PlanningWorker::isBusy()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_busy || m_pending_request;
+}
+
+void PlanningWorker::onStop()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_control.cancel();
+    m_cond.notify_one();
+}
+
+void PlanningWorker::run()
+{
+    //the searches which use the default workspace can be interrupted from the other threads
+    aStarIndexed_algorithm::default_workspace().control = &m_control;
+
+    while (!isStopping())
+    {
+        std::unique_ptr<planning_request> request;
+        solver_type solver;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this] { return isStopping() || m_pending_request; });
+            if (isStopping()) break;
+            request = std::move(m_pending_request);
+            solver = m_solver;
+            m_control.start(request->time_budget);
+            m_busy = true;
+        }
+
+        planning_result result;
+        result.id = request->id;
+        m_request_start_time = yarp::os::Time::now();
+        bool found = solver && solver(*request, m_control, result);
+        if (found)
+        {
+            result.outcome = PLANNING_SUCCEEDED;
+            if (result.simplified_path.size() == 0)
+            {
+                map_utilites::simplifyPath(request->map, result.path, result.simplified_path);
+            }
+        }
+        else if (m_control.is_cancelled()) { result.outcome = PLANNING_CANCELLED; }
+        else if (m_control.is_expired())   { result.outcome = PLANNING_TIMEOUT; }
+        else                               { result.outcome = PLANNING_NO_PATH; }
+        result.elapsed_time = yarp::os::Time::now() - m_request_start_time;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy = false;
+        if (result.id == m_last_id)
+        {
+            m_result = result;
+            m_result_available = true;
+        }
+        else
+        {
+            yCDebug(PATHPLAN_WORKER) << "Discarding the result of the outdated request" << result.id;
+        }
+    }
+
+    aStarIndexed_algorithm::default_workspace().control = nullptr;
+}
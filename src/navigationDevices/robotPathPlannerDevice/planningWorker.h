@@ -0,0 +1,143 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef PLANNING_WORKER_H
+#define PLANNING_WORKER_H
+
+#include <yarp/os/Thread.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/dev/Map2DPath.h>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include "map.h"
+#include "hpaStar.h"
+#include "searchWorkspace.h"
+#include "planningGrid.h"
+#include "multiResolution.h"
+
+//a path planning query, processed by PlanningWorker
+struct planning_request
+{
+    size_t                                                   id;
+    //a copy of the map, so that the worker never reads a map which is being modified by the control thread
+    yarp::dev::Nav2D::MapGrid2D                              map;
+    bool                                                     transient_obstacles; //the map contains the obstacles detected by the laser, which must not be cached
+    std::shared_ptr<const hpaStar_algorithm::abstract_graph> abstract_graph;
+    std::shared_ptr<const std::vector<float> >               cell_costs;
+    std::shared_ptr<const planner_search::planning_grid>     planning_grid;
+    std::shared_ptr<const multiResolution_algorithm::planning_pyramid> pyramid;
+    size_t                                                   pyramid_corridor_radius; //cells
+    double                                                   inflation_radius; //m, the radius used to enlarge the obstacles of the map
+    map_utilites::planner_algorithm_type                     algorithm;
+    yarp::dev::Nav2D::XYCell                                 start;
+    yarp::dev::Nav2D::XYCell                                 goal;
+    double                                                   time_budget;  //s, <=0 means no limit
+};
+
+enum planning_outcome_type
+{
+    PLANNING_SUCCEEDED = 0,
+    PLANNING_NO_PATH   = 1,
+    PLANNING_CANCELLED = 2,
+    PLANNING_TIMEOUT   = 3
+};
+
+struct planning_result
+{
+    size_t                           id;
+    planning_outcome_type            outcome;
+    yarp::dev::Nav2D::Map2DPath      path;
+    yarp::dev::Nav2D::Map2DPath      simplified_path;
+    double                           elapsed_time; //s
+    double                           epsilon;      //suboptimality bound of the path computed by an anytime search (1 for the other searches)
+    bool                             final_result; //false if the search is still improving the path (anytime searches only)
+
+    planning_result() : id(0), outcome(PLANNING_NO_PATH), elapsed_time(0), epsilon(1.0), final_result(true) {}
+};
+
+/**
+* A thread which computes the paths requested by the PlannerThread, so that a long search never blocks the control loop.
+* Only the most recent request is relevant: submitting a new request cancels the one in progress (if any) and replaces
+* the one waiting to be processed. The searches performed through the thread-local workspace of aStarIndexed_algorithm
+* (and the ones using the search_control passed to the solver) are interrupted on cancel() or when the time budget expires.
+* An anytime search can publish each path it finds through publishIntermediateResult(), before the final result is available.
+*/
+class PlanningWorker : public yarp::os::Thread
+{
+    public:
+    //the solver fills the path and, optionally, the simplified path and the epsilon of the result. If the simplified path is left empty, it is computed by the worker
+    typedef std::function<bool(planning_request&, const planner_search::search_control&, planning_result&)> solver_type;
+
+    private:
+    solver_type                        m_solver;
+    std::mutex                         m_mutex;
+    std::condition_variable            m_cond;
+    std::unique_ptr<planning_request>  m_pending_request;
+    bool                               m_result_available;
+    planning_result                    m_result;
+    size_t                             m_last_id;
+    bool                               m_busy;
+    planner_search::search_control     m_control;
+    double                             m_request_start_time;
+
+    public:
+    PlanningWorker();
+
+    /**
+    * Sets the function which performs the search. It is executed by the worker thread.
+    */
+    void   setSolver(solver_type solver);
+
+    /**
+    * Queues a new request, cancelling the previous one.
+    * @param request the query. Its id is assigned by this method.
+    * @return the id assigned to the request
+    */
+    size_t submit(planning_request& request);
+
+    /**
+    * Cancels the request in progress and the queued one, if any.
+    */
+    void   cancel();
+
+    /**
+    * Makes available a path found by an anytime search while the search continues. To be called by the solver (i.e. by the worker thread).
+    * The result is discarded if the request has been cancelled or replaced in the meantime.
+    * @param request the request being processed
+    * @param result the path (and, optionally, the simplified path) and its epsilon. The other fields are set by this method.
+    */
+    void   publishIntermediateResult(planning_request& request, planning_result& result);
+
+    /**
+    * Retrieves the result of the most recent request, if available. The result is removed from the worker.
+    * @return true if a result was available
+    */
+    bool   getResult(planning_result& result);
+
+    /**
+    * @return true if a request is being processed or is waiting to be processed
+    */
+    bool   isBusy();
+
+    virtual void run() override;
+    virtual void onStop() override;
+};
+
+#endif
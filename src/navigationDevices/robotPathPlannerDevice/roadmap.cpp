@@ -0,0 +1,353 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <limits>
+#include <math.h>
+#include <stdio.h>
+#include "roadmap.h"
+#include "navigationFunction.h"
+#include "map.h"
+
+using namespace std;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+using namespace roadmap_algorithm;
+
+YARP_LOG_COMPONENT(PATHPLAN_ROADMAP, "navigation.devices.robotPathPlanner.roadmap")
+
+namespace
+{
+    const int ROADMAP_FILE_VERSION = 1;
+
+    double cell_distance(const XYCell& a, const XYCell& b)
+    {
+        double dx = (double)a.x - (double)b.x;
+        double dy = (double)a.y - (double)b.y;
+        return sqrt(dx * dx + dy * dy);
+    }
+
+    bool same_cell(const XYCell& a, const XYCell& b)
+    {
+        return a.x == b.x && a.y == b.y;
+    }
+
+    //greedy simplification of a chain of cells starting from 'from'. Unlike map_utilites::simplifyPath, every
+    //output segment is guaranteed to pass checkStraightLine(), so that routes can be re-validated segment by segment
+    void simplify_cells(MapGrid2D& map, XYCell from, const std::deque<XYCell>& cells, std::vector<XYCell>& output)
+    {
+        size_t i = 0;
+        while (i < cells.size())
+        {
+            size_t best = i;
+            for (size_t j = cells.size(); j-- > i + 1; )
+            {
+                if (map_utilites::checkStraightLine(map, from, cells[j])) { best = j; break; }
+            }
+            output.push_back(cells[best]);
+            from = cells[best];
+            i = best + 1;
+        }
+    }
+}
+
+/////////// roadmap
+roadmap::roadmap()
+{
+    map_hash = 0;
+    width = 0;
+    height = 0;
+    build_time = 0;
+}
+
+bool roadmap::build(MapGrid2D& map, uint64_t hash, const std::vector<roadmap_node>& new_nodes, search_workspace& workspace)
+{
+    double t1 = yarp::os::Time::now();
+    map_name = map.getMapName();
+    map_hash = hash;
+    width = map.width();
+    height = map.height();
+    nodes = new_nodes;
+    size_t n = nodes.size();
+    costs.assign(n * n, std::numeric_limits<float>::infinity());
+    waypoints.assign(n * n, std::vector<XYCell>());
+
+    navigationFunction_algorithm::cost_to_go_field field;
+    for (size_t to = 0; to < n; to++)
+    {
+        costs[to * n + to] = 0;
+        if (field.compute(map, nodes[to].cell, 0, nullptr, workspace) == false)
+        {
+            if (workspace.control && workspace.control->should_stop()) return false;
+            yCWarning(PATHPLAN_ROADMAP) << "Roadmap node" << nodes[to].name << "is not a free cell of map" << map_name << ", it cannot be reached";
+            continue;
+        }
+        for (size_t from = 0; from < n; from++)
+        {
+            const XYCell& c = nodes[from].cell;
+            if (from == to || c.x >= width || c.y >= height) continue;
+            float cost = field.cost[c.y * width + c.x];
+            if (std::isinf(cost)) continue;
+
+            std::deque<XYCell> cell_path;
+            if (field.extract_path(map, c, cell_path) == false) continue;
+            std::vector<XYCell>& route = waypoints[from * n + to];
+            simplify_cells(map, c, cell_path, route);
+            //the route always terminates on the node itself
+            if (route.empty() || same_cell(route.back(), nodes[to].cell) == false) route.push_back(nodes[to].cell);
+            costs[from * n + to] = cost;
+        }
+    }
+    build_time = yarp::os::Time::now() - t1;
+    return true;
+}
+
+bool roadmap::save(const std::string& filename) const
+{
+    std::ofstream file(filename.c_str());
+    if (!file.is_open()) return false;
+
+    size_t n = nodes.size();
+    file << "roadmap " << ROADMAP_FILE_VERSION << "\n";
+    file << map_name << "\n";
+    file << map_hash << " " << width << " " << height << " " << n << "\n";
+    for (auto it = nodes.begin(); it != nodes.end(); it++)
+    {
+        file << it->cell.x << " " << it->cell.y << " " << it->name << "\n";
+    }
+    for (size_t from = 0; from < n; from++)
+        for (size_t to = 0; to < n; to++)
+        {
+            float cost = costs[from * n + to];
+            if (from == to || std::isinf(cost)) continue;
+            const std::vector<XYCell>& route = waypoints[from * n + to];
+            file << from << " " << to << " " << cost << " " << route.size();
+            for (auto it = route.begin(); it != route.end(); it++)
+            {
+                file << " " << it->x << " " << it->y;
+            }
+            file << "\n";
+        }
+    return file.good();
+}
+
+bool roadmap::load(const std::string& filename)
+{
+    std::ifstream file(filename.c_str());
+    if (!file.is_open()) return false;
+
+    std::string line;
+    std::string tag;
+    int version = 0;
+    if (!std::getline(file, line)) return false;
+    std::istringstream(line) >> tag >> version;
+    if (tag != "roadmap" || version != ROADMAP_FILE_VERSION) return false;
+    if (!std::getline(file, map_name)) return false;
+
+    size_t n = 0;
+    if (!std::getline(file, line)) return false;
+    std::istringstream header(line);
+    if (!(header >> map_hash >> width >> height >> n)) return false;
+
+    nodes.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (!std::getline(file, line)) return false;
+        std::istringstream node_line(line);
+        size_t x = 0;
+        size_t y = 0;
+        if (!(node_line >> x >> y)) return false;
+        node_line.get();
+        std::getline(node_line, nodes[i].name);
+        nodes[i].cell = XYCell(x, y);
+    }
+
+    costs.assign(n * n, std::numeric_limits<float>::infinity());
+    waypoints.assign(n * n, std::vector<XYCell>());
+    for (size_t i = 0; i < n; i++) costs[i * n + i] = 0;
+    while (std::getline(file, line))
+    {
+        std::istringstream edge_line(line);
+        size_t from = 0;
+        size_t to = 0;
+        float cost = 0;
+        size_t k = 0;
+        if (!(edge_line >> from >> to >> cost >> k) || from >= n || to >= n) return false;
+        std::vector<XYCell>& route = waypoints[from * n + to];
+        for (size_t i = 0; i < k; i++)
+        {
+            size_t x = 0;
+            size_t y = 0;
+            if (!(edge_line >> x >> y)) return false;
+            route.push_back(XYCell(x, y));
+        }
+        costs[from * n + to] = cost;
+    }
+    build_time = 0;
+    return true;
+}
+
+bool roadmap::find_route(MapGrid2D& map, XYCell start, XYCell goal, double attach_distance, std::vector<XYCell>& route) const
+{
+    route.clear();
+    if (map.width() != width || map.height() != height) return false;
+
+    //the nodes to which the start and the goal can be connected with a straight line. The cost of a straight line
+    //is expressed in the same units of the costs of the roadmap (10 for each cell)
+    size_t n = nodes.size();
+    std::vector<std::pair<size_t, double> > start_nodes;
+    std::vector<std::pair<size_t, double> > goal_nodes;
+    for (size_t i = 0; i < n; i++)
+    {
+        double ds = cell_distance(start, nodes[i].cell);
+        if (ds <= attach_distance && map_utilites::checkStraightLine(map, start, nodes[i].cell)) start_nodes.push_back(std::make_pair(i, ds * 10));
+        double dg = cell_distance(goal, nodes[i].cell);
+        if (dg <= attach_distance && map_utilites::checkStraightLine(map, nodes[i].cell, goal)) goal_nodes.push_back(std::make_pair(i, dg * 10));
+    }
+
+    struct candidate
+    {
+        double cost;
+        size_t a;
+        size_t b;
+        bool operator<(const candidate& other) const { return cost < other.cost; }
+    };
+    std::vector<candidate> candidates;
+    for (auto s = start_nodes.begin(); s != start_nodes.end(); s++)
+        for (auto g = goal_nodes.begin(); g != goal_nodes.end(); g++)
+        {
+            float edge_cost = costs[s->first * n + g->first];
+            if (std::isinf(edge_cost)) continue;
+            candidate c;
+            c.cost = s->second + edge_cost + g->second;
+            c.a = s->first;
+            c.b = g->first;
+            candidates.push_back(c);
+        }
+    std::sort(candidates.begin(), candidates.end());
+
+    //the precomputed paths are checked only now, against the current obstacles
+    for (auto c = candidates.begin(); c != candidates.end(); c++)
+    {
+        const std::vector<XYCell>& edge = waypoints[c->a * n + c->b];
+        XYCell prev = nodes[c->a].cell;
+        bool valid = true;
+        for (auto it = edge.begin(); valid && it != edge.end(); it++)
+        {
+            valid = map_utilites::checkStraightLine(map, prev, *it);
+            prev = *it;
+        }
+        if (!valid) continue;
+
+        if (same_cell(start, nodes[c->a].cell) == false) route.push_back(nodes[c->a].cell);
+        route.insert(route.end(), edge.begin(), edge.end());
+        if (same_cell(goal, nodes[c->b].cell) == false) route.push_back(goal);
+        return true;
+    }
+    return false;
+}
+
+std::string roadmap_algorithm::roadmap_filename(const std::string& directory, uint64_t map_hash)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "roadmap_%016llx.txt", (unsigned long long)map_hash);
+    if (directory.empty()) return std::string(name);
+    return directory + "/" + name;
+}
+
+/////////// roadmap_builder
+roadmap_builder::roadmap_builder()
+{
+    m_map_hash = 0;
+}
+
+void roadmap_builder::set_directory(const std::string& directory)
+{
+    m_directory = directory;
+}
+
+void roadmap_builder::update(const MapGrid2D& map, uint64_t map_hash, const std::vector<roadmap_node>& nodes)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_roadmap && m_roadmap->matches(map_hash, nodes)) return;
+    }
+    //m_map, m_map_hash and m_nodes are modified only here, while the thread is not running
+    if (isRunning() && m_map_hash == map_hash && m_nodes == nodes) return;
+    stop();
+    m_map = map;
+    m_map_hash = map_hash;
+    m_nodes = nodes;
+
+    if (m_directory.empty() == false)
+    {
+        std::shared_ptr<roadmap> stored = std::make_shared<roadmap>();
+        std::string filename = roadmap_filename(m_directory, map_hash);
+        if (stored->load(filename) && stored->matches(map_hash, nodes))
+        {
+            yCInfo(PATHPLAN_ROADMAP) << "Roadmap of map" << map.getMapName() << "loaded from" << filename;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_roadmap = stored;
+            return;
+        }
+    }
+    yCInfo(PATHPLAN_ROADMAP) << "Building the roadmap of map" << map.getMapName() << "(" << nodes.size() << "nodes) in background";
+    m_control.start(0);
+    start();
+}
+
+std::shared_ptr<const roadmap> roadmap_builder::get(uint64_t map_hash)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_roadmap && m_roadmap->map_hash == map_hash) return m_roadmap;
+    return nullptr;
+}
+
+void roadmap_builder::run()
+{
+    std::shared_ptr<roadmap> built = std::make_shared<roadmap>();
+    search_workspace workspace;
+    workspace.control = &m_control;
+    if (built->build(m_map, m_map_hash, m_nodes, workspace) == false)
+    {
+        yCDebug(PATHPLAN_ROADMAP) << "The construction of the roadmap of map" << m_map.getMapName() << "has been interrupted";
+        return;
+    }
+    yCInfo(PATHPLAN_ROADMAP) << "Roadmap of map" << built->map_name << "built:" << built->nodes.size() << "nodes," << built->build_time << "s";
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_roadmap = built;
+    }
+    if (m_directory.empty() == false)
+    {
+        std::string filename = roadmap_filename(m_directory, m_map_hash);
+        if (built->save(filename)) { yCInfo(PATHPLAN_ROADMAP) << "Roadmap saved to" << filename; }
+        else                       { yCWarning(PATHPLAN_ROADMAP) << "Unable to save the roadmap to" << filename; }
+    }
+}
+
+void roadmap_builder::onStop()
+{
+    m_control.cancel();
+}
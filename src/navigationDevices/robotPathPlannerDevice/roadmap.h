@@ -0,0 +1,142 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef ROADMAP_H
+#define ROADMAP_H
+
+#include <yarp/os/Thread.h>
+#include <yarp/dev/MapGrid2D.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "searchWorkspace.h"
+
+//! namespace containing the roadmap: the paths between the named locations of a map, computed in advance
+namespace roadmap_algorithm
+{
+    //a node of the roadmap: a named location (or a hub waypoint) of the map
+    struct roadmap_node
+    {
+        std::string              name;
+        yarp::dev::Nav2D::XYCell cell;
+
+        bool operator==(const roadmap_node& other) const { return name == other.name && cell.x == other.cell.x && cell.y == other.cell.y; }
+    };
+
+    /**
+    * The simplified paths (and their costs) between every ordered pair of nodes of a map. The costs are the same of
+    * aStarIndexed_algorithm::find_astar_path() (10 for straight moves, 14 for diagonal moves).
+    * The roadmap is valid only for the map it was built on, identified by its hash (see hpaStar_algorithm::compute_map_hash()).
+    */
+    class roadmap
+    {
+        public:
+        std::string                                        map_name;
+        uint64_t                                           map_hash;
+        size_t                                             width;
+        size_t                                             height;
+        std::vector<roadmap_node>                          nodes;
+        std::vector<float>                                 costs;      //n*n elements, [from*n+to], infinity if 'to' cannot be reached
+        std::vector<std::vector<yarp::dev::Nav2D::XYCell> > waypoints;  //n*n elements, the simplified path from 'from' (excluded) to 'to' (included)
+        double                                             build_time;
+
+        roadmap();
+
+        /**
+        * Computes the paths between all the nodes: a cost-to-go field is computed for each node, then the paths
+        * from all the other nodes are extracted from it and simplified. The cost is proportional to (number of nodes) x (map size).
+        * @param map the gridmap containing the obstacles
+        * @param map_hash the hash of the map, stored as the key of the roadmap
+        * @param nodes the nodes of the roadmap
+        * @param workspace the search memory. The construction can be interrupted through workspace.control.
+        * @return false if the construction has been interrupted
+        */
+        bool build(yarp::dev::Nav2D::MapGrid2D& map, uint64_t map_hash, const std::vector<roadmap_node>& nodes, planner_search::search_workspace& workspace);
+
+        bool save(const std::string& filename) const;
+        bool load(const std::string& filename);
+
+        bool matches(uint64_t hash, const std::vector<roadmap_node>& other_nodes) const { return map_hash == hash && nodes == other_nodes; }
+
+        /**
+        * Composes a path from a start cell to a goal cell using the roadmap. The start (goal) cell is connected to the nodes which
+        * are visible from it with a straight line and closer than attach_distance. Among the possible routes, the cheapest one
+        * whose segments are all free in the given map is returned.
+        * @param map the gridmap used to validate the route (e.g. the static map plus the temporary obstacles)
+        * @param start the start cell(x,y)
+        * @param goal the arrival cell(x,y)
+        * @param attach_distance the maximum distance (cells) between the start (goal) cell and the first (last) node of the route
+        * @param route the sequence of waypoints (start excluded, goal included)
+        * @return true if a valid route has been found
+        */
+        bool find_route(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, double attach_distance, std::vector<yarp::dev::Nav2D::XYCell>& route) const;
+    };
+
+    /**
+    * The name of the file which stores the roadmap of a map.
+    */
+    std::string roadmap_filename(const std::string& directory, uint64_t map_hash);
+
+    /**
+    * A thread which builds the roadmap of the current map in background, so that the control loop is never blocked.
+    * A roadmap is loaded from its file (if available and built for the same nodes) instead of being computed, and
+    * each computed roadmap is saved to its file.
+    */
+    class roadmap_builder : public yarp::os::Thread
+    {
+        std::mutex                           m_mutex;
+        std::shared_ptr<const roadmap>       m_roadmap;
+        yarp::dev::Nav2D::MapGrid2D          m_map;
+        uint64_t                             m_map_hash;
+        std::vector<roadmap_node>            m_nodes;
+        std::string                          m_directory;
+        planner_search::search_control       m_control;
+
+        public:
+        roadmap_builder();
+
+        /**
+        * Sets the directory where the roadmaps are stored. An empty string disables the persistence.
+        */
+        void set_directory(const std::string& directory);
+
+        /**
+        * Requests the roadmap of a map. The call returns immediately: if the roadmap is not already available (or being built)
+        * it is loaded from its file, or its construction is started in background.
+        * @param map the gridmap containing the obstacles
+        * @param map_hash the hash of the map
+        * @param nodes the nodes of the roadmap
+        */
+        void update(const yarp::dev::Nav2D::MapGrid2D& map, uint64_t map_hash, const std::vector<roadmap_node>& nodes);
+
+        /**
+        * Returns the roadmap of a map, if it has been built.
+        * @param map_hash the hash of the map
+        * @return the roadmap, or nullptr if it is not available (yet)
+        */
+        std::shared_ptr<const roadmap> get(uint64_t map_hash);
+
+        virtual void run() override;
+        virtual void onStop() override;
+    };
+};
+
+#endif
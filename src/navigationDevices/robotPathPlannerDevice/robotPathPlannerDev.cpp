@@ -111,6 +111,7 @@ bool robotPathPlannerDev::read(yarp::os::ConnectionReader& connection)
             reply.addVocab(Vocab::encode("many"));
             reply.addString("set_robot_radius <size_m>");
             reply.addString("get_robot_radius");
+            reply.addString("get_map_update <global|local> <last_seen_epoch> <last_seen_version>");
         }
         else if (command.get(0).isString())
         {
@@ -136,9 +137,12 @@ bool robotPathPlannerDev::read(yarp::os::ConnectionReader& connection)
 bool robotPathPlannerDev::gotoTargetByAbsoluteLocation(Map2DLocation loc)
 {
     bool b = true;
+    //the reload may rebuild the map and the planning structures used by the control loop
+    m_plannerThread->m_mutex.wait();
     b &= m_plannerThread->reloadCurrentMap();
     b &= m_plannerThread->setNewAbsTarget(loc);
     m_plannerThread->resetAttemptCounter();
+    m_plannerThread->m_mutex.post();
     return b;
 }
 
@@ -149,15 +153,19 @@ bool robotPathPlannerDev::gotoTargetByRelativeLocation(double x, double y, doubl
     v.push_back(y);
     v.push_back(theta);
     bool b = true;
+    m_plannerThread->m_mutex.wait();
     b &= m_plannerThread->reloadCurrentMap();
     b &= m_plannerThread->setNewRelTarget(v);
     m_plannerThread->resetAttemptCounter();
+    m_plannerThread->m_mutex.post();
     return b;
 }
 
 bool robotPathPlannerDev::recomputeCurrentNavigationPath()
 {
+    m_plannerThread->m_mutex.wait();
     bool b= m_plannerThread->recomputePath();
+    m_plannerThread->m_mutex.post();
     if (b==false)
     {
         yCError(PATHPLAN_DEV) << "robotPathPlannerDev::recomputeCurrentNavigationPath(). An error occurred while performing the requested operation.";
@@ -172,9 +180,11 @@ bool robotPathPlannerDev::gotoTargetByRelativeLocation(double x, double y)
     v.push_back(x);
     v.push_back(y);
     bool b = true;
+    m_plannerThread->m_mutex.wait();
     b &= m_plannerThread->reloadCurrentMap();
     b &= m_plannerThread->setNewRelTarget(v);
     m_plannerThread->resetAttemptCounter();
+    m_plannerThread->m_mutex.post();
     return b;
 }
 
@@ -184,16 +194,36 @@ bool robotPathPlannerDev::applyVelocityCommand(double x_vel, double y_vel, doubl
     return true;
 }
 
+//the following getters read the snapshot published by the planner thread, so they never wait for its control loop
 bool robotPathPlannerDev::getAbsoluteLocationOfCurrentTarget(Map2DLocation& target)
 {
-    m_plannerThread->getCurrentAbsTarget(target);
+    std::shared_ptr<const planner_snapshot> snapshot = m_plannerThread->getSnapshot();
+    if (!snapshot) return false;
+    if (snapshot->target_valid == false)
+    {
+        target.map_id = "invalid";
+        yCError(PATHPLAN_DEV) << "No valid target has been set yet.";
+        return true;
+    }
+    target = snapshot->current_target;
     return true;
 }
 
 bool robotPathPlannerDev::getRelativeLocationOfCurrentTarget(double& x, double& y, double& theta)
 {
+    std::shared_ptr<const planner_snapshot> snapshot = m_plannerThread->getSnapshot();
+    if (!snapshot) return false;
     Map2DLocation loc;
-    m_plannerThread->getCurrentRelTarget(loc);
+    if (snapshot->target_valid)
+    {
+        loc.x = snapshot->current_target.x - snapshot->robot.x;
+        loc.y = snapshot->current_target.y - snapshot->robot.y;
+        loc.theta = snapshot->current_target.theta - snapshot->robot.theta;
+    }
+    else
+    {
+        yCError(PATHPLAN_DEV) << "No valid target has been set yet.";
+    }
     x=loc.x;
     y=loc.y;
     theta=loc.theta;
@@ -202,46 +232,60 @@ bool robotPathPlannerDev::getRelativeLocationOfCurrentTarget(double& x, double&
 
 bool robotPathPlannerDev::getNavigationStatus(NavigationStatusEnum& status)
 {
-     int nav_status = m_plannerThread->getNavigationStatusAsInt();
-     status = (NavigationStatusEnum)(nav_status);
+     std::shared_ptr<const planner_snapshot> snapshot = m_plannerThread->getSnapshot();
+     if (!snapshot) return false;
+     status = snapshot->status;
      return true;
 }
 
 bool robotPathPlannerDev::stopNavigation()
 {
+     //the planner thread publishes a snapshot of the path and of the map, which are modified by the control loop
+     m_plannerThread->m_mutex.wait();
      bool b = m_plannerThread->stopMovement();
+     m_plannerThread->m_mutex.post();
      return true;
 }
 
 bool robotPathPlannerDev::suspendNavigation(double time)
 {
+     m_plannerThread->m_mutex.wait();
      bool b = m_plannerThread->pauseMovement(time);
+     m_plannerThread->m_mutex.post();
      return b;
 }
 
 bool robotPathPlannerDev::resumeNavigation()
 {
+     m_plannerThread->m_mutex.wait();
      bool b = m_plannerThread->resumeMovement();
+     m_plannerThread->m_mutex.post();
      return b;
 }
 
 bool robotPathPlannerDev::getAllNavigationWaypoints(yarp::dev::Nav2D::TrajectoryTypeEnum trajectory_type, yarp::dev::Nav2D::Map2DPath& waypoints)
 {
-    bool b = m_plannerThread->getCurrentPath(waypoints);
-    return b;
+    std::shared_ptr<const planner_snapshot> snapshot = m_plannerThread->getSnapshot();
+    if (!snapshot) return false;
+    waypoints = snapshot->remaining_path;
+    return true;
 }
 
 bool robotPathPlannerDev::getCurrentNavigationWaypoint(Map2DLocation& curr_waypoint)
 {
-    bool b = m_plannerThread->getCurrentWaypoint(curr_waypoint);
-    return b;
+    std::shared_ptr<const planner_snapshot> snapshot = m_plannerThread->getSnapshot();
+    if (!snapshot || snapshot->waypoint_valid == false) return false;
+    curr_waypoint = snapshot->current_waypoint;
+    return true;
 }
 
 bool robotPathPlannerDev::getCurrentNavigationMap(NavigationMapTypeEnum map_type, MapGrid2D& map)
 {
     if (map_type == NavigationMapTypeEnum::global_map)
     {
-        m_plannerThread->getCurrentMap(map);
+        std::shared_ptr<const planner_snapshot> snapshot = m_plannerThread->getSnapshot();
+        if (!snapshot || !snapshot->map) return false;
+        map = *snapshot->map;
         return true;
     }
     else if (map_type == NavigationMapTypeEnum::local_map)
@@ -266,6 +310,21 @@ bool robotPathPlannerDev::parse_respond_string(const yarp::os::Bottle& command,
             reply.addString("set_robot_radius failed");
         }
     }
+    if (command.get(0).asString() == "get_map_update")
+    {
+        //a client which sends the epoch and the version of its copy of the map receives only the tiles modified since then
+        std::string type = command.get(1).asString();
+        uint64_t client_epoch = (uint64_t)(command.get(2).asInt64());
+        uint64_t client_version = (uint64_t)(command.get(3).asInt64());
+        bool ret = false;
+        if      (type == "global") { ret = this->m_plannerThread->getMapUpdate(NavigationMapTypeEnum::global_map, client_epoch, client_version, reply); }
+        else if (type == "local")  { ret = this->m_plannerThread->getMapUpdate(NavigationMapTypeEnum::local_map, client_epoch, client_version, reply); }
+        if (ret == false)
+        {
+            reply.clear();
+            reply.addString("get_map_update failed");
+        }
+    }
     if (command.get(0).asString() == "get_robot_radius")
     {
         double value = 0;
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/dev/MapGrid2D.h>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "rollingWindowLayer.h"
+
+using namespace std;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace obstacle_layers;
+
+rolling_window_layer::rolling_window_layer()
+{
+    m_bounds.x_min = 0;
+    m_bounds.y_min = 0;
+    m_bounds.x_max = 0;
+    m_bounds.y_max = 0;
+    m_window_empty = true;
+    m_inflation_cells = -1;
+    m_full_clear_required = true;
+}
+
+void rolling_window_layer::invalidate()
+{
+    m_full_clear_required = true;
+}
+
+MapGrid2D::map_flags rolling_window_layer::flag_at(const XYCell& cell) const
+{
+    size_t x = cell.x;
+    size_t y = cell.y;
+    if (m_window_empty ||
+        x < m_bounds.x_min || x > m_bounds.x_max ||
+        y < m_bounds.y_min || y > m_bounds.y_max)
+    {
+        return MapGrid2D::MAP_CELL_FREE;
+    }
+    size_t w = m_bounds.x_max - m_bounds.x_min + 1;
+    uint8_t s = m_window[(y - m_bounds.y_min) * w + (x - m_bounds.x_min)];
+    if (s == STAMP_TEMPORARY) return MapGrid2D::MAP_CELL_TEMPORARY_OBSTACLE;
+    if (s == STAMP_ENLARGED)  return MapGrid2D::MAP_CELL_ENLARGED_OBSTACLE;
+    return MapGrid2D::MAP_CELL_FREE;
+}
+
+bool rolling_window_layer::window(window_bounds& bounds) const
+{
+    if (m_window_empty) return false;
+    bounds = m_bounds;
+    return true;
+}
+
+void rolling_window_layer::prepare(const MapGrid2D& reference_map, const std::vector<XYCell>& laser_cells, double inflation_radius)
+{
+    size_t map_w = reference_map.width();
+    size_t map_h = reference_map.height();
+
+    //the enlargement is a disc of cells. It contains the diamond-shaped enlargement performed by MapGrid2D::enlargeObstacles()
+    double resolution = 0;
+    reference_map.getResolution(resolution);
+    int inflation_cells = (resolution > 0 && inflation_radius > 0) ? (int)ceil(inflation_radius / resolution) : 0;
+    if (inflation_cells != m_inflation_cells)
+    {
+        m_inflation_cells = inflation_cells;
+        m_inflation_offsets.clear();
+        for (int dy = -inflation_cells; dy <= inflation_cells; dy++)
+            for (int dx = -inflation_cells; dx <= inflation_cells; dx++)
+            {
+                if ((dx != 0 || dy != 0) && dx * dx + dy * dy <= inflation_cells * inflation_cells)
+                {
+                    m_inflation_offsets.push_back(std::make_pair(dx, dy));
+                }
+            }
+    }
+
+    //the window is the bounding box of the scan, enlarged by the inflation radius
+    m_window_empty = true;
+    for (auto it = laser_cells.begin(); it != laser_cells.end(); it++)
+    {
+        if (it->x >= map_w || it->y >= map_h) continue;
+        if (m_window_empty)
+        {
+            m_bounds.x_min = m_bounds.x_max = it->x;
+            m_bounds.y_min = m_bounds.y_max = it->y;
+            m_window_empty = false;
+        }
+        m_bounds.x_min = std::min(m_bounds.x_min, it->x);
+        m_bounds.x_max = std::max(m_bounds.x_max, it->x);
+        m_bounds.y_min = std::min(m_bounds.y_min, it->y);
+        m_bounds.y_max = std::max(m_bounds.y_max, it->y);
+    }
+    m_new_marked_cells.clear();
+    if (m_window_empty) return;
+    size_t margin = (size_t)inflation_cells;
+    m_bounds.x_min = (m_bounds.x_min > margin) ? m_bounds.x_min - margin : 0;
+    m_bounds.y_min = (m_bounds.y_min > margin) ? m_bounds.y_min - margin : 0;
+    m_bounds.x_max = std::min(m_bounds.x_max + margin, map_w - 1);
+    m_bounds.y_max = std::min(m_bounds.y_max + margin, map_h - 1);
+
+    int w = (int)(m_bounds.x_max - m_bounds.x_min + 1);
+    int h = (int)(m_bounds.y_max - m_bounds.y_min + 1);
+    m_window.resize(w * h);
+    memset(m_window.data(), STAMP_FREE, m_window.size());
+    for (auto it = laser_cells.begin(); it != laser_cells.end(); it++)
+    {
+        if (it->x >= map_w || it->y >= map_h) continue;
+        int lx = (int)(it->x - m_bounds.x_min);
+        int ly = (int)(it->y - m_bounds.y_min);
+        m_window[ly * w + lx] = STAMP_TEMPORARY;
+        for (auto o = m_inflation_offsets.begin(); o != m_inflation_offsets.end(); o++)
+        {
+            int x = lx + o->first;
+            int y = ly + o->second;
+            if (x < 0 || y < 0 || x >= w || y >= h) continue;
+            uint8_t& s = m_window[y * w + x];
+            if (s == STAMP_FREE) s = STAMP_ENLARGED;
+        }
+    }
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+        {
+            if (m_window[y * w + x] != STAMP_FREE)
+            {
+                m_new_marked_cells.push_back(XYCell(x + m_bounds.x_min, y + m_bounds.y_min));
+            }
+        }
+}
+
+void rolling_window_layer::apply(MapGrid2D& obstacles_map, std::vector<XYCell>& changed_cells)
+{
+    changed_cells.clear();
+    if (m_full_clear_required)
+    {
+        //the content of the map is unknown: all the cells are checked once
+        for (size_t y = 0; y < obstacles_map.height(); y++)
+            for (size_t x = 0; x < obstacles_map.width(); x++)
+            {
+                XYCell c(x, y);
+                MapGrid2D::map_flags old_flag;
+                obstacles_map.getMapFlag(c, old_flag);
+                MapGrid2D::map_flags new_flag = flag_at(c);
+                if (old_flag != new_flag)
+                {
+                    obstacles_map.setMapFlag(c, new_flag);
+                    changed_cells.push_back(c);
+                }
+            }
+        m_full_clear_required = false;
+    }
+    else
+    {
+        //only the cells marked by the previous scan or by the current one may change
+        for (int pass = 0; pass < 2; pass++)
+        {
+            const std::vector<XYCell>& cells = (pass == 0) ? m_marked_cells : m_new_marked_cells;
+            for (auto it = cells.begin(); it != cells.end(); it++)
+            {
+                MapGrid2D::map_flags old_flag;
+                obstacles_map.getMapFlag(*it, old_flag);
+                MapGrid2D::map_flags new_flag = flag_at(*it);
+                if (old_flag != new_flag)
+                {
+                    obstacles_map.setMapFlag(*it, new_flag);
+                    changed_cells.push_back(*it);
+                }
+            }
+        }
+    }
+    m_marked_cells.swap(m_new_marked_cells);
+    m_new_marked_cells.clear();
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef ROLLING_WINDOW_LAYER_H
+#define ROLLING_WINDOW_LAYER_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <vector>
+#include <cstdint>
+
+//! namespace containing the layers which store the obstacles detected by the sensors
+namespace obstacle_layers
+{
+    //a rectangular portion of the map (bounds included)
+    struct window_bounds
+    {
+        size_t x_min;
+        size_t y_min;
+        size_t x_max;
+        size_t y_max;
+    };
+
+    /**
+    * A robot-centred obstacle layer which stores the cells detected by the last laser scan, enlarged by the robot radius.
+    * The layer is computed inside a rolling window which contains the current scan only (and it is therefore bounded by the
+    * laser range), and it is written into the map of the temporary obstacles by modifying only the cells marked by the
+    * previous scan or by the current one. The cost of an update is independent from the size of the map.
+    * The target map is expected to contain only MAP_CELL_FREE, MAP_CELL_TEMPORARY_OBSTACLE and MAP_CELL_ENLARGED_OBSTACLE cells.
+    * If it is modified by someone else (e.g. reloaded), invalidate() must be called: the next apply() will clear the whole map.
+    */
+    class rolling_window_layer
+    {
+        enum stamp_type
+        {
+            STAMP_FREE      = 0,
+            STAMP_ENLARGED  = 1,
+            STAMP_TEMPORARY = 2
+        };
+
+        std::vector<uint8_t>                  m_window;
+        window_bounds                         m_bounds;
+        bool                                  m_window_empty;
+        std::vector<yarp::dev::Nav2D::XYCell> m_marked_cells;
+        std::vector<yarp::dev::Nav2D::XYCell> m_new_marked_cells;
+        std::vector<std::pair<int, int> >     m_inflation_offsets;
+        int                                   m_inflation_cells;
+        bool                                  m_full_clear_required;
+
+        public:
+        rolling_window_layer();
+
+        /**
+        * Computes the layer corresponding to a new scan. No map is modified, so this method can be called
+        * outside the critical section which protects the map of the temporary obstacles.
+        * @param reference_map the map to which the laser cells refer (only its size and resolution are used)
+        * @param laser_cells the cells hit by the laser beams
+        * @param inflation_radius the radius (m) used to enlarge the laser cells
+        */
+        void prepare(const yarp::dev::Nav2D::MapGrid2D& reference_map, const std::vector<yarp::dev::Nav2D::XYCell>& laser_cells, double inflation_radius);
+
+        /**
+        * Writes the layer computed by the last call to prepare() into the map of the temporary obstacles.
+        * @param obstacles_map the map of the temporary obstacles
+        * @param changed_cells filled with the cells whose flag has been modified
+        */
+        void apply(yarp::dev::Nav2D::MapGrid2D& obstacles_map, std::vector<yarp::dev::Nav2D::XYCell>& changed_cells);
+
+        /**
+        * Forces the next call to apply() to clear the whole map.
+        */
+        void invalidate();
+
+        /**
+        * Returns the flag of a cell, according to the last scan
+        */
+        yarp::dev::Nav2D::MapGrid2D::map_flags flag_at(const yarp::dev::Nav2D::XYCell& cell) const;
+
+        /**
+        * @param bounds filled with the window of the last scan
+        * @return false if the last scan did not hit any cell
+        */
+        bool window(window_bounds& bounds) const;
+
+        /**
+        * Returns the cells marked by the last scan which has been applied
+        */
+        const std::vector<yarp::dev::Nav2D::XYCell>& marked_cells() const { return m_marked_cells; }
+    };
+};
+
+#endif
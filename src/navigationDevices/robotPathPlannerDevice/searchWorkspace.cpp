@@ -0,0 +1,260 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Time.h>
+#include <limits>
+#include <algorithm>
+#include <string.h>
+#include "searchWorkspace.h"
+
+using namespace std;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+
+/////////// search_control
+search_control::search_control()
+{
+    m_cancelled = false;
+    m_deadline = 0;
+}
+
+void search_control::start(double time_budget)
+{
+    m_cancelled = false;
+    m_deadline = (time_budget > 0) ? yarp::os::Time::now() + time_budget : 0;
+}
+
+bool search_control::is_expired() const
+{
+    return (m_deadline > 0 && yarp::os::Time::now() > m_deadline);
+}
+
+/////////// indexed_heap
+indexed_heap::indexed_heap()
+{
+    stats = nullptr;
+}
+
+void indexed_heap::resize(size_t number_of_cells)
+{
+    m_heap.clear();
+    m_position.assign(number_of_cells, INVALID_CELL_INDEX);
+}
+
+void indexed_heap::clear()
+{
+    //m_position is intentionally not cleared, see contains()
+    m_heap.clear();
+}
+
+bool indexed_heap::contains(cell_index_type cell) const
+{
+    cell_index_type pos = m_position[cell];
+    return (pos < m_heap.size() && m_heap[pos].cell == cell);
+}
+
+double indexed_heap::top_key() const
+{
+    if (m_heap.empty()) return std::numeric_limits<double>::infinity();
+    return m_heap.front().key;
+}
+
+cell_index_type indexed_heap::top() const
+{
+    return m_heap.front().cell;
+}
+
+cell_index_type indexed_heap::pop()
+{
+    cell_index_type cell = m_heap.front().cell;
+    heap_item last = m_heap.back();
+    m_heap.pop_back();
+    if (!m_heap.empty())
+    {
+        place(0, last);
+        sift_down(0);
+    }
+    m_position[cell] = INVALID_CELL_INDEX;
+    if (stats) stats->heap_pops++;
+    return cell;
+}
+
+void indexed_heap::push(cell_index_type cell, double key)
+{
+    heap_item item;
+    item.key = key;
+    item.cell = cell;
+    m_heap.push_back(item);
+    m_position[cell] = static_cast<cell_index_type>(m_heap.size() - 1);
+    sift_up(m_heap.size() - 1);
+    if (stats) stats->heap_pushes++;
+}
+
+void indexed_heap::decrease_key(cell_index_type cell, double key)
+{
+    size_t pos = m_position[cell];
+    if (key >= m_heap[pos].key) return;
+    m_heap[pos].key = key;
+    sift_up(pos);
+    if (stats) stats->heap_decreases++;
+}
+
+void indexed_heap::update(cell_index_type cell, double key)
+{
+    if (!contains(cell))
+    {
+        push(cell, key);
+        return;
+    }
+    size_t pos = m_position[cell];
+    double old_key = m_heap[pos].key;
+    m_heap[pos].key = key;
+    if (key < old_key) sift_up(pos);
+    else               sift_down(pos);
+}
+
+void indexed_heap::remove(cell_index_type cell)
+{
+    if (!contains(cell)) return;
+    size_t pos = m_position[cell];
+    heap_item last = m_heap.back();
+    m_heap.pop_back();
+    m_position[cell] = INVALID_CELL_INDEX;
+    if (pos < m_heap.size())
+    {
+        double old_key = m_heap[pos].key;
+        place(pos, last);
+        if (last.key < old_key) sift_up(pos);
+        else                    sift_down(pos);
+    }
+}
+
+void indexed_heap::place(size_t pos, const heap_item& item)
+{
+    m_heap[pos] = item;
+    m_position[item.cell] = static_cast<cell_index_type>(pos);
+}
+
+void indexed_heap::sift_up(size_t pos)
+{
+    heap_item item = m_heap[pos];
+    while (pos > 0)
+    {
+        size_t parent = (pos - 1) / 2;
+        if (m_heap[parent].key <= item.key) break;
+        place(pos, m_heap[parent]);
+        pos = parent;
+    }
+    place(pos, item);
+}
+
+void indexed_heap::sift_down(size_t pos)
+{
+    heap_item item = m_heap[pos];
+    size_t size = m_heap.size();
+    while (true)
+    {
+        size_t child = 2 * pos + 1;
+        if (child >= size) break;
+        if (child + 1 < size && m_heap[child + 1].key < m_heap[child].key) child++;
+        if (item.key <= m_heap[child].key) break;
+        place(pos, m_heap[child]);
+        pos = child;
+    }
+    place(pos, item);
+}
+
+/////////// search_workspace
+search_workspace::search_workspace()
+{
+    m_generation = 0;
+    m_width = 0;
+    m_height = 0;
+    control = nullptr;
+    open_set.stats = &stats;
+}
+
+void search_workspace::prepare(size_t width, size_t height)
+{
+    if (width != m_width || height != m_height)
+    {
+        m_width = width;
+        m_height = height;
+        node_type empty_node;
+        empty_node.g_score = std::numeric_limits<double>::infinity();
+        empty_node.came_from = INVALID_CELL_INDEX;
+        empty_node.generation = 0;
+        m_nodes.assign(width * height, empty_node);
+        m_closed_set.assign((width * height + 63) / 64, 0);
+        open_set.resize(width * height);
+        m_generation = 0;
+    }
+    else
+    {
+        memset(m_closed_set.data(), 0, m_closed_set.size() * sizeof(uint64_t));
+        open_set.clear();
+    }
+
+    m_generation++;
+    if (m_generation == 0)
+    {
+        //the generation counter wrapped around: all the stamps have to be invalidated once
+        for (auto it = m_nodes.begin(); it != m_nodes.end(); it++) it->generation = 0;
+        m_generation = 1;
+    }
+    stats.clear();
+}
+
+void search_workspace::clear_closed_set()
+{
+    memset(m_closed_set.data(), 0, m_closed_set.size() * sizeof(uint64_t));
+}
+
+double search_workspace::g_score(cell_index_type i) const
+{
+    if (m_nodes[i].generation != m_generation) return std::numeric_limits<double>::infinity();
+    return m_nodes[i].g_score;
+}
+
+cell_index_type search_workspace::came_from(cell_index_type i) const
+{
+    if (m_nodes[i].generation != m_generation) return INVALID_CELL_INDEX;
+    return m_nodes[i].came_from;
+}
+
+void search_workspace::set_node(cell_index_type i, double g_score, cell_index_type came_from)
+{
+    m_nodes[i].g_score = g_score;
+    m_nodes[i].came_from = came_from;
+    m_nodes[i].generation = m_generation;
+}
+
+bool search_workspace::reconstruct_path(cell_index_type start, cell_index_type goal, std::deque<XYCell>& path) const
+{
+    std::deque<XYCell> cells;
+    cell_index_type c = goal;
+    size_t max_length = m_width * m_height;
+    while (c != start)
+    {
+        if (c == INVALID_CELL_INDEX || cells.size() > max_length) return false;
+        cells.push_front(to_cell(c));
+        c = came_from(c);
+    }
+    path.insert(path.end(), cells.begin(), cells.end());
+    return true;
+}
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef SEARCH_WORKSPACE_H
+#define SEARCH_WORKSPACE_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+//! namespace containing the data structures shared by the grid search algorithms
+namespace planner_search
+{
+    //index of a cell inside a flat (row-major) array of w*h cells
+    typedef uint32_t cell_index_type;
+
+    const cell_index_type INVALID_CELL_INDEX = 0xFFFFFFFF;
+
+    //statistics collected during a search, useful to compare the different planning engines
+    struct search_stats
+    {
+        size_t expanded_nodes;
+        size_t heap_pushes;
+        size_t heap_pops;
+        size_t heap_decreases;
+
+        search_stats() { clear(); }
+        void clear() { expanded_nodes = 0; heap_pushes = 0; heap_pops = 0; heap_decreases = 0; }
+    };
+
+    /**
+    * A binary min-heap of cell indices, ordered by a scalar key, which supports the decrease-key operation.
+    * The position of every cell inside the heap is stored in a lookup table indexed by cell, so that
+    * contains() and decrease_key() are O(1) and O(log n) respectively. The lookup table is never cleared:
+    * an entry is considered valid only if the heap slot it points to stores the same cell.
+    */
+    class indexed_heap
+    {
+        struct heap_item
+        {
+            double          key;
+            cell_index_type cell;
+        };
+
+        std::vector<heap_item>       m_heap;
+        std::vector<cell_index_type> m_position;
+
+        public:
+        search_stats* stats;
+
+        indexed_heap();
+        void   resize(size_t number_of_cells);
+        void   clear();
+        bool   empty() const { return m_heap.empty(); }
+        size_t size() const { return m_heap.size(); }
+        bool   contains(cell_index_type cell) const;
+        double top_key() const;
+        cell_index_type top() const;
+        cell_index_type pop();
+        void   push(cell_index_type cell, double key);
+        void   decrease_key(cell_index_type cell, double key);
+        void   update(cell_index_type cell, double key);
+        void   remove(cell_index_type cell);
+
+        private:
+        void   sift_up(size_t pos);
+        void   sift_down(size_t pos);
+        void   place(size_t pos, const heap_item& item);
+    };
+
+    /**
+    * Allows to interrupt a search, either on request from another thread or when the time budget assigned to the search expires.
+    * The search algorithms poll should_stop() periodically (every SEARCH_CONTROL_CHECK_PERIOD expanded nodes).
+    */
+    class search_control
+    {
+        std::atomic<bool> m_cancelled;
+        double            m_deadline;
+
+        public:
+        search_control();
+
+        /**
+        * Prepares the object for a new search.
+        * @param time_budget the maximum duration of the search (seconds). A value <= 0 means no limit.
+        */
+        void start(double time_budget);
+        void cancel() { m_cancelled = true; }
+        bool is_cancelled() const { return m_cancelled; }
+        bool is_expired() const;
+        bool should_stop() const { return is_cancelled() || is_expired(); }
+    };
+
+    const size_t SEARCH_CONTROL_CHECK_PERIOD = 1024;
+
+    /**
+    * The memory required by a grid search (g-score, parent, open set, closed set) stored in flat arrays indexed by cell.
+    * The arrays are allocated once and reused across searches. Per-node data is generation-stamped: a node whose
+    * stamp differs from the current generation is considered untouched, so starting a new search does not require
+    * clearing the whole array. The closed set is a bitset, which is cleared with a memset (w*h/8 bytes).
+    */
+    class search_workspace
+    {
+        struct node_type
+        {
+            double          g_score;
+            cell_index_type came_from;
+            uint32_t        generation;
+        };
+
+        std::vector<node_type> m_nodes;
+        std::vector<uint64_t>  m_closed_set;
+        uint32_t               m_generation;
+        size_t                 m_width;
+        size_t                 m_height;
+
+        public:
+        indexed_heap           open_set;
+        search_stats           stats;
+        const search_control*  control;
+
+        search_workspace();
+
+        /**
+        * Prepares the workspace for a new search on a map of the given size.
+        * Memory is reallocated only if the map size changed since the previous search.
+        * @param width the width of the map (cells)
+        * @param height the height of the map (cells)
+        */
+        void prepare(size_t width, size_t height);
+
+        size_t width() const { return m_width; }
+        size_t height() const { return m_height; }
+
+        cell_index_type to_index(size_t x, size_t y) const { return static_cast<cell_index_type>(y * m_width + x); }
+        cell_index_type to_index(const yarp::dev::Nav2D::XYCell& c) const { return to_index(c.x, c.y); }
+        yarp::dev::Nav2D::XYCell to_cell(cell_index_type i) const { return yarp::dev::Nav2D::XYCell(i % m_width, i / m_width); }
+
+        bool   is_visited(cell_index_type i) const { return m_nodes[i].generation == m_generation; }
+        double g_score(cell_index_type i) const;
+        cell_index_type came_from(cell_index_type i) const;
+        void   set_node(cell_index_type i, double g_score, cell_index_type came_from);
+
+        bool   is_closed(cell_index_type i) const { return (m_closed_set[i >> 6] >> (i & 63)) & 1; }
+        void   set_closed(cell_index_type i) { m_closed_set[i >> 6] |= (uint64_t(1) << (i & 63)); }
+
+        /**
+        * Empties the closed set, keeping the g-scores, the parents and the open set. Used by the searches which
+        * perform several passes on the same workspace (see araStar_algorithm).
+        */
+        void   clear_closed_set();
+
+        /**
+        * Returns true if the search has to be interrupted (see search_control). The check is actually performed
+        * only once every SEARCH_CONTROL_CHECK_PERIOD expanded nodes.
+        */
+        bool   must_stop() const { return control && (stats.expanded_nodes % SEARCH_CONTROL_CHECK_PERIOD) == 0 && control->should_stop(); }
+
+        /**
+        * Follows the came_from chain from the goal back to the start and stores the resulting sequence of cells.
+        * The start cell is not included in the output path, the goal cell is included.
+        * @return false if the chain is broken
+        */
+        bool   reconstruct_path(cell_index_type start, cell_index_type goal, std::deque<yarp::dev::Nav2D::XYCell>& path) const;
+    };
+};
+
+#endif
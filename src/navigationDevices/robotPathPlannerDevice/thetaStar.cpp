@@ -0,0 +1,208 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <stdlib.h>
+#include <math.h>
+#include <limits>
+#include "thetaStar.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+using namespace planner_search;
+
+YARP_LOG_COMPONENT(PATHPLAN_THETASTAR, "navigation.devices.robotPathPlanner.thetaStar")
+
+namespace
+{
+    const int neighbor_dx[8] = { 0,  0, 1, -1,  1,  1, -1, -1 };
+    const int neighbor_dy[8] = { 1, -1, 0,  0,  1, -1,  1, -1 };
+    //the bit of each move inside planning_grid::neighbor_mask()
+    const unsigned int neighbor_bit[8] = { 1u << 7, 1u << 1, 1u << 5, 1u << 3, 1u << 8, 1u << 2, 1u << 6, 1u << 0 };
+
+    //the euclidean distance between two cells, scaled as the 10/14 costs of the grid searches
+    inline double distance(int x1, int y1, int x2, int y2)
+    {
+        double dx = x1 - x2;
+        double dy = y1 - y2;
+        return 10.0 * sqrt(dx * dx + dy * dy);
+    }
+
+    //calls func(x,y) for each cell of the Bresenham line from src to dst, src excluded. Stops (returning false) if func returns false.
+    template <typename F>
+    bool walk_line(XYCell src, XYCell dst, F func)
+    {
+        int x = (int)src.x;
+        int y = (int)src.y;
+        int tx = (int)dst.x;
+        int ty = (int)dst.y;
+        int dx = abs(tx - x);
+        int dy = abs(ty - y);
+        int sx = (x < tx) ? 1 : -1;
+        int sy = (y < ty) ? 1 : -1;
+        int err = dx - dy;
+        while (x != tx || y != ty)
+        {
+            int e2 = err * 2;
+            if (e2 > -dy) { err -= dy; x += sx; }
+            if (e2 < dx)  { err += dx; y += sy; }
+            if (func(x, y) == false) return false;
+        }
+        return true;
+    }
+
+    bool segment_free(const map_grid_view& grid, XYCell src, XYCell dst)
+    {
+        return walk_line(src, dst, [&grid](int x, int y) { return grid.is_free(x, y); });
+    }
+
+    //the packed grid tests together the cells of the segment which lie on the same row
+    bool segment_free(const planning_grid& grid, XYCell src, XYCell dst)
+    {
+        return grid.line_of_sight(src, dst);
+    }
+
+    //the search, performed either on the map or on its packed copy (see planning_grid)
+    template <typename Grid>
+    bool theta_search(const Grid& grid, XYCell start, XYCell goal, std::deque<XYCell>& waypoints, search_workspace& ws)
+    {
+        size_t w = grid.width();
+        size_t h = grid.height();
+
+        //checks that start and goal cells are inside the grid map
+        if (start.x >= w || goal.x >= w) return false;
+        if (start.y >= h || goal.y >= h) return false;
+
+        //an occupied goal can never be reached, there is no need to explore the whole map to find it out
+        if (grid.is_free((int)goal.x, (int)goal.y) == false) return false;
+
+        ws.prepare(w, h);
+        cell_index_type start_index = ws.to_index(start);
+        cell_index_type goal_index = ws.to_index(goal);
+        int gx = (int)goal.x;
+        int gy = (int)goal.y;
+
+        //the parent of the start cell is the start cell itself
+        ws.set_node(start_index, 0, start_index);
+        ws.open_set.push(start_index, distance((int)start.x, (int)start.y, gx, gy));
+
+        while (!ws.open_set.empty())
+        {
+            cell_index_type curr = ws.open_set.pop();
+            int cx = (int)(curr % w);
+            int cy = (int)(curr / w);
+
+            //lazy evaluation: the node was inserted assuming that it is in line of sight with the parent of its predecessor.
+            //If this is not true, the best parent is chosen among the already expanded neighbors, as in a standard grid search.
+            cell_index_type parent = ws.came_from(curr);
+            if (parent != curr && segment_free(grid, ws.to_cell(parent), XYCell(cx, cy)) == false)
+            {
+                double best_g = std::numeric_limits<double>::infinity();
+                cell_index_type best_parent = INVALID_CELL_INDEX;
+                for (size_t i = 0; i < 8; i++)
+                {
+                    int nx = cx + neighbor_dx[i];
+                    int ny = cy + neighbor_dy[i];
+                    if (nx < 0 || ny < 0 || nx >= (int)w || ny >= (int)h) continue;
+                    cell_index_type neighbor = ws.to_index(nx, ny);
+                    if (ws.is_closed(neighbor) == false) continue;
+                    double g = ws.g_score(neighbor) + distance(cx, cy, nx, ny);
+                    if (g < best_g) { best_g = g; best_parent = neighbor; }
+                }
+                if (best_parent == INVALID_CELL_INDEX)
+                {
+                    yCError(PATHPLAN_THETASTAR) << "the expanded node has no expanded neighbors";
+                    return false;
+                }
+                ws.set_node(curr, best_g, best_parent);
+                parent = best_parent;
+            }
+
+            if (curr == goal_index)
+            {
+                return ws.reconstruct_path(start_index, goal_index, waypoints);
+            }
+
+            ws.set_closed(curr);
+            ws.stats.expanded_nodes++;
+            if (ws.must_stop())
+            {
+                yCDebug(PATHPLAN_THETASTAR) << "search interrupted after" << ws.stats.expanded_nodes << "expansions";
+                return false;
+            }
+
+            //the successors are connected to the parent of the current node (path 2 of Theta*), the line of sight is checked when they are expanded
+            int px = (int)(parent % w);
+            int py = (int)(parent / w);
+            double parent_g = ws.g_score(parent);
+            unsigned int free_neighbors = grid.neighbor_mask(cx, cy);
+
+            for (size_t i = 0; i < 8; i++)
+            {
+                int nx = cx + neighbor_dx[i];
+                int ny = cy + neighbor_dy[i];
+                if ((free_neighbors & neighbor_bit[i]) == 0) continue;
+
+                cell_index_type neighbor = ws.to_index(nx, ny);
+                if (ws.is_closed(neighbor)) continue;
+
+                double tentative_g_score = parent_g + distance(px, py, nx, ny);
+                if (tentative_g_score < ws.g_score(neighbor))
+                {
+                    ws.set_node(neighbor, tentative_g_score, parent);
+                    double f_score = tentative_g_score + distance(nx, ny, gx, gy);
+                    if (ws.open_set.contains(neighbor)) ws.open_set.decrease_key(neighbor, f_score);
+                    else                                ws.open_set.push(neighbor, f_score);
+                }
+            }
+        }
+
+        //no path found
+        yCDebug(PATHPLAN_THETASTAR) << "no path found after" << ws.stats.expanded_nodes << "expansions";
+        return false;
+    }
+}
+
+bool thetaStar_algorithm::line_of_sight(const MapGrid2D& map, XYCell src, XYCell dst)
+{
+    return walk_line(src, dst, [&map](int x, int y) { return map.isFree(XYCell(x, y)); });
+}
+
+void thetaStar_algorithm::expand_waypoints(XYCell start, const std::deque<XYCell>& waypoints, std::deque<XYCell>& path)
+{
+    XYCell prev = start;
+    for (auto it = waypoints.begin(); it != waypoints.end(); it++)
+    {
+        walk_line(prev, *it, [&path](int x, int y) { path.push_back(XYCell(x, y)); return true; });
+        prev = *it;
+    }
+}
+
+bool thetaStar_algorithm::find_theta_path(MapGrid2D& map, XYCell start, XYCell goal, std::deque<XYCell>& waypoints, search_workspace& ws)
+{
+    return theta_search(map_grid_view(map), start, goal, waypoints, ws);
+}
+
+bool thetaStar_algorithm::find_theta_path(const planning_grid& grid, XYCell start, XYCell goal, std::deque<XYCell>& waypoints, search_workspace& ws)
+{
+    return theta_search(grid, start, goal, waypoints, ws);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+#ifndef THETA_STAR_H
+#define THETA_STAR_H
+
+#include <yarp/dev/MapGrid2D.h>
+
+#include <deque>
+#include "searchWorkspace.h"
+#include "planningGrid.h"
+
+//! namespace containing an implementation of the Lazy Theta* any-angle search algorithm (Nash, Koenig and Tovey, 2010)
+namespace thetaStar_algorithm
+{
+    /**
+    * This method computes (if exists) an any-angle path required to go from a start cell to a goal cell.
+    * The parent of a node is not restricted to its grid neighbors: during the search each node is connected to the
+    * parent of its predecessor if the two cells are in line of sight. The line of sight is checked lazily, only when a node is expanded.
+    * Move costs are euclidean distances, scaled by 10 to be comparable with the costs of the other grid searches.
+    * @param map the gridmap containing the obstacles
+    * @param start the start cell(x,y)
+    * @param goal the arrival cell(x,y)
+    * @param waypoints the vertices of the computed polyline, i.e. the cells where the direction changes. The start cell is not included, the goal cell is included.
+    * @param workspace the search memory. After the call, workspace.stats contains the statistics of the search.
+    * @return true if the path exists, false if no valid path has been found
+    */
+    bool find_theta_path(yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& waypoints, planner_search::search_workspace& workspace);
+
+    /**
+    * Same as above, reading the obstacles from the packed copy of the map (see planner_search::planning_grid::line_of_sight()).
+    * @param grid the traversability of the map, 1 bit per cell
+    */
+    bool find_theta_path(const planner_search::planning_grid& grid, yarp::dev::Nav2D::XYCell start, yarp::dev::Nav2D::XYCell goal, std::deque<yarp::dev::Nav2D::XYCell>& waypoints, planner_search::search_workspace& workspace);
+
+    /**
+    * Returns true if the straight line which connects src with dst does not contain any obstacle.
+    * The cells are traversed with the Bresenham algorithm, as map_utilites::checkStraightLine() does, but the src cell is not checked
+    * (it is always a cell already reached by the search, or the start cell, which may lie inside an enlarged obstacle).
+    */
+    bool line_of_sight(const yarp::dev::Nav2D::MapGrid2D& map, yarp::dev::Nav2D::XYCell src, yarp::dev::Nav2D::XYCell dst);
+
+    /**
+    * Converts a list of waypoints into the sequence of all the cells traversed by the polyline, following each segment with the Bresenham algorithm.
+    * @param start the start cell of the polyline (not included in the output)
+    * @param waypoints the vertices of the polyline, as returned by find_theta_path()
+    * @param path the sequence of traversed cells, appended to the given deque
+    */
+    void expand_waypoints(yarp::dev::Nav2D::XYCell start, const std::deque<yarp::dev::Nav2D::XYCell>& waypoints, std::deque<yarp::dev::Nav2D::XYCell>& path);
+};
+
+#endif
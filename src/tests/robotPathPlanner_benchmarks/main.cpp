@@ -0,0 +1,388 @@
+/*
+ * Copyright (C)2011  Department of Robotics Brain and Cognitive Sciences - Istituto Italiano di Tecnologia
+ * Author: Marco Randazzo
+ * email:  marco.randazzo@iit.it
+ * website: www.robotcub.org
+ * Permission is granted to copy, distribute, and/or modify this program
+ * under the terms of the GNU General Public License, version 2 or any
+ * later version published by the Free Software Foundation.
+ *
+ * A copy of the license can be found at
+ * http://www.robotcub.org/icub/license/gpl.txt
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General
+ * Public License for more details
+*/
+
+/*
+* Offline benchmarks of the robotPathPlanner algorithms, on the maps shipped in app/mapsExample.
+* No yarpserver is required. For each map a fixed (seeded) set of start/goal pairs is generated and every
+* planning stage (obstacles enlargement, search, path simplification...) is timed. The results are written
+* in CSV format, one line for each stage, with the columns:
+* map, stage, algorithm, pair, success, time_ms, expanded_nodes, path_cells, path_length_m
+* expanded_nodes is -1 when the algorithm does not collect this statistic, pair is -1 for the per-map stages.
+* For the simplify_path stage and for the theta_star searches, path_cells is the number of waypoints.
+* The *_packed algorithms perform the same search of the algorithm they are named after, on the packed copy of the map (planner_search::planning_grid).
+* astar_multires is the coarse-to-fine search on a pyramid of PYRAMID_LEVELS levels, refined in a corridor PYRAMID_CORRIDOR_WIDTH wide.
+* ara_star_first_pass reports the first (bounded-suboptimal) path found by the anytime search, ara_star the complete search.
+* The CSV is written on the standard output, unless --output is given (recommended, since the log is written there too).
+*
+* Usage: robotPathPlanner_benchmarks [--maps_dir <dir>] [--maps "(map_isaac.map map_test.map)"] [--pairs <n>] [--seed <n>] [--robot_radius <m>] [--output <file.csv>]
+*/
+
+#include <yarp/os/Property.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Log.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/dev/MapGrid2D.h>
+#include <yarp/dev/Map2DPath.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <math.h>
+#include "map.h"
+#include "aStar.h"
+#include "aStarIndexed.h"
+#include "jps.h"
+#include "dStarLite.h"
+#include "hpaStar.h"
+#include "thetaStar.h"
+#include "araStar.h"
+#include "multiResolution.h"
+#include "distanceTransform.h"
+#include "navigationFunction.h"
+
+using namespace std;
+using namespace yarp::os;
+using namespace yarp::dev;
+using namespace yarp::dev::Nav2D;
+
+YARP_LOG_COMPONENT(PATHPLAN_BENCHMARKS, "navigation.tests.robotPathPlanner_benchmarks")
+
+namespace
+{
+    //the configuration of the coarse-to-fine search (see the pyramid_levels and pyramid_corridor_width parameters of robotPathPlanner)
+    const size_t PYRAMID_LEVELS = 3;
+    const double PYRAMID_CORRIDOR_WIDTH = 1.0; //m
+
+    //the yarp clock is not used, since it may be driven by the network
+    double now()
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    //the length (m) of the polyline which starts from the start cell and passes through all the cells of the path
+    double path_length(XYCell start, const std::deque<XYCell>& path, double resolution)
+    {
+        double length = 0;
+        XYCell prev = start;
+        for (auto it = path.begin(); it != path.end(); it++)
+        {
+            double dx = (double)it->x - (double)prev.x;
+            double dy = (double)it->y - (double)prev.y;
+            length += sqrt(dx * dx + dy * dy);
+            prev = *it;
+        }
+        return length * resolution;
+    }
+
+    //writes the CSV report and collects the totals printed at the end of the run
+    class benchmark_report
+    {
+        std::ostream&                                   m_out;
+        std::map<std::string, std::pair<double, size_t> > m_totals;
+
+        public:
+        benchmark_report(std::ostream& out) : m_out(out)
+        {
+            m_out << "map,stage,algorithm,pair,success,time_ms,expanded_nodes,path_cells,path_length_m" << std::endl;
+        }
+
+        void add(const std::string& map, const std::string& stage, const std::string& algorithm, int pair,
+                 bool success, double time, long expanded_nodes = -1, size_t path_cells = 0, double length = 0)
+        {
+            m_out << map << "," << stage << "," << algorithm << "," << pair << "," << (success ? 1 : 0) << ","
+                  << time * 1000.0 << "," << expanded_nodes << "," << path_cells << "," << length << std::endl;
+            std::pair<double, size_t>& total = m_totals[stage + " " + algorithm];
+            total.first += time;
+            total.second++;
+        }
+
+        void print_totals(std::ostream& out) const
+        {
+            out << "mean time (ms) of each stage:" << std::endl;
+            for (auto it = m_totals.begin(); it != m_totals.end(); it++)
+            {
+                out << "  " << it->first << ": " << it->second.first * 1000.0 / it->second.second << std::endl;
+            }
+        }
+    };
+
+    struct benchmark_options
+    {
+        std::string              maps_dir;
+        std::vector<std::string> maps;
+        size_t                   pairs;
+        unsigned int             seed;
+        double                   robot_radius;
+    };
+
+    //reports the search and (for the grid searches) the simplification of the computed path
+    void report_search(benchmark_report& report, MapGrid2D& map, int pair, const std::string& algorithm, XYCell start,
+                       bool found, double time, long expanded_nodes, const std::deque<XYCell>& path, bool simplify)
+    {
+        const std::string name = map.getMapName();
+        double resolution = 0;
+        map.getResolution(resolution);
+        report.add(name, "search", algorithm, pair, found, time, expanded_nodes, path.size(), path_length(start, path, resolution));
+        if (!found || !simplify) return;
+
+        Map2DPath locations;
+        for (auto it = path.begin(); it != path.end(); it++) locations.push_back(map.toLocation(*it));
+        Map2DPath simplified;
+        double t1 = now();
+        bool b = map_utilites::simplifyPath(map, locations, simplified);
+        double t2 = now();
+        std::deque<XYCell> waypoints;
+        for (auto it = simplified.begin(); it != simplified.end(); it++) waypoints.push_back(map.toXYCell(*it));
+        report.add(name, "simplify_path", algorithm, pair, b, t2 - t1, -1, waypoints.size(), path_length(start, waypoints, resolution));
+    }
+
+    bool run_map_benchmark(benchmark_report& report, const benchmark_options& options, const std::string& map_file)
+    {
+        //per-map stages
+        MapGrid2D map;
+        double t1 = now();
+        bool b = map.loadFromFile(options.maps_dir + "/" + map_file);
+        double t2 = now();
+        if (!b)
+        {
+            yCError(PATHPLAN_BENCHMARKS) << "Unable to load map" << map_file << "from" << options.maps_dir;
+            return false;
+        }
+        const std::string name = map.getMapName();
+        double resolution = 0;
+        map.getResolution(resolution);
+        report.add(name, "load", "", -1, true, t2 - t1);
+
+        MapGrid2D enlarged_map = map;
+        t1 = now();
+        enlarged_map.enlargeObstacles(options.robot_radius);
+        t2 = now();
+        report.add(name, "enlarge_obstacles", "", -1, true, t2 - t1);
+
+        distanceTransform_algorithm::clearance_map clearance;
+        t1 = now();
+        clearance.update(map);
+        t2 = now();
+        report.add(name, "distance_transform", "", -1, true, t2 - t1);
+
+        MapGrid2D planning_map = map;
+        t1 = now();
+        clearance.inflate(planning_map, options.robot_radius);
+        t2 = now();
+        report.add(name, "inflate", "", -1, true, t2 - t1);
+
+        hpaStar_algorithm::abstract_graph graph;
+        t1 = now();
+        b = graph.build(planning_map, hpaStar_algorithm::DEFAULT_CLUSTER_SIZE);
+        t2 = now();
+        report.add(name, "build_abstract_graph", "hpa_star", -1, b, t2 - t1);
+
+        std::shared_ptr<planner_search::planning_grid> grid = std::make_shared<planner_search::planning_grid>();
+        t1 = now();
+        grid->build(planning_map);
+        t2 = now();
+        report.add(name, "build_planning_grid", "", -1, true, t2 - t1);
+
+        multiResolution_algorithm::planning_pyramid pyramid;
+        t1 = now();
+        pyramid.build(grid, PYRAMID_LEVELS);
+        t2 = now();
+        report.add(name, "build_pyramid", "astar_multires", -1, true, t2 - t1);
+        size_t corridor_radius = (resolution > 0) ? (size_t)(ceil(PYRAMID_CORRIDOR_WIDTH / 2 / resolution)) : 0;
+
+        //the start/goal pairs are chosen among the free cells. std::uniform_int_distribution is not used, since
+        //its output is implementation-defined: the pairs have to be the same on every platform
+        std::vector<XYCell> free_cells;
+        for (size_t y = 0; y < planning_map.height(); y++)
+            for (size_t x = 0; x < planning_map.width(); x++)
+                if (planning_map.isFree(XYCell(x, y))) free_cells.push_back(XYCell(x, y));
+        if (free_cells.empty())
+        {
+            yCError(PATHPLAN_BENCHMARKS) << "Map" << name << "does not contain free cells";
+            return false;
+        }
+        std::mt19937 rng(options.seed);
+
+        planner_search::search_workspace workspace;
+        for (size_t i = 0; i < options.pairs; i++)
+        {
+            int pair = (int)i;
+            XYCell start = free_cells[rng() % free_cells.size()];
+            XYCell goal = free_cells[rng() % free_cells.size()];
+            std::deque<XYCell> path;
+
+            path.clear();
+            t1 = now();
+            b = aStar_algorithm::find_astar_path(planning_map, start, goal, path);
+            t2 = now();
+            report_search(report, planning_map, pair, "astar_legacy", start, b, t2 - t1, -1, path, true);
+
+            path.clear();
+            t1 = now();
+            b = aStarIndexed_algorithm::find_astar_path(planning_map, start, goal, path, workspace);
+            t2 = now();
+            report_search(report, planning_map, pair, "astar", start, b, t2 - t1, (long)workspace.stats.expanded_nodes, path, true);
+
+            path.clear();
+            t1 = now();
+            b = jps_algorithm::find_jps_path(planning_map, start, goal, path, workspace);
+            t2 = now();
+            report_search(report, planning_map, pair, "jps", start, b, t2 - t1, (long)workspace.stats.expanded_nodes, path, true);
+
+            //the same searches, on the packed copy of the map
+            path.clear();
+            t1 = now();
+            b = aStarIndexed_algorithm::find_astar_path(*grid, start, goal, path, workspace, nullptr);
+            t2 = now();
+            report_search(report, planning_map, pair, "astar_packed", start, b, t2 - t1, (long)workspace.stats.expanded_nodes, path, false);
+
+            path.clear();
+            t1 = now();
+            b = jps_algorithm::find_jps_path(*grid, start, goal, path, workspace);
+            t2 = now();
+            report_search(report, planning_map, pair, "jps_packed", start, b, t2 - t1, (long)workspace.stats.expanded_nodes, path, false);
+
+            path.clear();
+            t1 = now();
+            b = multiResolution_algorithm::find_multiresolution_path(pyramid, start, goal, path, workspace, nullptr, corridor_radius);
+            t2 = now();
+            report_search(report, planning_map, pair, "astar_multires", start, b, t2 - t1, (long)workspace.stats.expanded_nodes, path, true);
+
+            //the anytime search: the time (and the path) of the first pass, then the complete search down to epsilon = 1
+            path.clear();
+            std::deque<XYCell> first_path;
+            double first_time = 0;
+            size_t first_expanded_nodes = 0;
+            double epsilon = 0;
+            t1 = now();
+            b = araStar_algorithm::find_ara_path(*grid, start, goal, path, workspace, nullptr, araStar_algorithm::ara_parameters(), epsilon,
+                [&](const std::deque<XYCell>& p, double)
+                {
+                    if (!first_path.empty()) return;
+                    first_time = now() - t1;
+                    first_expanded_nodes = workspace.stats.expanded_nodes;
+                    first_path = p;
+                });
+            t2 = now();
+            report_search(report, planning_map, pair, "ara_star_first_pass", start, b, first_time, (long)first_expanded_nodes, first_path, false);
+            report_search(report, planning_map, pair, "ara_star", start, b, t2 - t1, (long)workspace.stats.expanded_nodes, path, true);
+
+            path.clear();
+            dStarLite_algorithm::dstar_lite_planner dstar;
+            t1 = now();
+            b = dstar.initialize(planning_map, goal) && dstar.compute_path(start, path);
+            t2 = now();
+            report_search(report, planning_map, pair, "dstar_lite", start, b, t2 - t1, (long)dstar.stats.expanded_nodes, path, true);
+
+            path.clear();
+            t1 = now();
+            b = hpaStar_algorithm::find_hpa_path(graph, planning_map, start, goal, path);
+            t2 = now();
+            report_search(report, planning_map, pair, "hpa_star", start, b, t2 - t1, -1, path, true);
+
+            //the any-angle search does not need the simplification: the length is the one of the polyline
+            std::deque<XYCell> waypoints;
+            t1 = now();
+            b = thetaStar_algorithm::find_theta_path(planning_map, start, goal, waypoints, workspace);
+            t2 = now();
+            report.add(name, "search", "theta_star", pair, b, t2 - t1, (long)workspace.stats.expanded_nodes, waypoints.size(), path_length(start, waypoints, resolution));
+
+            waypoints.clear();
+            t1 = now();
+            b = thetaStar_algorithm::find_theta_path(*grid, start, goal, waypoints, workspace);
+            t2 = now();
+            report.add(name, "search", "theta_star_packed", pair, b, t2 - t1, (long)workspace.stats.expanded_nodes, waypoints.size(), path_length(start, waypoints, resolution));
+
+            navigationFunction_algorithm::cost_to_go_field field;
+            t1 = now();
+            b = field.compute(planning_map, goal, options.robot_radius, nullptr, workspace);
+            t2 = now();
+            report.add(name, "build_navigation_function", "navigation_function", pair, b, t2 - t1, (long)workspace.stats.expanded_nodes);
+            if (b)
+            {
+                path.clear();
+                t1 = now();
+                b = field.extract_path(planning_map, start, path);
+                t2 = now();
+                report_search(report, planning_map, pair, "navigation_function", start, b, t2 - t1, -1, path, false);
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Property p;
+    p.fromCommand(argc, argv);
+    if (p.check("help"))
+    {
+        yInfo("Usage: robotPathPlanner_benchmarks [--maps_dir <dir>] [--maps \"(map_isaac.map map_test.map)\"] [--pairs <n>] [--seed <n>] [--robot_radius <m>] [--output <file.csv>]");
+        return 0;
+    }
+
+    benchmark_options options;
+    options.maps_dir = BENCHMARK_MAPS_DIR;
+    options.pairs = 20;
+    options.seed = 1;
+    options.robot_radius = 0.3;
+    if (p.check("maps_dir"))     { options.maps_dir = p.find("maps_dir").asString(); }
+    if (p.check("pairs"))        { options.pairs = (size_t)p.find("pairs").asInt(); }
+    if (p.check("seed"))         { options.seed = (unsigned int)p.find("seed").asInt(); }
+    if (p.check("robot_radius")) { options.robot_radius = p.find("robot_radius").asDouble(); }
+    Bottle* maps = p.find("maps").asList();
+    if (maps)
+    {
+        for (size_t i = 0; i < maps->size(); i++) options.maps.push_back(maps->get(i).asString());
+    }
+    else if (p.check("maps"))
+    {
+        options.maps.push_back(p.find("maps").asString());
+    }
+    else
+    {
+        options.maps.push_back("map_isaac.map");
+        options.maps.push_back("map_test.map");
+        options.maps.push_back("map_test2.map");
+    }
+
+    std::ofstream file;
+    if (p.check("output"))
+    {
+        file.open(p.find("output").asString().c_str());
+        if (!file.is_open())
+        {
+            yCError(PATHPLAN_BENCHMARKS) << "Unable to open the output file" << p.find("output").asString();
+            return 1;
+        }
+    }
+    benchmark_report report(file.is_open() ? file : std::cout);
+
+    bool ok = true;
+    for (auto it = options.maps.begin(); it != options.maps.end(); it++)
+    {
+        ok &= run_map_benchmark(report, options, *it);
+    }
+    report.print_totals(std::cerr);
+    return ok ? 0 : 1;
+}